@@ -56,7 +56,7 @@ main() {
     // To cater to a large audience however; the https/http server
     // both do not really care for whatever the layer (`behaviour` on
     // the server instance) is, all it has to do is implement an
-    // `handle(http_request, std::function<void(http_response &&)>
+    // `handle(http_request &&, rite::basic_task<void(http_response &&)>
     // &&) -> void` function.
     std::shared_ptr<rite::http::layer> lyr = std::make_shared<rite::http::layer>();
 
@@ -78,35 +78,18 @@ main() {
             }
 
 
-            if (std::filesystem::exists(file)) {
+            if (auto body = rite::http::file_body::open(file)) {
                 http_response response{};
 
                 response.set_status_code(http_status_code::eOk);
 
-                request.set_context<std::FILE *>(std::fopen(file.c_str(), "rb"));
                 auto content_type = guess_content_type(file);
                 response.set_header("Content-Type", content_type.value_or("application/octet-stream"));
 
-                // This is only required for HTTP/1.1. HTTP/2 has a
-                // built in way to terminate streams without hinting
-                // at the length.
-                if(request.version_ == http_version::HTTP_1_1) {
-                    response.set_content_length(std::filesystem::file_size(file));
-                }
-
-                response.event(http_response::event::chunk, [&](http_response &response) {
-                    std::unique_ptr<std::byte[]> buffer = std::make_unique_for_overwrite<std::byte[]>(16384);
-
-                    auto &fstream = request.context<std::FILE *>().value().get();
-                    auto  num = std::fread((void *)buffer.get(), 1, 16384, fstream);
-
-                    rite::buffer buf(std::move(buffer), num, num < 16384);
-                    if (num < 16384) {
-                        std::fclose(fstream);
-                    }
-                    response.stream(std::move(buf));
-                });
-
+                // The server moves the file to the socket itself
+                // (sendfile for HTTP/1.1), this also sets the
+                // Content-Length.
+                response.set_file(std::move(*body));
                 return response;
             } else {
                 // Use the generic 404 handler
@@ -132,6 +115,7 @@ main() {
     https_config
         .private_key_file("key.pem")
         .certificate_file("cert.pem")
+        .ktls(true)
         .behaviour(lyr)
         .ip(INADDR_ANY)
         .port(2003)
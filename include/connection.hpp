@@ -1,14 +1,26 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
-#include <condition_variable>
+#include <cerrno>
 #include <cstdint>
+#include <functional>
 #include <mutex>
 #include <print>
+#include <poll.h>
+#include <span>
 #include <sys/epoll.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
 #include <utility>
 
+#include "returned_buffers.hpp"
+#include "task.hpp"
+#include "timer_wheel.hpp"
+
 using namespace std::chrono;
 
 using sockfd = int;
@@ -24,16 +36,14 @@ class connection {
     sockfd                   epoll_set_;
     steady_clock::time_point last_active_;
     microseconds             keep_alive_; // in usecs (microseconds)
-    std::condition_variable  cv_;
     std::atomic_intmax_t     refs_;
     std::atomic_bool         closed_;
+    // Timer wheel of the reactor that accepted this connection.
+    rite::timer_wheel       *timers_;
 
     mutable std::mutex lock_;
 
     public:
-    // Refer to docs/connection.org for an explanation
-    static connection<T> *invalid;
-
     connection(sockfd socket, struct sockaddr_storage address, size_t addr_len)
       : socket_(socket)
       , address_(address)
@@ -42,6 +52,7 @@ class connection {
       , keep_alive_(seconds(5))
       , refs_(0)
       , closed_(false)
+      , timers_(nullptr)
       , lock_() {}
 
     // IMPORTANT:
@@ -57,6 +68,7 @@ class connection {
       , keep_alive_(other.keep_alive_)
       , refs_(other.refs_.load())
       , closed_(other.closed_.load())
+      , timers_(other.timers_)
       , lock_() {}
 
     virtual ~connection() {
@@ -73,7 +85,6 @@ class connection {
     void was_active() {
         std::lock_guard<std::mutex> lock(lock_);
         last_active_ = steady_clock::now();
-        cv_.notify_all();
     }
 
     steady_clock::time_point last_active() const { return last_active_; }
@@ -83,39 +94,173 @@ class connection {
     void set_keep_alive(microseconds usecs) {
         std::lock_guard<std::mutex> lock(lock_);
         keep_alive_ = usecs;
-        cv_.notify_all();
     }
 
     microseconds get_keep_alive() const { return keep_alive_; }
 
-    void take() {
-        refs_.fetch_add(1);
-        cv_.notify_all();
-    }
-    void release() {
-        refs_.fetch_sub(1);
-        cv_.notify_all();
-    }
+    void take() { refs_.fetch_add(1); }
+    void release() { refs_.fetch_sub(1); }
 
+    // Mark the connection as closed.  Shutting the socket down wakes up
+    // the owning reactor (EPOLLHUP), which reclaims the connection once
+    // the last reference is released.
     void close() {
-        closed_.store(true);
-        cv_.notify_all();
+        if (!closed_.exchange(true) && socket_ != -1)
+            ::shutdown(socket_, SHUT_RDWR);
     }
 
     bool is_closed() { return closed_.load(); }
 
-    std::condition_variable &cv() { return cv_; }
-    std::mutex              &mutex() { return lock_; }
-    intmax_t                use_count() const { return refs_.load(); }
+    std::mutex &mutex() { return lock_; }
+    intmax_t    use_count() const { return refs_.load(); }
+
+    rite::timer_wheel *timers() { return timers_; }
+    void               set_timers(rite::timer_wheel *timers) { timers_ = timers; }
+
+    // Arm a one-shot timeout (e.g. for header reads) on the timer wheel
+    // of the owning reactor.  The connection holds a reference until the
+    // timeout fired or was cancelled, `cb` runs on the reactor thread.
+    rite::timer_wheel::id timeout(microseconds after, rite::basic_task<void(connection<T> *), 64> &&cb) {
+        if (timers_ == nullptr)
+            return rite::timer_wheel::invalid;
+        take();
+        return timers_->schedule(after, [this, cb = std::move(cb)]() mutable {
+            cb(this);
+            release();
+        });
+    }
+
+    bool cancel_timeout(rite::timer_wheel::id timer) {
+        if (timers_ == nullptr || !timers_->cancel(timer))
+            return false;
+        release();
+        return true;
+    }
 
     virtual std::lock_guard<std::mutex>  lock() { return std::lock_guard<std::mutex>(lock_); }
     virtual std::unique_lock<std::mutex> unique_lock() { return std::unique_lock<std::mutex>(lock_); }
 
+    // Completion based reactors (io_uring) receive into buffers of their
+    // own and lend them through `deliver`, which returns true if the
+    // connection keeps buffer `id` until its bytes were read and then
+    // hands it back to `returns`.  Transports that have to read the
+    // socket themselves (e.g. TLS) return false and are only notified
+    // about readiness.
+    virtual bool enable_delivery(rite::returned_buffers *returns) { return false; }
+    virtual bool deliver(std::span<const std::byte> data, uint16_t id, bool eof) { return false; }
+
+    // Transports with a handshake of their own (TLS) make progress on it
+    // whenever the reactor sees the socket become ready, the connection
+    // is only handed to `on_read` once it is done.
+    enum class handshake { eWantRead, eWantWrite, eDone, eFailed };
+    virtual handshake advance_handshake() { return handshake::eDone; }
+
     virtual ssize_t write(std::span<const std::byte> what, int flags) = 0;
     virtual ssize_t read(std::span<std::byte> target, int flags) = 0;
-};
 
-// TODO: I'd like this to be `constexpr static` and inline defined, but `reinterpret_cast` is not `constexpr`
-// such that inline I'd (apparently only have the option of uintptr_t, but I'd like to avoid casting it to connection<> when using connection<T>::invalid)
-template<typename T>
-connection<T> *connection<T>::invalid = reinterpret_cast<connection<T> *>((uintptr_t)0x8000000000000000);
+    // Gather write of `buffers`, returns the bytes written like `write`.
+    // Transports that can, write all buffers with a single syscall.
+    virtual ssize_t write(std::span<const struct iovec> buffers, int flags) {
+        ssize_t total = 0;
+        for (const struct iovec &buffer : buffers) {
+            ssize_t bytes = write(std::span<const std::byte>(static_cast<const std::byte *>(buffer.iov_base), buffer.iov_len), flags);
+            if (bytes < 0)
+                return total > 0 ? total : bytes;
+            total += bytes;
+            if (static_cast<size_t>(bytes) < buffer.iov_len)
+                break;
+        }
+        return total;
+    }
+
+    // Write all of `what`, waiting (up to the keep-alive) for a
+    // non-blocking socket to become writable whenever it is full.
+    ssize_t write_all(std::span<const std::byte> what, int flags) {
+        size_t written = 0;
+        while (written < what.size()) {
+            ssize_t bytes = write(what.subspan(written), flags);
+            if (bytes > 0) {
+                written += bytes;
+                continue;
+            }
+            if (bytes < 0 && retry())
+                continue;
+            return -1;
+        }
+        return written;
+    }
+
+    // Write all of `buffers`, which are advanced past what was written.
+    ssize_t write_all(std::span<struct iovec> buffers, int flags) {
+        size_t written = 0;
+        for (;;) {
+            while (!buffers.empty() && buffers.front().iov_len == 0)
+                buffers = buffers.subspan(1);
+            if (buffers.empty())
+                return written;
+
+            ssize_t bytes = write(std::span<const struct iovec>(buffers), flags);
+            if (bytes > 0) {
+                written += bytes;
+                for (size_t left = bytes; left > 0;) {
+                    size_t step = std::min(left, buffers.front().iov_len);
+                    buffers.front().iov_base = static_cast<std::byte *>(buffers.front().iov_base) + step;
+                    buffers.front().iov_len -= step;
+                    left -= step;
+                    if (buffers.front().iov_len == 0)
+                        buffers = buffers.subspan(1);
+                }
+                continue;
+            }
+            if (bytes < 0 && retry())
+                continue;
+            return -1;
+        }
+    }
+
+    // Send `count` bytes of `fd` starting at `offset`, which is advanced
+    // past what was sent.  Returns the bytes sent like `write`.  The
+    // default reads the file into a stack buffer, transports that can
+    // move file pages to the socket directly do so.
+    virtual ssize_t send_file(int fd, off_t &offset, size_t count) {
+        std::array<std::byte, 16384> window;
+        ssize_t                      bytes = ::pread(fd, window.data(), std::min(count, window.size()), offset);
+        if (bytes <= 0)
+            return bytes;
+        ssize_t written = write_all(std::span<const std::byte>(window.data(), bytes), 0);
+        if (written > 0)
+            offset += written;
+        return written;
+    }
+
+    // Send all `count` bytes of `fd` starting at `offset`.
+    ssize_t send_file_all(int fd, off_t offset, size_t count) {
+        size_t sent = 0;
+        while (sent < count) {
+            ssize_t bytes = send_file(fd, offset, count - sent);
+            if (bytes > 0) {
+                sent += bytes;
+                continue;
+            }
+            // The file shrunk underneath us
+            if (bytes == 0)
+                return -1;
+            if (retry())
+                continue;
+            return -1;
+        }
+        return sent;
+    }
+
+    protected:
+    // Whether a failed write is worth retrying, waits (up to the
+    // keep-alive) for a full non-blocking socket to become writable.
+    bool retry() {
+        if (errno == EINTR)
+            return true;
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+            return false;
+        struct pollfd fd = { .fd = socket_, .events = POLLOUT, .revents = 0 };
+        return ::poll(&fd, 1, duration_cast<milliseconds>(keep_alive_).count()) > 0;
+    }
+};
@@ -1,14 +1,16 @@
 #pragma once
 
+#include <atomic>
 #include <concepts>
 #include <functional>
-#include <future>
 #include <string>
+#include <thread>
 
 #include "endpoint.hpp"
 #include "request.hpp"
 #include "response.hpp"
 #include "status_code.hpp"
+#include "task.hpp"
 
 namespace rite::http {
 
@@ -30,6 +32,7 @@ private:
 
     public:
     enum class error { eNoEndpoint };
+    static constexpr size_t DEFAULT_ASYNC_THREADS = 256;
 
     layer()
         : not_found_handler_(std::bind(&layer::default_not_found, this, std::placeholders::_1)){
@@ -69,6 +72,8 @@ private:
         extensions_.back()->on_hook(*this);
     }
 
+    using finisher = rite::basic_task<void(http_response &&)>;
+
     /// Perform path mapping for `req` and hand off the response into
     /// `finish`.  Usage: This function should only be used by
     /// server<T>'s, the finish function is specifically intended to
@@ -76,7 +81,7 @@ private:
     /// revision of the HTTP specification requires custom
     /// serialization that can't be generically represented without
     /// blocking the worker thread.
-    void handle(http_request &req, std::function<void(http_response &&)> &&finish) {
+    void handle(http_request &&req, finisher &&finish) {
         for (auto &ext : extensions_)
             ext->on_request(req);
 
@@ -89,44 +94,46 @@ private:
                 finish(not_found(req));
         }
 
-        if (endpoint) {
-            // Determine the launch policy for executing the handler based on the endpoint's configuration.
-            // - If a thread pool is provided, the handler must run in the thread that picks up the task.
-            // - If there is no thread pool and the endpoint is not asynchronous, the handler runs in the current worker thread.
-            // - If there is no thread pool and the endpoint is asynchronous, a new thread is spawned using std::launch::async.
-            std::launch policy = std::launch::deferred; // Default to deferred execution (i.e. current thread)
-            if (endpoint->asynchronous && !endpoint->thread_pool.has_value()) {
-                // Asynchronous without a thread pool: spawn a new thread
-                policy = std::launch::async;
-            } else if (endpoint->thread_pool.has_value()) {
-                // Thread pool is available: use deferred execution
-                policy = std::launch::deferred;
-            }
+        if (endpoint == nullptr)
+            return;
+
+        // Where the handler runs depends on the endpoint's configuration:
+        // - Without a thread pool and not asynchronous it runs right here
+        //   on the current worker thread, nothing is copied.
+        // - With a thread pool it runs in the thread that picks up the task.
+        // - Asynchronous endpoints without a thread pool get a new thread,
+        //   unless `max_async_threads` are running already.
+        bool offload = endpoint->thread_pool.has_value();
+        if (!offload && endpoint->asynchronous) {
+            offload = async_threads_.fetch_add(1) < async_limit_.load();
+            if (!offload)
+                async_threads_.fetch_sub(1);
+        }
+        if (!offload) {
+            respond(*endpoint, req, mapping, finish);
+            return;
+        }
 
-            std::future<void> handler = std::async(policy, [this, finish, endpoint, mapping, req]() mutable {
-                http_response response = endpoint->handler(req, mapping);
-                // TODO: This is not a nice design.
-                // but we definitely need the hooks...
-                for (auto &ext : extensions_)
-                    ext->pre_send(req, response);
-
-                finish(std::move(response));
-
-                for (auto &ext : extensions_)
-                    ext->post_send(req, response);
-            });
-
-            if (endpoint->thread_pool) {
-                endpoint->thread_pool.value().dispatch([&handler]() mutable { handler.get(); });
-            } else {
-                // Run on this thread
-                if (policy == std::launch::deferred)
-                    handler.get();
-                // Async automatically runs. Do not wait.
-            }
+        // The handler outlives this call, move the request along.
+        auto job = [this, endpoint, mapping = std::move(mapping), req = std::move(req), finish = std::move(finish)]() mutable {
+            respond(*endpoint, req, mapping, finish);
+        };
+        if (endpoint->thread_pool) {
+            endpoint->thread_pool.value().dispatch(rite::task(std::move(job)));
+        } else {
+            std::thread([this, job = std::move(job)]() mutable {
+                job();
+                async_threads_.fetch_sub(1);
+            }).detach();
         }
     }
 
+    // Upper bound of the threads asynchronous endpoints without a
+    // thread pool run on.  Requests beyond it run on the worker that
+    // parsed them, which pushes back on the client instead of spawning
+    // threads without bound.
+    void max_async_threads(size_t limit) { async_limit_ = limit; }
+
     http_response not_found(http_request &req) {
         return not_found_handler_(req);
     }
@@ -136,9 +143,24 @@ private:
     }
 
     private:
+    void respond(rite::http::endpoint &endpoint, http_request &req, rite::http::path::result &mapping, finisher &finish) {
+        http_response response = endpoint.handler(req, mapping);
+        // TODO: This is not a nice design.
+        // but we definitely need the hooks...
+        for (auto &ext : extensions_)
+            ext->pre_send(req, response);
+
+        finish(std::move(response));
+
+        for (auto &ext : extensions_)
+            ext->post_send(req, response);
+    }
+
     std::vector<rite::http::endpoint>       endpoints_;
     std::vector<std::unique_ptr<extension>> extensions_;
     std::function<http_response(http_request &)> not_found_handler_;
+    std::atomic_size_t                           async_threads_ = 0;
+    std::atomic_size_t                           async_limit_ = DEFAULT_ASYNC_THREADS;
 };
 
 }
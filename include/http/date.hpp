@@ -0,0 +1,20 @@
+#pragma once
+
+#include <array>
+#include <ctime>
+
+namespace rite::http {
+
+// Length of an IMF-fixdate, "Sun, 06 Nov 1994 08:49:37 GMT"
+constexpr size_t DATE_LENGTH = 29;
+
+using date_string = std::array<char, DATE_LENGTH>;
+
+// IMF-fixdate of `when` (RFC 7231, 7.1.1.1)
+date_string format_date(std::time_t when);
+
+// IMF-fixdate of the current second.  Formatted at most once per second
+// and shared by all threads.
+date_string current_date();
+
+};
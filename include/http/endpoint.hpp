@@ -4,13 +4,17 @@
 #include <future>
 #include <iostream>
 #include <list>
+#include <memory>
 #include <optional>
 #include <regex>
 #include <variant>
 
+#include <jt.hpp>
+
 #include "http/method.hpp"
 #include "http/request.hpp"
 #include "http/response.hpp"
+#include "task.hpp"
 
 namespace rite::http {
 class path {
@@ -92,6 +96,31 @@ class path {
     std::vector<std::string> parameter_names; // Names of the parameters
 };
 
+// Channel of a thread pool an endpoint's handlers are dispatched into.
+// Pools take rite::task, pools that still take std::function<void()>
+// are accepted as well, their tasks are wrapped at the cost of one
+// allocation each.
+class executor {
+    public:
+    executor(jt::mpsc<rite::task>::producer tasks)
+      : target_(std::move(tasks)) {}
+    executor(jt::mpsc<std::function<void()>>::producer functions)
+      : target_(std::move(functions)) {}
+
+    void dispatch(rite::task &&job) {
+        if (auto *tasks = std::get_if<jt::mpsc<rite::task>::producer>(&target_)) {
+            tasks->dispatch(std::move(job));
+            return;
+        }
+        // std::function has to be copyable
+        auto shared = std::make_shared<rite::task>(std::move(job));
+        std::get<jt::mpsc<std::function<void()>>::producer>(target_).dispatch([shared]() { (*shared)(); });
+    }
+
+    private:
+    std::variant<jt::mpsc<rite::task>::producer, jt::mpsc<std::function<void()>>::producer> target_;
+};
+
 struct endpoint {
     public:
     int              method; // A bit-set representing the HTTP methods (e.g., GET, POST) that this endpoint supports.
@@ -105,6 +134,8 @@ struct endpoint {
     // flag to `true` allows the endpoint to bypass this limit by
     // spawning a new thread for each incoming request, enabling
     // greater concurrency at the cost of increased resource usage.
+    // The threads are capped by `layer::max_async_threads`, past the
+    // cap handlers run on the worker again.
     bool asynchronous = false;
 
     // The `thread_pool` field allows you to specify a custom thread pool for processing requests
@@ -117,7 +148,7 @@ struct endpoint {
     // your own thread pool, you can limit the number of concurrent threads to a fixed size (N),
     // preventing the potential for resource exhaustion that could occur with the default `asynchronous`
     // behavior, which may spawn an unbounded number of threads.
-    std::optional<jt::mpsc<std::function<void()>>::producer> thread_pool;
+    std::optional<rite::http::executor> thread_pool;
     // A list of middleware functions that will be applied to requests
     // before reaching the handler, allowing for pre-processing,
     // authentication, logging, etc.
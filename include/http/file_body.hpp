@@ -0,0 +1,67 @@
+#pragma once
+
+#include <fcntl.h>
+#include <filesystem>
+#include <optional>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+namespace rite::http {
+
+// A response body served straight from a file, `length` bytes starting
+// at `offset`.  Owns (and closes) the descriptor.
+class file_body {
+    int    fd_ = -1;
+    off_t  offset_ = 0;
+    size_t length_ = 0;
+
+    public:
+    file_body(int fd, off_t offset, size_t length)
+      : fd_(fd)
+      , offset_(offset)
+      , length_(length) {}
+
+    file_body(file_body &&other)
+      : fd_(std::exchange(other.fd_, -1))
+      , offset_(other.offset_)
+      , length_(other.length_) {}
+
+    file_body &operator=(file_body &&other) {
+        if (this != &other) {
+            if (fd_ != -1)
+                ::close(fd_);
+            fd_ = std::exchange(other.fd_, -1);
+            offset_ = other.offset_;
+            length_ = other.length_;
+        }
+        return *this;
+    }
+
+    file_body(const file_body &) = delete;
+    file_body &operator=(const file_body &) = delete;
+
+    ~file_body() {
+        if (fd_ != -1)
+            ::close(fd_);
+    }
+
+    // The whole regular file at `path`
+    static std::optional<file_body> open(const std::filesystem::path &path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1)
+            return std::nullopt;
+        struct stat info;
+        if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+            ::close(fd);
+            return std::nullopt;
+        }
+        return file_body(fd, 0, info.st_size);
+    }
+
+    int    fd() const { return fd_; }
+    off_t  offset() const { return offset_; }
+    size_t length() const { return length_; }
+};
+
+};
@@ -1,5 +1,18 @@
 #pragma once
+#include <algorithm>
 #include <map>
 #include <string>
+#include <string_view>
 
-using header_map = std::map<std::string, std::string>;
+// Field names are case-insensitive (RFC 9110, 5.1)
+struct header_less {
+    using is_transparent = void;
+
+    bool operator()(std::string_view a, std::string_view b) const {
+        return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(), [](unsigned char x, unsigned char y) {
+            return (x >= 'A' && x <= 'Z' ? x | 0x20 : x) < (y >= 'A' && y <= 'Z' ? y | 0x20 : y);
+        });
+    }
+};
+
+using header_map = std::map<std::string, std::string, header_less>;
@@ -1,12 +1,17 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <optional>
 #include <span>
+#include <string_view>
+#include <utility>
 #include <variant>
 
+#include "method.hpp"
 #include "query_parameters.hpp"
 #include "request.hpp"
+#include "version.hpp"
 
 // hpp
 template<typename T>
@@ -22,8 +27,44 @@ decode_uri_component(const std::string &encoded);
 template<>
 struct parser<http_request> {
     public:
-    // bool parse(const std::shared_ptr<connection> &connection, std::span<const std::byte> data, http_request &req);
+    static constexpr size_t MAX_HEADERS = 64;
+    // Larger heads are rejected instead of buffered any further
+    static constexpr size_t MAX_HEAD_SIZE = 65536;
+
+    enum class result { eComplete, eIncomplete, eInvalid };
+
+    // A parsed request head, all views point into the parsed buffer.
+    struct head {
+        http_method                                                             method;
+        http_version                                                            version;
+        std::string_view                                                        target;
+        std::array<std::pair<std::string_view, std::string_view>, MAX_HEADERS> fields;
+        size_t                                                                  field_count = 0;
+        std::optional<size_t>                                                   content_length;
+        // Bytes up to and including the empty line ending the head
+        size_t length = 0;
+        // Bytes of complete lines parsed so far, an incomplete head is
+        // resumed from here once more data arrived.
+        size_t parsed = 0;
+
+        // The buffer holding the head moved from `from` to `to`
+        void rebase(const std::byte *from, const std::byte *to);
+    };
+
+    // Single pass over `data`, returns as soon as `data` can no longer
+    // be the beginning of a valid request.  On eIncomplete, calling
+    // this again with the same `out` and `data` extended by the newly
+    // received bytes continues after the last complete line.
+    result parse_head(std::span<const std::byte> data, head &out);
+
+    // Materialize `parsed` & its `body` into `req`, copying the header
+    // block once.
+    void build(connection<void> *connection, const head &parsed, std::span<const std::byte> body, http_request &req);
+
+    // Parse a request that has to be contained in `data` entirely.
     bool parse(connection<void> *connection, std::span<const std::byte> data, http_request &req);
+
+    static std::optional<http_method> decode_method(std::string_view method);
 };
 
 // Specialization for query_parameters
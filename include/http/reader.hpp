@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+
+#include "parser.hpp"
+#include "request.hpp"
+
+namespace rite::http {
+
+// Per-connection receive buffer & incremental HTTP/1.1 request parser.
+//
+// Bytes are read straight into the buffer (`prepare` / `commit`), `next`
+// parses whatever arrived so far.  An incomplete head is resumed after
+// its last complete line and body bytes are only counted, so nothing is
+// scanned twice.  Bytes following a request stay buffered for the next
+// one.  The buffer grows as bytes arrive, by at most `MAX_GROWTH` at a
+// time and never past the request being received, and is reused across
+// requests.
+class reader {
+    public:
+    using result = parser<http_request>::result;
+
+    static constexpr size_t MIN_READ = 4096;
+    static constexpr size_t MAX_GROWTH = size_t(1) << 20;
+    static constexpr size_t DEFAULT_MAX_BODY_SIZE = size_t(1) << 20;
+
+    // Requests announcing bodies larger than `bytes` are rejected
+    void max_body_size(size_t bytes) { max_body_ = bytes; }
+
+    // At least `min` bytes of space to read into
+    std::span<std::byte> prepare(size_t min = MIN_READ);
+
+    // `bytes` were read into the space returned by `prepare`
+    void commit(size_t bytes) { end_ += bytes; }
+
+    // Take the next complete request out of the buffer
+    result next(connection<void> *connection, http_request &req);
+
+    // Bytes received but not yet consumed by a request
+    size_t buffered() const { return end_ - begin_; }
+
+    // A request head started arriving but isn't complete yet
+    bool in_head() const { return buffered() > 0 && !head_complete_; }
+
+    private:
+    // Make room for `bytes` past `end_`, compacting or growing the buffer
+    void reserve(size_t bytes);
+
+    std::unique_ptr<std::byte[]> buffer_;
+    size_t                       capacity_ = 0;
+    size_t                       max_body_ = DEFAULT_MAX_BODY_SIZE;
+    // The current request starts at `begin_`, received data ends at `end_`
+    size_t begin_ = 0, end_ = 0;
+
+    parser<http_request>::head head_;
+    bool                       head_complete_ = false;
+};
+
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
 #include <sstream>
 #include <string>
@@ -13,10 +14,10 @@
 #include <unordered_map>
 
 #include "connection.hpp"
-#include "header_map.hpp"
 #include "method.hpp"
 #include "pluggable.hpp"
 #include "query_parameters.hpp"
+#include "request_headers.hpp"
 #include "version.hpp"
 
 template<typename T>
@@ -28,8 +29,7 @@ struct http_request {
     query_parameters                     query_;
     http_method                          method_;
     std::vector<std::byte>               body_;
-    // TODO: This is bad! Headers are NOT unique!
-    header_map                           headers_;
+    request_headers                      headers_;
     std::unordered_map<size_t, std::any> context_;
     http_version                         version_;
 
@@ -46,8 +46,10 @@ struct http_request {
 
     http_method method() const { return method_; }
 
+    http_version version() const { return version_; }
+
     std::string_view  path() const { return path_; }
-    const header_map &headers() const { return headers_; }
+    const request_headers &headers() const { return headers_; }
 
     template<typename T>
     void set_context(T &&value) {
@@ -66,11 +68,7 @@ struct http_request {
         return std::any_cast<T &>(ref);
     }
 
-    std::optional<std::string_view> header(const std::string &key) const {
-        if (headers_.contains(key))
-            return headers_.at(key);
-        return std::nullopt;
-    }
+    std::optional<std::string_view> header(std::string_view key) const { return headers_.find(key); }
 
     // TODO: I think we need a better way to do this.
     // Currently both http_request & *_response provide their own `cookie_jar`
@@ -82,20 +80,22 @@ struct http_request {
         enum class error { eNotFound, eDeserialization };
 
         cookie_jar(http_request &request) {
-            for (auto const &h : request.headers()) {
-                if (h.first == "cookie") {
-                    std::istringstream ss(h.second);
-                    std::string cookie;
-                    while (std::getline(ss, cookie, ';')) {
-                        std::istringstream inner(cookie);
-                        std::string key, value;
-
-                        std::getline(inner, key, '=');
-                        std::print("Got cookie '{}'\n", key);
-
-                        std::getline(inner, value, '=');
-                        cookies_[key] = value;
-                    }
+            for (auto const &[name, value] : request.headers()) {
+                if (name != "cookie")
+                    continue;
+
+                // cookie-string = cookie-pair *( ";" SP cookie-pair )
+                std::string_view rest = value;
+                while (!rest.empty()) {
+                    size_t           end = rest.find(';');
+                    std::string_view cookie = rest.substr(0, end);
+                    rest = end == std::string_view::npos ? std::string_view() : rest.substr(end + 1);
+
+                    cookie.remove_prefix(std::min(cookie.find_first_not_of(' '), cookie.size()));
+                    size_t equals = cookie.find('=');
+                    if (equals == std::string_view::npos)
+                        continue;
+                    cookies_[std::string(cookie.substr(0, equals))] = std::string(cookie.substr(equals + 1));
                 }
             }
         }
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Header fields of a request.
+//
+// Names and values live back to back in one owned buffer, entries only
+// store offsets into it; a request thus allocates once for its whole
+// header block instead of twice per field, and copies stay valid.
+// Names are stored lower-cased (as HTTP/2 mandates), lookups are case
+// insensitive.  Duplicate fields are kept in the order they were added.
+class request_headers {
+    struct entry {
+        uint32_t name, name_length;
+        uint32_t value, value_length;
+    };
+
+    std::string        storage_;
+    std::vector<entry> entries_;
+
+    public:
+    using value_type = std::pair<std::string_view, std::string_view>;
+
+    class iterator {
+        const request_headers *headers_ = nullptr;
+        size_t                 index_ = 0;
+
+        public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = request_headers::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        iterator() = default;
+        iterator(const request_headers *headers, size_t index)
+          : headers_(headers)
+          , index_(index) {}
+
+        value_type operator*() const { return headers_->at(index_); }
+        iterator  &operator++() {
+            ++index_;
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator copy = *this;
+            ++index_;
+            return copy;
+        }
+        bool operator==(const iterator &other) const { return index_ == other.index_; }
+    };
+
+    // Reserve room for `fields` fields of `bytes` total length.
+    void reserve(size_t bytes, size_t fields) {
+        storage_.reserve(bytes);
+        entries_.reserve(fields);
+    }
+
+    void add(std::string_view name, std::string_view value) {
+        entry e{ .name = (uint32_t)storage_.size(), .name_length = (uint32_t)name.size(), .value = 0, .value_length = (uint32_t)value.size() };
+        for (char c : name)
+            storage_.push_back(c >= 'A' && c <= 'Z' ? c | 0x20 : c);
+        e.value = storage_.size();
+        storage_.append(value);
+        entries_.push_back(e);
+    }
+
+    // First field named `name`
+    std::optional<std::string_view> find(std::string_view name) const {
+        for (const entry &e : entries_) {
+            if (e.name_length == name.size() && equal(std::string_view(storage_).substr(e.name, e.name_length), name))
+                return std::string_view(storage_).substr(e.value, e.value_length);
+        }
+        return std::nullopt;
+    }
+
+    bool contains(std::string_view name) const { return find(name).has_value(); }
+
+    value_type at(size_t index) const {
+        const entry &e = entries_[index];
+        return { std::string_view(storage_).substr(e.name, e.name_length), std::string_view(storage_).substr(e.value, e.value_length) };
+    }
+
+    size_t size() const { return entries_.size(); }
+    bool   empty() const { return entries_.empty(); }
+
+    void clear() {
+        storage_.clear();
+        entries_.clear();
+    }
+
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, entries_.size()); }
+
+    private:
+    // `lower` is already lower-case
+    static bool equal(std::string_view lower, std::string_view name) {
+        for (size_t i = 0; i < name.size(); ++i) {
+            char c = name[i];
+            if ((c >= 'A' && c <= 'Z' ? c | 0x20 : c) != lower[i])
+                return false;
+        }
+        return true;
+    }
+};
@@ -6,8 +6,10 @@
 #include <functional>
 #include <memory>
 #include <optional>
+#include <span>
 #include <vector>
 
+#include "file_body.hpp"
 #include "header_map.hpp"
 #include "status_code.hpp"
 #include "pluggable.hpp"
@@ -38,6 +40,7 @@ struct http_response {
     header_map                                            headers_;
     std::map<event, std::function<void(http_response &)>> events_;
     std::unordered_map<size_t, std::any>                  context_;
+    std::optional<rite::http::file_body>                  file_;
 
     friend struct serializer<http_response>;
 
@@ -114,6 +117,16 @@ struct http_response {
 
     void stream(rite::buffer &&data) { channel->tx().dispatch(std::move(data)); }
 
+    /// Serve the body from a file instead of `stream`.  The server moves
+    /// it to the socket without copying it through the channel, chunk
+    /// events are not triggered.
+    void set_file(rite::http::file_body &&file) {
+        set_content_length(file.length());
+        file_ = std::move(file);
+    }
+
+    const std::optional<rite::http::file_body> &file() const { return file_; }
+
     const header_map &headers() const { return headers_; }
     void              set_header(std::string_view header, std::string_view value) { headers_[std::string(header)] = value; }
 
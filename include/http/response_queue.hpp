@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+#include "response.hpp"
+
+namespace rite::http {
+
+// In-order delivery of pipelined HTTP/1.1 responses.
+//
+// Every request takes a ticket when it is parsed, handlers may finish
+// in any order (thread pools, asynchronous endpoints).  A finished
+// response is written right away if it is next in line, otherwise it
+// is parked until its predecessors are out: whichever thread completes
+// the head of the line writes every response that is ready behind it.
+// No thread ever waits for another request's handler.
+class response_queue {
+    public:
+    struct entry {
+        // Empty for tickets that only close the connection
+        std::optional<http_response> response;
+        bool                         close = false;
+        // Body is sent with Transfer-Encoding: chunked
+        bool chunked = false;
+        // Answers a HEAD request, only the head is sent
+        bool head_only = false;
+    };
+
+    uint64_t ticket() {
+        std::lock_guard<std::mutex> guard(lock_);
+        pending_.emplace_back();
+        return next_++;
+    }
+
+    // `write` is called with every entry whose turn it is, in ticket
+    // order.  Entries after one that closed the connection are dropped,
+    // `write` may set `close` when the connection broke.
+    template<typename F>
+    void complete(uint64_t ticket, entry &&done, F &&write) {
+        std::unique_lock<std::mutex> guard(lock_);
+        slot &s = pending_[ticket - serving_];
+        s.value = std::move(done);
+        s.ready = true;
+        if (writing_)
+            return;
+
+        writing_ = true;
+        while (!pending_.empty() && pending_.front().ready) {
+            entry e = std::move(pending_.front().value);
+            pending_.pop_front();
+            serving_++;
+
+            bool skip = closed_;
+            closed_ = closed_ || e.close;
+            if (skip)
+                continue;
+
+            guard.unlock();
+            write(e);
+            guard.lock();
+            closed_ = closed_ || e.close;
+        }
+        writing_ = false;
+    }
+
+    private:
+    struct slot {
+        entry value;
+        bool  ready = false;
+    };
+
+    std::mutex       lock_;
+    std::deque<slot> pending_;
+    uint64_t         next_ = 0;
+    uint64_t         serving_ = 0;
+    bool             writing_ = false;
+    bool             closed_ = false;
+};
+
+};
@@ -0,0 +1,26 @@
+#pragma once
+
+namespace rite::http::scan {
+
+// Byte scanning kernels of the HTTP/1.1 parser.  The widest
+// implementation the CPU supports (per cpuid) is picked on first use,
+// non-x86 targets always use the scalar one.
+enum class level { eScalar, eSSE42, eAVX2 };
+
+// First byte in [p, end) that is not a token character (tchar), i.e.
+// where a header name ends.
+const char *token(const char *p, const char *end);
+
+// First byte in [p, end) that may not appear in a field value (CR,
+// LF and any other control character but HTAB), i.e. where a header
+// line ends.
+const char *field_value(const char *p, const char *end);
+
+// Implementation in use
+level current();
+
+// Use `wanted` (or the best supported level below it) from now on.
+// Meant for tests & benchmarks, not thread-safe.
+level select(level wanted);
+
+};
@@ -3,6 +3,8 @@
 #include "../protocol.hpp"
 #include "response.hpp"
 
+#include <span>
+
 template<typename T>
 struct serializer;
 
@@ -11,6 +13,10 @@ struct serializer<http_response> {
     public:
     bool                   serialize_body;
     std::vector<std::byte> operator()(const http_response &response_) const;
+    // Serialize the head into `out`, returns the length of the head.  When
+    // that exceeds `out.size()` nothing useful was written, retry with a
+    // buffer of at least that size.
+    size_t operator()(const http_response &response_, std::span<std::byte> out) const;
 };
 
 template<>
@@ -1,81 +1,84 @@
 #pragma once
 
-#define CODE(num, text) e##num = num, e##text = num
-#define CODE_UNUSED(num) e##num = num
+// Every status code we know, `CODE(num, Name, "Reason")` for codes with
+// a reason phrase, `CODE_UNUSED(num)` for reserved ones.
+#define HTTP_STATUS_CODES(CODE, CODE_UNUSED)                                    \
+    /* 1xx family */                                                            \
+    CODE(100, Continue, "Continue")                                             \
+    CODE(101, SwitchingProtocols, "Switching Protocols")                        \
+    CODE(102, Processing, "Processing")                                         \
+    CODE(103, EarlyHints, "Early Hints")                                        \
+                                                                                \
+    /* 2xx family */                                                            \
+    CODE(200, Ok, "OK")                                                         \
+    CODE(201, Created, "Created")                                               \
+    CODE(202, Accepted, "Accepted")                                             \
+    CODE(203, NonAuthorativeInformation, "Non-Authoritative Information")       \
+    CODE(204, NoContent, "No Content")                                          \
+    CODE(205, ResetContent, "Reset Content")                                    \
+    CODE(206, PartialContent, "Partial Content")                                \
+    CODE(207, MultiStatus, "Multi-Status")                                      \
+    CODE(208, AlreadyReported, "Already Reported")                              \
+    CODE(226, IMUsed, "IM Used")                                                \
+                                                                                \
+    /* 3xx family */                                                            \
+    CODE(300, MultipleChoices, "Multiple Choices")                              \
+    CODE(301, MovedPermanently, "Moved Permanently")                            \
+    CODE(302, Found, "Found")                                                   \
+    CODE(303, SeeOther, "See Other")                                            \
+    CODE(304, NotModified, "Not Modified")                                      \
+    CODE(305, UseProxy, "Use Proxy")                                            \
+    CODE_UNUSED(306)                                                            \
+    CODE(307, TemporaryRedirect, "Temporary Redirect")                          \
+    CODE(308, PermanentRedirect, "Permanent Redirect")                          \
+                                                                                \
+    /* 4xx family */                                                            \
+    CODE(400, BadRequest, "Bad Request")                                        \
+    CODE(401, Unauthorized, "Unauthorized")                                     \
+    CODE(402, PaymentRequired, "Payment Required")                              \
+    CODE(403, Forbidden, "Forbidden")                                           \
+    CODE(404, NotFound, "Not Found")                                            \
+    CODE(405, MethodNotAllowed, "Method Not Allowed")                           \
+    CODE(406, NotAcceptable, "Not Acceptable")                                  \
+    CODE(407, ProxyAuthenticationRequired, "Proxy Authentication Required")     \
+    CODE(408, RequestTimeout, "Request Timeout")                                \
+    CODE(409, Conflict, "Conflict")                                             \
+    CODE(410, Gone, "Gone")                                                     \
+    CODE(411, LengthRequired, "Length Required")                                \
+    CODE(412, PreconditionFailed, "Precondition Failed")                        \
+    CODE(413, PayloadTooLarge, "Content Too Large")                             \
+    CODE(414, URITooLong, "URI Too Long")                                       \
+    CODE(415, UnsupportedMediaType, "Unsupported Media Type")                   \
+    CODE(416, RangeNotSatifiable, "Range Not Satisfiable")                      \
+    CODE(417, ExpectationFailed, "Expectation Failed")                          \
+    CODE(421, MisdirectedRequest, "Misdirected Request")                        \
+    CODE(422, UnprocessableEntity, "Unprocessable Content")                     \
+    CODE(423, Locked, "Locked")                                                 \
+    CODE(424, FailedDependency, "Failed Dependency")                            \
+    CODE(425, TooEarly, "Too Early")                                            \
+    CODE(426, UpgradeRequired, "Upgrade Required")                              \
+    CODE(428, PreconditionRequired, "Precondition Required")                    \
+    CODE(429, TooManyRequests, "Too Many Requests")                             \
+    CODE(431, RequestHeaderFieldsTooLarge, "Request Header Fields Too Large")   \
+    CODE(451, UnavailableForLegalReasons, "Unavailable For Legal Reasons")      \
+                                                                                \
+    CODE(418, ImATeapot, "I'm a teapot")                                        \
+                                                                                \
+    /* 5xx family */                                                            \
+    CODE(500, InternalServerError, "Internal Server Error")                     \
+    CODE(501, NotImplemented, "Not Implemented")                                \
+    CODE(502, BadGateway, "Bad Gateway")                                        \
+    CODE(503, ServiceUnavailable, "Service Unavailable")                        \
+    CODE(504, GatewayTimeout, "Gateway Timeout")                                \
+    CODE(505, HTTPVersionNotSupported, "HTTP Version Not Supported")            \
+    CODE(506, VariantAlsoNegotiates, "Variant Also Negotiates")                 \
+    CODE(507, InsufficientStorage, "Insufficient Storage")                      \
+    CODE(508, LoopDetected, "Loop Detected")                                    \
+    CODE(509, BandwidthLimitExceeded, "Bandwidth Limit Exceeded")               \
+    CODE(510, NotExtended, "Not Extended")                                      \
+    CODE(511, NetworkAuthenticationRequired, "Network Authentication Required")
 
-enum class http_status_code {
-    // 1xx family
-    CODE(100, Continue),
-    CODE(101, SwitchingProtocols),
-    CODE(102, Processing),
-    CODE(103, EarlyHints),
+#define CODE(num, text, reason) e##num = num, e##text = num,
+#define CODE_UNUSED(num) e##num = num,
 
-    // 2xx family
-    CODE(200, Ok),
-    CODE(201, Created),
-    CODE(202, Accepted),
-    CODE(203, NonAuthorativeInformation),
-    CODE(204, NoContent),
-    CODE(205, ResetContent),
-    CODE(206, PartialContent),
-    CODE(207, MultiStatus),
-    CODE(208, AlreadyReported),
-    CODE(226, IMUsed),
-
-    // 3xx family
-    CODE(300, MultipleChoices),
-    CODE(301, MovedPermanently),
-    CODE(302, Found),
-    CODE(303, SeeOther),
-    CODE(304, NotModified),
-    CODE(305, UseProxy),
-    CODE_UNUSED(306),
-    CODE(307, TemporaryRedirect),
-    CODE(308, PermanentRedirect),
-
-    // 4xx family
-    CODE(400, BadRequest),
-    CODE(401, Unauthorized),
-    CODE(402, PaymentRequired),
-    CODE(403, Forbidden),
-    CODE(404, NotFound),
-    CODE(405, MethodNotAllowed),
-    CODE(406, NotAcceptable),
-    CODE(407, ProxyAuthenticationRequired),
-    CODE(408, RequestTimeout),
-    CODE(409, Conflict),
-    CODE(410, Gone),
-    CODE(411, LengthRequired),
-    CODE(412, PreconditionFailed),
-    CODE(413, PayloadTooLarge),
-    CODE(414, URITooLong),
-    CODE(415, UnsupportedMediaType),
-    CODE(416, RangeNotSatifiable),
-    CODE(417, ExpectationFailed),
-    CODE(421, MisdirectedRequest),
-    CODE(422, UnprocessableEntity),
-    CODE(423, Locked),
-    CODE(424, FailedDependency),
-    CODE(425, TooEarly),
-    CODE(426, UpgradeRequired),
-    CODE(428, PreconditionRequired),
-    CODE(429, TooManyRequests),
-    CODE(431, RequestHeaderFieldsTooLarge),
-    CODE(451, UnavailableForLegalReasons),
-
-    CODE(418, ImATeapot),
-
-    // 5xx family
-    CODE(500, InternalServerError),
-    CODE(501, NotImplemented),
-    CODE(502, BadGateway),
-    CODE(503, ServiceUnavailable),
-    CODE(504, GatewayTimeout),
-    CODE(505, HTTPVersionNotSupported),
-    CODE(506, VariantAlsoNegotiates),
-    CODE(507, InsufficientStorage),
-    CODE(508, LoopDetected),
-    CODE(509, BandwidthLimitExceeded),
-    CODE(510, NotExtended),
-    CODE(511, NetworkAuthenticationRequired)
-};
+enum class http_status_code { HTTP_STATUS_CODES(CODE, CODE_UNUSED) };
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+#include "status_code.hpp"
+
+namespace rite::http {
+
+namespace detail {
+
+struct status_name {
+    int              code;
+    std::string_view name;
+};
+
+#define STATUS_NAME(num, text, reason) status_name{ num, reason },
+#define STATUS_NAME_UNUSED(num)
+inline constexpr status_name status_names[] = { HTTP_STATUS_CODES(STATUS_NAME, STATUS_NAME_UNUSED) };
+#undef STATUS_NAME
+#undef STATUS_NAME_UNUSED
+
+constexpr std::string_view VERSION = "HTTP/1.1 ";
+
+constexpr size_t
+line_length(const status_name &status) {
+    return VERSION.size() + 4 + status.name.size() + 2;
+}
+
+constexpr size_t
+lines_length() {
+    size_t length = 0;
+    for (const status_name &status : status_names)
+        length += line_length(status);
+    return length;
+}
+
+// All status lines back to back, indexed by `code - 100`.
+struct status_lines {
+    std::array<char, lines_length()> text{};
+    std::array<uint16_t, 500>        offset{};
+    std::array<uint8_t, 500>         length{};
+};
+
+constexpr status_lines
+make_status_lines() {
+    status_lines lines;
+    size_t       at = 0;
+    for (const status_name &status : status_names) {
+        size_t begin = at;
+        for (char c : VERSION)
+            lines.text[at++] = c;
+        lines.text[at++] = '0' + status.code / 100;
+        lines.text[at++] = '0' + status.code / 10 % 10;
+        lines.text[at++] = '0' + status.code % 10;
+        lines.text[at++] = ' ';
+        for (char c : status.name)
+            lines.text[at++] = c;
+        lines.text[at++] = '\r';
+        lines.text[at++] = '\n';
+        lines.offset[status.code - 100] = begin;
+        lines.length[status.code - 100] = at - begin;
+    }
+    return lines;
+}
+
+inline constexpr status_lines STATUS_LINES = make_status_lines();
+
+};
+
+// Full status line including CRLF, e.g. "HTTP/1.1 404 Not Found\r\n".
+// Empty for codes without a reason phrase.
+constexpr std::string_view
+status_line(http_status_code code) {
+    int index = static_cast<int>(code) - 100;
+    if (index < 0 || index >= 500 || detail::STATUS_LINES.length[index] == 0)
+        return {};
+    return std::string_view(detail::STATUS_LINES.text.data() + detail::STATUS_LINES.offset[index], detail::STATUS_LINES.length[index]);
+}
+
+static_assert(status_line(http_status_code::eNotFound) == "HTTP/1.1 404 Not Found\r\n");
+static_assert(status_line(http_status_code::eOk) == "HTTP/1.1 200 OK\r\n");
+static_assert(status_line(http_status_code::e306).empty());
+
+};
@@ -2,15 +2,146 @@
 
 #include "connection.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <sys/sendfile.h>
+#include <vector>
+
 struct plain {};
 
 template<>
 class connection<plain> : public connection<void> {
+    // Buffers the reactor lent us, only used once delivery is enabled.
+    // The reactor is the only producer and the reader (serialized by the
+    // protocol) the only consumer, neither side takes a lock.
+    struct lent {
+        const std::byte *data;
+        uint32_t         length;
+        uint16_t         id;
+    };
+    static constexpr size_t LENT = 16;
+
+    rite::returned_buffers *returns_ = nullptr;
+    std::array<lent, LENT>  lent_;
+    std::atomic_size_t      produced_ = 0;
+    std::atomic_size_t      consumed_ = 0;
+    // Read progress into the oldest lent buffer
+    size_t           offset_ = 0;
+    std::atomic_bool eof_ = false;
+    // Bytes that arrived while all LENT slots were taken are copied.
+    // Until the reader caught up everything that follows is, too.
+    std::atomic_bool       spilling_ = false;
+    std::vector<std::byte> spill_;
+    std::mutex             spill_lock_;
+
     public:
     connection(sockfd socket, struct sockaddr_storage address, size_t addr_len)
       : connection<void>(socket, address, addr_len) {};
 
-    ssize_t read(std::span<std::byte> where, int flags) override { return recv(this->socket_, where.data(), where.size_bytes(), flags); }
+    ~connection() override {
+        // Unread buffers still belong to the reactor
+        if (returns_ != nullptr) {
+            for (size_t i = consumed_.load(); i != produced_.load(); ++i)
+                returns_->push(lent_[i % LENT].id);
+        }
+    }
+
+    bool enable_delivery(rite::returned_buffers *returns) override {
+        returns_ = returns;
+        return true;
+    }
+
+    bool deliver(std::span<const std::byte> data, uint16_t id, bool eof) override {
+        bool kept = false;
+        if (!data.empty()) {
+            size_t produced = produced_.load(std::memory_order_relaxed);
+            if (!spilling_.load(std::memory_order_acquire) && produced - consumed_.load(std::memory_order_acquire) < LENT) {
+                lent_[produced % LENT] = lent{ .data = data.data(), .length = static_cast<uint32_t>(data.size()), .id = id };
+                produced_.store(produced + 1, std::memory_order_release);
+                kept = true;
+            } else {
+                std::lock_guard<std::mutex> guard(spill_lock_);
+                spill_.insert(spill_.end(), data.begin(), data.end());
+                spilling_.store(true, std::memory_order_release);
+            }
+        }
+        // Published after the data, a reader that sees it sees all bytes
+        if (eof)
+            eof_.store(true, std::memory_order_release);
+        return kept;
+    }
+
+    ssize_t read(std::span<std::byte> where, int flags) override {
+        if (returns_ == nullptr)
+            return recv(this->socket_, where.data(), where.size_bytes(), flags);
+
+        // Mirror recv on a non-blocking socket
+        bool   eof = eof_.load(std::memory_order_acquire);
+        bool   peek = flags & MSG_PEEK;
+        size_t consumed = consumed_.load(std::memory_order_relaxed);
+        size_t offset = offset_;
+        size_t n = 0;
+        for (;;) {
+            while (n < where.size() && consumed != produced_.load(std::memory_order_acquire)) {
+                const lent &front = lent_[consumed % LENT];
+                size_t      step = std::min<size_t>(where.size() - n, front.length - offset);
+                std::memcpy(where.data() + n, front.data + offset, step);
+                n += step;
+                offset += step;
+                if (offset < front.length)
+                    break;
+                if (!peek) {
+                    returns_->push(front.id);
+                    consumed_.store(consumed + 1, std::memory_order_release);
+                }
+                consumed++;
+                offset = 0;
+            }
+            if (n == where.size() || !spilling_.load(std::memory_order_acquire))
+                break;
+
+            // Spilled bytes are newer than every lent buffer
+            std::lock_guard<std::mutex> guard(spill_lock_);
+            if (consumed != produced_.load(std::memory_order_acquire))
+                continue;
+            size_t step = std::min(where.size() - n, spill_.size());
+            std::copy_n(spill_.begin(), step, where.begin() + n);
+            n += step;
+            if (!peek) {
+                spill_.erase(spill_.begin(), spill_.begin() + step);
+                if (spill_.empty())
+                    spilling_.store(false, std::memory_order_release);
+            }
+            break;
+        }
+        if (!peek)
+            offset_ = offset;
+
+        if (n == 0 && !eof) {
+            errno = EAGAIN;
+            return -1;
+        }
+        return n;
+    }
+
+    ssize_t write(std::span<const std::byte> what, int flags) override { return send(this->socket_, what.data(), what.size_bytes(), flags | MSG_NOSIGNAL); }
+
+    ssize_t write(std::span<const struct iovec> buffers, int flags) override {
+        struct msghdr message = {};
+        message.msg_iov = const_cast<struct iovec *>(buffers.data());
+        message.msg_iovlen = std::min<size_t>(buffers.size(), IOV_MAX);
+        return sendmsg(this->socket_, &message, flags | MSG_NOSIGNAL);
+    }
 
-    ssize_t write(std::span<const std::byte> what, int flags) override { return send(this->socket_, what.data(), what.size_bytes(), flags); }
+    ssize_t send_file(int fd, off_t &offset, size_t count) override {
+        ssize_t bytes = ::sendfile(this->socket_, fd, &offset, count);
+        // Not something sendfile can read from (e.g. a pipe)
+        if (bytes < 0 && (errno == EINVAL || errno == ENOSYS))
+            return connection<void>::send_file(fd, offset, count);
+        return bytes;
+    }
 };
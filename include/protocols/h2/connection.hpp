@@ -1,11 +1,15 @@
 #pragma once
 
+#include "flow_control.hpp"
 #include "hpack.hpp"
+#include <condition_variable>
 #include <connection.hpp>
 #include <protocols/h2.hpp>
 #include <tls.hpp>
 
+#include <http/reader.hpp>
 #include <http/request.hpp>
+#include <http/response.hpp>
 
 namespace h2 {
 struct parameters {
@@ -14,6 +18,12 @@ struct parameters {
         serializer<h2::hpack> tx;
     } hpack;
 
+    // What the peer announced in its SETTINGS, and what we announce
+    h2::settings peer;
+    h2::settings local;
+    // Streams sending larger request bodies are reset
+    size_t max_body_size = rite::http::reader::DEFAULT_MAX_BODY_SIZE;
+
     parameters() {
         hpack.tx = serializer<h2::hpack>();
         hpack.rx = parser<h2::hpack>();
@@ -49,21 +59,39 @@ class connection<h2::protocol> : public connection<tls> {
 
     connection_state         state_;
     std::optional<h2::frame> unfinished_frame_;
+    // Highest stream the peer opened, anything above is idle
+    h2::stream_id last_stream_ = 0;
+    // Armed by `expect_preface` until the client's SETTINGS arrived
+    rite::timer_wheel::id preface_timer_ = rite::timer_wheel::invalid;
 
     public:
     std::unique_ptr<h2::parameters> parameters_;
     std::map<uint32_t, h2::stream>  streams_;
     http_request request;
 
+    // Send and receive windows, guarded by the connection lock.  Writers
+    // out of credit park on `credit_` until a WINDOW_UPDATE (or SETTINGS)
+    // from the peer opens the window again.
+    h2::flow_control        flow_;
+    std::condition_variable credit_;
+    // Keeps frames whole on the wire.  Writes may block for the
+    // keep-alive on a peer that doesn't read, they don't hold the
+    // connection lock meanwhile so reading goes on.  Taken after the
+    // connection lock, never before.
+    std::mutex writing_;
+
     connection() = delete;
     connection(const connection<h2::protocol> &) = delete;
     connection(connection<h2::protocol> &&) = delete;
 
-    connection(connection<tls> &&channel)
+    // `local` are the limits we announce, they are enforced on the streams
+    // the peer opens.
+    connection(connection<tls> &&channel, const h2::settings &local = {})
       : connection<tls>(std::move(channel))
       , state_(CLIENT_PREFACE)
       , parameters_(std::make_unique<h2::parameters>()) {
         keep_alive_ = minutes(5);
+        parameters_->local = local;
 
       };
 
@@ -86,4 +114,39 @@ class connection<h2::protocol> : public connection<tls> {
 
     using connection<tls>::write;
     int write(const h2::frame &frame);
+    // Write `frame` with `payload` instead of `frame.data`
+    int write(const h2::frame &frame, std::span<const std::byte> payload);
+
+    // Wait (up to the keep-alive) until DATA may be sent on `stream` and
+    // take up to `wanted` octets of credit from its windows.  Returns
+    // zero if the connection closed, the stream was reset or the peer
+    // never opened the window.  `lock` must hold the connection lock.
+    size_t reserve(std::unique_lock<std::mutex> &lock, h2::stream_id stream, size_t wanted);
+
+    // Send `response` on `stream`, its body as DATA frames as large as
+    // the peer's SETTINGS_MAX_FRAME_SIZE and the flow control windows
+    // allow.  Returns once the response is out or the stream is gone
+    // (reset, connection closed or the window never opened), the stream
+    // is forgotten either way.
+    void respond(h2::stream_id stream, http_response &&response);
+
+    // Reset `stream` with RST_STREAM and forget about it.  Outside of
+    // `process` the connection lock must be held.
+    void reset(h2::stream_id stream, h2::error_code error);
+
+    // Tell the peer about a connection error with GOAWAY, the caller
+    // terminates the connection afterwards.
+    void go_away(h2::error_code error);
+
+    // Close the connection unless the client's preface and SETTINGS
+    // arrive within `after`
+    void expect_preface(microseconds after);
+
+    private:
+    // Write with `writing` already holding `writing_`
+    int write(std::unique_lock<std::mutex> &writing, const h2::frame &frame, std::span<const std::byte> payload);
+    // Apply the peer's SETTINGS, false on an invalid value
+    bool apply_settings(const h2::frame &settings);
+    // Acknowledge received DATA once enough of the windows was consumed
+    void update_windows(h2::stream_id stream, bool ended);
 };
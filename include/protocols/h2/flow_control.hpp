@@ -0,0 +1,101 @@
+#pragma once
+
+#include <protocols/h2.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <utility>
+
+namespace h2 {
+// RFC 9113 6.9.2, windows start at 65535 octets and never exceed 2^31-1
+constexpr uint32_t DEFAULT_WINDOW_SIZE = 65535;
+constexpr uint32_t MAX_WINDOW_SIZE = 0x7fffffff;
+
+// What the peer allowed us to send on one stream (or the connection).
+// Lowering SETTINGS_INITIAL_WINDOW_SIZE can make it negative.
+struct send_window {
+    int64_t available = DEFAULT_WINDOW_SIZE;
+
+    // WINDOW_UPDATE, false if the window would overflow
+    bool credit(uint32_t increment) {
+        if (available + increment > MAX_WINDOW_SIZE)
+            return false;
+        available += increment;
+        return true;
+    }
+};
+
+// What we allowed the peer to send.  Received DATA is acknowledged in
+// batches, a single WINDOW_UPDATE restores the window once half of it
+// has been consumed.
+struct receive_window {
+    uint32_t size = DEFAULT_WINDOW_SIZE;
+    uint32_t available = DEFAULT_WINDOW_SIZE;
+
+    // Account `bytes` of DATA, false if the peer overran the window
+    bool receive(uint32_t bytes) {
+        if (bytes > available)
+            return false;
+        available -= bytes;
+        return true;
+    }
+
+    // Increment to advertise, zero while below the batching threshold
+    uint32_t update() {
+        uint32_t consumed = size - available;
+        if (consumed < size / 2)
+            return 0;
+        available = size;
+        return consumed;
+    }
+};
+
+// Flow control state of one HTTP/2 connection: the connection window
+// and the windows of every stream that is still sending or receiving.
+// Not synchronized, the connection lock guards it.
+class flow_control {
+    public:
+    // Track `stream`, its send window starts at the peer's
+    // SETTINGS_INITIAL_WINDOW_SIZE.
+    void open(stream_id stream);
+    void close(stream_id stream);
+    bool contains(stream_id stream) const { return streams_.contains(stream); }
+    // Streams being tracked, i.e. still open
+    size_t size() const { return streams_.size(); }
+
+    // DATA octets that may be sent on `stream` right now, at most `wanted`
+    size_t sendable(stream_id stream, size_t wanted) const;
+    // Account `bytes` of DATA sent on `stream`
+    void sent(stream_id stream, size_t bytes);
+
+    // WINDOW_UPDATE for `stream` (0 for the connection), false on
+    // overflow (FLOW_CONTROL_ERROR).  Updates for streams we are done
+    // with are ignored.
+    bool credit(stream_id stream, uint32_t increment);
+    // SETTINGS_INITIAL_WINDOW_SIZE changed, applies the difference to
+    // every open stream.  False if `size` is out of range or a window
+    // overflows.
+    bool initial_window_size(uint32_t size);
+
+    // Account `bytes` of DATA (padding included) the peer sent on
+    // `stream`, false if it overran either window.
+    bool received(stream_id stream, uint32_t bytes);
+    // WINDOW_UPDATE increments due for the connection and `stream`.  No
+    // more DATA is expected on an `ended` stream, its window is left.
+    std::pair<uint32_t, uint32_t> updates(stream_id stream, bool ended);
+
+    int64_t connection_window() const { return send_.available; }
+
+    private:
+    struct windows {
+        send_window    send;
+        receive_window receive;
+    };
+
+    send_window                  send_;
+    receive_window               receive_;
+    uint32_t                     initial_window_ = DEFAULT_WINDOW_SIZE;
+    std::map<stream_id, windows> streams_;
+};
+};
@@ -3,6 +3,8 @@
 #include "http/parser.hpp"
 #include "http/serializer.hpp"
 #include "huffman.hpp"
+#include "settings.hpp"
+#include "static_table.hpp"
 
 #include <protocols/h2.hpp>
 
@@ -10,8 +12,6 @@
 #include <expected>
 #include <unordered_set>
 
-constexpr size_t DEFAULT_HPACK_TABLE_SIZE = 256;
-
 /* HPACK Implementation */
 
 namespace h2 {
@@ -19,18 +19,48 @@ struct hpack {
     struct header {
         std::string key, value;
     };
+    // Entry of the static or dynamic table, valid until the table changes
+    using header_view = h2::detail::header_view;
     enum class error { eUnknownHeader, eSizeUpdate, eInvalid, eDone, eMore };
 
-    /*
-      The dynamic table consists of a list of header fields maintained in
-      first-in, first-out order.  The first and newest entry in a dynamic
-      table is at the lowest index, and the oldest entry of a dynamic table
-      is at the highest index.
-    */
-    static std::unordered_map<ssize_t, h2::hpack::header> STATIC_HEADER_TABLE;
-    using dynamic_header_map = std::deque<header>;
     using headers = std::vector<header>;
-    static huffman &decoder();
+    // Immutable, shared by every parser and serializer
+    static constexpr huffman codec{};
+    // RFC 7541 4.1, an entry costs its name and value plus 32 octets
+    static constexpr size_t ENTRY_OVERHEAD = 32;
+};
+
+/*
+  The dynamic table consists of a list of header fields maintained in
+  first-in, first-out order.  The first and newest entry in a dynamic
+  table is at the lowest index, and the oldest entry of a dynamic table
+  is at the highest index.
+
+  Both ends evict the same entries as long as they agree on the maximum
+  size, so the size is accounted in octets exactly as RFC 7541 4.1 says.
+*/
+class dynamic_table {
+    public:
+    explicit dynamic_table(size_t max_size = DEFAULT_HEADER_TABLE_SIZE)
+      : max_size_(max_size) {}
+
+    // Add an entry at index 0, evicting the oldest ones to make room.
+    // An entry larger than the table empties it (RFC 7541 4.4).
+    void insert(std::string key, std::string value);
+    // Dynamic Table Size Update, evicts down to `max_size`
+    void resize(size_t max_size);
+
+    const hpack::header &operator[](size_t index) const { return entries_[index]; }
+    size_t               entries() const { return entries_.size(); }
+    size_t               size() const { return size_; }
+    size_t               max_size() const { return max_size_; }
+
+    private:
+    void evict(size_t limit);
+
+    std::deque<hpack::header> entries_;
+    size_t                    size_ = 0;
+    size_t                    max_size_;
 };
 
 template<size_t N> // N = Prefix
@@ -107,14 +137,15 @@ struct parser<h2::hpack> {
     std::string parse_string(std::span<std::byte>::const_iterator &pos, std::span<std::byte> payload);
 
     public:
-    h2::hpack::dynamic_header_map header_map_;
-    h2::hpack::headers            decoded_;
-    ssize_t                       max_table_size = DEFAULT_HPACK_TABLE_SIZE;
+    // Bounded by our SETTINGS_HEADER_TABLE_SIZE, which we leave at the
+    // default.
+    h2::dynamic_table  header_map_;
+    h2::hpack::headers decoded_;
 
     parser();
 
-    const std::string       &key_by_index(uint8_t index) const;
-    const h2::hpack::header *header_by_index(uint32_t index);
+    const std::string     &key_by_index(uint8_t index) const;
+    h2::hpack::header_view header_by_index(uint32_t index);
 
     public:
     h2::hpack::error parse(const h2::frame &);
@@ -126,9 +157,11 @@ struct parser<h2::hpack> {
     h2::hpack::headers &&result();
 };
 
+// Header blocks are decoded in the order they are sent, so blocks have
+// to be serialized and written under the same lock.
 template<>
 struct serializer<h2::hpack> {
-    h2::hpack::dynamic_header_map header_map_;
+    h2::dynamic_table header_map_;
 
     // Empty payload, add headers using `serialize`
     // when finished, call `finish` and flush the
@@ -146,14 +179,24 @@ struct serializer<h2::hpack> {
     };
     struct literal {};
 
+    // Static entries win over dynamic ones, full matches over names
     std::variant<fully_indexed, key_indexed, literal> search_index(const h2::hpack::header &h);
 
-    // NOTE: This function is fairly stupid and does not particularly
-    // make use of the header compression HPACK offers, ideally we'd
-    // save some state about which headers are most often used and
-    // tell our peer to index those, but instead we'll just send stupp
-    // generally without indexing except for the static table.
+    // The peer's SETTINGS_HEADER_TABLE_SIZE changed.  We never use more
+    // than the default, the new size is announced at the start of the
+    // next header block.
+    void max_table_size(size_t size);
+
+    // Headers that are not in either table are added to the dynamic one
+    // so that repeated ones (content-type, server, cookies) cost a byte
+    // in later blocks.  Values that rarely repeat are sent without
+    // indexing, they would only evict useful entries.
     void serialize(std::span<const h2::hpack::header>);
 
     h2::frame finish(uint32_t);
+
+    private:
+    // Table size we may use, and the smallest one since the last block
+    size_t limit_ = h2::DEFAULT_HEADER_TABLE_SIZE;
+    size_t lowest_ = h2::DEFAULT_HEADER_TABLE_SIZE;
 };
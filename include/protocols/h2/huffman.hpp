@@ -1,116 +1,350 @@
 #pragma once
 
-#include <bitset>
-#include <cmath>
+#include <array>
+#include <cstddef>
 #include <cstdint>
-#include <iomanip>
-#include <iostream>
-#include <limits>
-#include <print>
-#include <ratio>
+#include <span>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <vector>
 
-class huffman {
-    public:
-    using encoding_map = std::unordered_map<char, std::pair<uint32_t, int>>;
-    // Constructor that takes the encoding map
-    huffman(const encoding_map &encodings)
-      : encodings_(encodings) {
-        // Create a reverse map for decoding
-        for (const auto &pair : encodings) {
-            auto codepoint = pair.first;
-            auto length = pair.second.second;
-            auto encoding = pair.second.first;  // << (32 - length);
-            reverse_map_[encoding] = codepoint; // Store character
-            code_lengths_[encoding] = length;   // Store length
-        }
-    }
-
-    std::string decode(const std::string_view &data) {
-        std::string output;
-        auto        pos = data.begin();
-        auto        end = data.end();
-
-        size_t min_bit_size = std::numeric_limits<size_t>::max();
-        for (auto &[_, size] : code_lengths_) {
-            if (static_cast<size_t>(size) < min_bit_size) {
-                min_bit_size = size;
-            }
-        }
+namespace h2::detail {
+struct huffman_code {
+    uint32_t bits;
+    uint8_t  length;
+};
 
-        uint32_t code = 0;
+// RFC 7541 Appendix B, indexed by symbol, 256 is EOS.
+// clang-format off
+inline constexpr std::array<huffman_code, 257> HUFFMAN_CODES = { {
+    { 0b1111111111000, 13 }, // 0
+    { 0b11111111111111111011000, 23 }, // 1
+    { 0b1111111111111111111111100010, 28 }, // 2
+    { 0b1111111111111111111111100011, 28 }, // 3
+    { 0b1111111111111111111111100100, 28 }, // 4
+    { 0b1111111111111111111111100101, 28 }, // 5
+    { 0b1111111111111111111111100110, 28 }, // 6
+    { 0b1111111111111111111111100111, 28 }, // 7
+    { 0b1111111111111111111111101000, 28 }, // 8
+    { 0b111111111111111111101010, 24 }, // 9
+    { 0b111111111111111111111111111100, 30 }, // 10
+    { 0b1111111111111111111111101001, 28 }, // 11
+    { 0b1111111111111111111111101010, 28 }, // 12
+    { 0b111111111111111111111111111101, 30 }, // 13
+    { 0b1111111111111111111111101011, 28 }, // 14
+    { 0b1111111111111111111111101100, 28 }, // 15
+    { 0b1111111111111111111111101101, 28 }, // 16
+    { 0b1111111111111111111111101110, 28 }, // 17
+    { 0b1111111111111111111111101111, 28 }, // 18
+    { 0b1111111111111111111111110000, 28 }, // 19
+    { 0b1111111111111111111111110001, 28 }, // 20
+    { 0b1111111111111111111111110010, 28 }, // 21
+    { 0b111111111111111111111111111110, 30 }, // 22
+    { 0b1111111111111111111111110011, 28 }, // 23
+    { 0b1111111111111111111111110100, 28 }, // 24
+    { 0b1111111111111111111111110101, 28 }, // 25
+    { 0b1111111111111111111111110110, 28 }, // 26
+    { 0b1111111111111111111111110111, 28 }, // 27
+    { 0b1111111111111111111111111000, 28 }, // 28
+    { 0b1111111111111111111111111001, 28 }, // 29
+    { 0b1111111111111111111111111010, 28 }, // 30
+    { 0b1111111111111111111111111011, 28 }, // 31
+    { 0b010100, 6 }, // 32
+    { 0b1111111000, 10 }, // '!'
+    { 0b1111111001, 10 }, // '"'
+    { 0b111111111010, 12 }, // '#'
+    { 0b1111111111001, 13 }, // '$'
+    { 0b010101, 6 }, // '%'
+    { 0b11111000, 8 }, // '&'
+    { 0b11111111010, 11 }, // "'"
+    { 0b1111111010, 10 }, // '('
+    { 0b1111111011, 10 }, // ')'
+    { 0b11111001, 8 }, // '*'
+    { 0b11111111011, 11 }, // '+'
+    { 0b11111010, 8 }, // ','
+    { 0b010110, 6 }, // '-'
+    { 0b010111, 6 }, // '.'
+    { 0b011000, 6 }, // '/'
+    { 0b00000, 5 }, // '0'
+    { 0b00001, 5 }, // '1'
+    { 0b00010, 5 }, // '2'
+    { 0b011001, 6 }, // '3'
+    { 0b011010, 6 }, // '4'
+    { 0b011011, 6 }, // '5'
+    { 0b011100, 6 }, // '6'
+    { 0b011101, 6 }, // '7'
+    { 0b011110, 6 }, // '8'
+    { 0b011111, 6 }, // '9'
+    { 0b1011100, 7 }, // ':'
+    { 0b11111011, 8 }, // ';'
+    { 0b111111111111100, 15 }, // '<'
+    { 0b100000, 6 }, // '='
+    { 0b111111111011, 12 }, // '>'
+    { 0b1111111100, 10 }, // '?'
+    { 0b1111111111010, 13 }, // '@'
+    { 0b100001, 6 }, // 'A'
+    { 0b1011101, 7 }, // 'B'
+    { 0b1011110, 7 }, // 'C'
+    { 0b1011111, 7 }, // 'D'
+    { 0b1100000, 7 }, // 'E'
+    { 0b1100001, 7 }, // 'F'
+    { 0b1100010, 7 }, // 'G'
+    { 0b1100011, 7 }, // 'H'
+    { 0b1100100, 7 }, // 'I'
+    { 0b1100101, 7 }, // 'J'
+    { 0b1100110, 7 }, // 'K'
+    { 0b1100111, 7 }, // 'L'
+    { 0b1101000, 7 }, // 'M'
+    { 0b1101001, 7 }, // 'N'
+    { 0b1101010, 7 }, // 'O'
+    { 0b1101011, 7 }, // 'P'
+    { 0b1101100, 7 }, // 'Q'
+    { 0b1101101, 7 }, // 'R'
+    { 0b1101110, 7 }, // 'S'
+    { 0b1101111, 7 }, // 'T'
+    { 0b1110000, 7 }, // 'U'
+    { 0b1110001, 7 }, // 'V'
+    { 0b1110010, 7 }, // 'W'
+    { 0b11111100, 8 }, // 'X'
+    { 0b1110011, 7 }, // 'Y'
+    { 0b11111101, 8 }, // 'Z'
+    { 0b1111111111011, 13 }, // '['
+    { 0b1111111111111110000, 19 }, // '\\'
+    { 0b1111111111100, 13 }, // ']'
+    { 0b11111111111100, 14 }, // '^'
+    { 0b100010, 6 }, // '_'
+    { 0b111111111111101, 15 }, // '`'
+    { 0b00011, 5 }, // 'a'
+    { 0b100011, 6 }, // 'b'
+    { 0b00100, 5 }, // 'c'
+    { 0b100100, 6 }, // 'd'
+    { 0b00101, 5 }, // 'e'
+    { 0b100101, 6 }, // 'f'
+    { 0b100110, 6 }, // 'g'
+    { 0b100111, 6 }, // 'h'
+    { 0b00110, 5 }, // 'i'
+    { 0b1110100, 7 }, // 'j'
+    { 0b1110101, 7 }, // 'k'
+    { 0b101000, 6 }, // 'l'
+    { 0b101001, 6 }, // 'm'
+    { 0b101010, 6 }, // 'n'
+    { 0b00111, 5 }, // 'o'
+    { 0b101011, 6 }, // 'p'
+    { 0b1110110, 7 }, // 'q'
+    { 0b101100, 6 }, // 'r'
+    { 0b01000, 5 }, // 's'
+    { 0b01001, 5 }, // 't'
+    { 0b101101, 6 }, // 'u'
+    { 0b1110111, 7 }, // 'v'
+    { 0b1111000, 7 }, // 'w'
+    { 0b1111001, 7 }, // 'x'
+    { 0b1111010, 7 }, // 'y'
+    { 0b1111011, 7 }, // 'z'
+    { 0b111111111111110, 15 }, // '{'
+    { 0b11111111100, 11 }, // '|'
+    { 0b11111111111101, 14 }, // '}'
+    { 0b1111111111101, 13 }, // '~'
+    { 0b1111111111111111111111111100, 28 }, // 127
+    { 0b11111111111111100110, 20 }, // 128
+    { 0b1111111111111111010010, 22 }, // 129
+    { 0b11111111111111100111, 20 }, // 130
+    { 0b11111111111111101000, 20 }, // 131
+    { 0b1111111111111111010011, 22 }, // 132
+    { 0b1111111111111111010100, 22 }, // 133
+    { 0b1111111111111111010101, 22 }, // 134
+    { 0b11111111111111111011001, 23 }, // 135
+    { 0b1111111111111111010110, 22 }, // 136
+    { 0b11111111111111111011010, 23 }, // 137
+    { 0b11111111111111111011011, 23 }, // 138
+    { 0b11111111111111111011100, 23 }, // 139
+    { 0b11111111111111111011101, 23 }, // 140
+    { 0b11111111111111111011110, 23 }, // 141
+    { 0b111111111111111111101011, 24 }, // 142
+    { 0b11111111111111111011111, 23 }, // 143
+    { 0b111111111111111111101100, 24 }, // 144
+    { 0b111111111111111111101101, 24 }, // 145
+    { 0b1111111111111111010111, 22 }, // 146
+    { 0b11111111111111111100000, 23 }, // 147
+    { 0b111111111111111111101110, 24 }, // 148
+    { 0b11111111111111111100001, 23 }, // 149
+    { 0b11111111111111111100010, 23 }, // 150
+    { 0b11111111111111111100011, 23 }, // 151
+    { 0b11111111111111111100100, 23 }, // 152
+    { 0b111111111111111011100, 21 }, // 153
+    { 0b1111111111111111011000, 22 }, // 154
+    { 0b11111111111111111100101, 23 }, // 155
+    { 0b1111111111111111011001, 22 }, // 156
+    { 0b11111111111111111100110, 23 }, // 157
+    { 0b11111111111111111100111, 23 }, // 158
+    { 0b111111111111111111101111, 24 }, // 159
+    { 0b1111111111111111011010, 22 }, // 160
+    { 0b111111111111111011101, 21 }, // 161
+    { 0b11111111111111101001, 20 }, // 162
+    { 0b1111111111111111011011, 22 }, // 163
+    { 0b1111111111111111011100, 22 }, // 164
+    { 0b11111111111111111101000, 23 }, // 165
+    { 0b11111111111111111101001, 23 }, // 166
+    { 0b111111111111111011110, 21 }, // 167
+    { 0b11111111111111111101010, 23 }, // 168
+    { 0b1111111111111111011101, 22 }, // 169
+    { 0b1111111111111111011110, 22 }, // 170
+    { 0b111111111111111111110000, 24 }, // 171
+    { 0b111111111111111011111, 21 }, // 172
+    { 0b1111111111111111011111, 22 }, // 173
+    { 0b11111111111111111101011, 23 }, // 174
+    { 0b11111111111111111101100, 23 }, // 175
+    { 0b111111111111111100000, 21 }, // 176
+    { 0b111111111111111100001, 21 }, // 177
+    { 0b1111111111111111100000, 22 }, // 178
+    { 0b111111111111111100010, 21 }, // 179
+    { 0b11111111111111111101101, 23 }, // 180
+    { 0b1111111111111111100001, 22 }, // 181
+    { 0b11111111111111111101110, 23 }, // 182
+    { 0b11111111111111111101111, 23 }, // 183
+    { 0b11111111111111101010, 20 }, // 184
+    { 0b1111111111111111100010, 22 }, // 185
+    { 0b1111111111111111100011, 22 }, // 186
+    { 0b1111111111111111100100, 22 }, // 187
+    { 0b11111111111111111110000, 23 }, // 188
+    { 0b1111111111111111100101, 22 }, // 189
+    { 0b1111111111111111100110, 22 }, // 190
+    { 0b11111111111111111110001, 23 }, // 191
+    { 0b11111111111111111111100000, 26 }, // 192
+    { 0b11111111111111111111100001, 26 }, // 193
+    { 0b11111111111111101011, 20 }, // 194
+    { 0b1111111111111110001, 19 }, // 195
+    { 0b1111111111111111100111, 22 }, // 196
+    { 0b11111111111111111110010, 23 }, // 197
+    { 0b1111111111111111101000, 22 }, // 198
+    { 0b1111111111111111111101100, 25 }, // 199
+    { 0b11111111111111111111100010, 26 }, // 200
+    { 0b11111111111111111111100011, 26 }, // 201
+    { 0b11111111111111111111100100, 26 }, // 202
+    { 0b111111111111111111111011110, 27 }, // 203
+    { 0b111111111111111111111011111, 27 }, // 204
+    { 0b11111111111111111111100101, 26 }, // 205
+    { 0b111111111111111111110001, 24 }, // 206
+    { 0b1111111111111111111101101, 25 }, // 207
+    { 0b1111111111111110010, 19 }, // 208
+    { 0b111111111111111100011, 21 }, // 209
+    { 0b11111111111111111111100110, 26 }, // 210
+    { 0b111111111111111111111100000, 27 }, // 211
+    { 0b111111111111111111111100001, 27 }, // 212
+    { 0b11111111111111111111100111, 26 }, // 213
+    { 0b111111111111111111111100010, 27 }, // 214
+    { 0b111111111111111111110010, 24 }, // 215
+    { 0b111111111111111100100, 21 }, // 216
+    { 0b111111111111111100101, 21 }, // 217
+    { 0b11111111111111111111101000, 26 }, // 218
+    { 0b11111111111111111111101001, 26 }, // 219
+    { 0b1111111111111111111111111101, 28 }, // 220
+    { 0b111111111111111111111100011, 27 }, // 221
+    { 0b111111111111111111111100100, 27 }, // 222
+    { 0b111111111111111111111100101, 27 }, // 223
+    { 0b11111111111111101100, 20 }, // 224
+    { 0b111111111111111111110011, 24 }, // 225
+    { 0b11111111111111101101, 20 }, // 226
+    { 0b111111111111111100110, 21 }, // 227
+    { 0b1111111111111111101001, 22 }, // 228
+    { 0b111111111111111100111, 21 }, // 229
+    { 0b111111111111111101000, 21 }, // 230
+    { 0b11111111111111111110011, 23 }, // 231
+    { 0b1111111111111111101010, 22 }, // 232
+    { 0b1111111111111111101011, 22 }, // 233
+    { 0b1111111111111111111101110, 25 }, // 234
+    { 0b1111111111111111111101111, 25 }, // 235
+    { 0b111111111111111111110100, 24 }, // 236
+    { 0b111111111111111111110101, 24 }, // 237
+    { 0b11111111111111111111101010, 26 }, // 238
+    { 0b11111111111111111110100, 23 }, // 239
+    { 0b11111111111111111111101011, 26 }, // 240
+    { 0b111111111111111111111100110, 27 }, // 241
+    { 0b11111111111111111111101100, 26 }, // 242
+    { 0b11111111111111111111101101, 26 }, // 243
+    { 0b111111111111111111111100111, 27 }, // 244
+    { 0b111111111111111111111101000, 27 }, // 245
+    { 0b111111111111111111111101001, 27 }, // 246
+    { 0b111111111111111111111101010, 27 }, // 247
+    { 0b111111111111111111111101011, 27 }, // 248
+    { 0b1111111111111111111111111110, 28 }, // 249
+    { 0b111111111111111111111101100, 27 }, // 250
+    { 0b111111111111111111111101101, 27 }, // 251
+    { 0b111111111111111111111101110, 27 }, // 252
+    { 0b111111111111111111111101111, 27 }, // 253
+    { 0b111111111111111111111110000, 27 }, // 254
+    { 0b11111111111111111111101110, 26 }, // 255
+    { 0b111111111111111111111111111111, 30 }, // EOS
+} };
+// clang-format on
 
-        size_t bits_checked = 0;
-        while (pos != end) {
-            uint8_t byte = static_cast<uint8_t>(*pos);
-            for (int i = 7; i >= 0; --i) {
-                uint8_t bit = (byte >> i) & 1; // Extract the bit
-                code = (code << 1) | bit;      // Shift left and add the new bit
-                bits_checked++;
+// Multi-level decoding tables, each indexed by the next 8 bits of input.
+// An entry either completes `value` with the first `length` of those
+// bits, or (`length` 0) continues in table `value` with the bits after
+// them, for codes longer than the bits looked at so far.
+struct huffman_entry {
+    uint16_t value;
+    uint8_t  length;
+};
+using huffman_table = std::array<huffman_entry, 256>;
 
-                // Check if we have a valid code
-                if (code_lengths_.contains(code) && bits_checked >= min_bit_size) {
-                    auto len = code_lengths_[code];
-                    if ((size_t)len == bits_checked) {
-                        output += reverse_map_[code];
-                        code = 0;         // Reset code after successful decode
-                        bits_checked = 0; // Reset bits checked
-                    }
-                }
+template<size_t N>
+struct huffman_tables {
+    std::array<huffman_table, N> tables{};
+    size_t                       count = 1;
+};
 
-                // If we have checked enough bits, we can reset
-                if (bits_checked >= 32) {
-                    code = 0;         // Reset code if we exceed 32 bits
-                    bits_checked = 0; // Reset bits checked
-                }
-            }
-            pos++;
+template<size_t N>
+constexpr huffman_tables<N>
+build_huffman_tables() {
+    huffman_tables<N> out;
+    for (uint16_t symbol = 0; symbol < HUFFMAN_CODES.size(); ++symbol) {
+        auto [bits, length] = HUFFMAN_CODES[symbol];
+        size_t table = 0;
+        for (; length > 8; length -= 8) {
+            // The root table is never a continuation, an entry without
+            // a length and value is unset.
+            auto &entry = out.tables[table][(bits >> (length - 8)) & 0xff];
+            if (entry.length == 0 && entry.value == 0)
+                entry.value = out.count++;
+            table = entry.value;
         }
-        return output;
+        // Every window starting with the last `length` bits of the code
+        size_t first = (bits & ((1u << length) - 1)) << (8 - length);
+        for (size_t i = 0; i < (1u << (8 - length)); ++i)
+            out.tables[table][first + i] = huffman_entry{ .value = symbol, .length = length };
     }
+    return out;
+}
 
-    std::vector<std::byte> encode(const std::string &input) {
-        std::vector<std::byte> output;
-
-        size_t  bit_position = 0;
-        uint8_t byte = 0;
-
-        for (const char codepoint : input) {
-            auto code = encodings_[codepoint].first; // Get the Huffman code
-            auto length = code_lengths_[code];       // Get the length of the Huffman code
-
-            for (int i = 0; i < length; ++i) {
-                byte <<= 1;                             // Shift left to make space for the new bit
-                byte |= (code >> (length - 1 - i)) & 1; // Add the new bit
-
-                bit_position++;
-                if (bit_position == 8) {                            // If we have filled a byte
-                    output.push_back(static_cast<std::byte>(byte)); // Store the byte
-                    byte = 0;                                       // Reset byte
-                    bit_position = 0;                               // Reset bit position
-                }
-            }
-        }
-
-        // Handle any remaining bits that didn't fill a complete byte
-        // Handle any remaining bits that didn't fill a complete byte
-        if (bit_position > 0) {
-            // Shift remaining bits to the left to fill the byte
-            byte <<= (8 - bit_position); // Shift remaining bits to the left
+constexpr size_t        HUFFMAN_TABLE_COUNT = build_huffman_tables<32>().count;
+inline constexpr auto   HUFFMAN_DECODER = build_huffman_tables<HUFFMAN_TABLE_COUNT>().tables;
+};
 
-            // Set the remaining bits to 1
-            byte |= (1 << (8 - bit_position)) - 1; // Set the last (8 - bit_position) bits to 1
+// The HPACK Huffman code (RFC 7541 5.2).  Stateless, the tables are
+// built at compile time, HPACK uses the `h2::hpack::codec` instance.
+class huffman {
+    public:
+    constexpr huffman() = default;
 
-            output.push_back(static_cast<std::byte>(byte)); // Store the last byte
-        }
+    // Append the decoded `data` to `out`, looking at 8 bits per step.
+    // False if `data` is malformed: it contains EOS or ends in padding
+    // that is longer than 7 bits or not a prefix of EOS.
+    bool decode(std::span<const std::byte> data, std::string &out) const;
 
-        return output;
+    // Octets `input` takes Huffman coded, HPACK sends whichever of the
+    // coded and the raw string is shorter.
+    constexpr size_t encoded_length(std::string_view input) const {
+        size_t bits = 0;
+        for (char symbol : input)
+            bits += h2::detail::HUFFMAN_CODES[static_cast<uint8_t>(symbol)].length;
+        return (bits + 7) / 8;
     }
 
-    private:
-    encoding_map                       encodings_;    // Original encoding map with lengths
-    std::unordered_map<uint32_t, char> reverse_map_;  // Reverse map for decoding
-    std::unordered_map<uint32_t, int>  code_lengths_; // Lengths of the codes
+    // Write the Huffman coded `input`, padded with ones to a full octet,
+    // to `out`, which holds at least `encoded_length(input)` octets.
+    void encode_into(std::string_view input, std::span<std::byte> out) const;
+
+    // Append the Huffman coded `input` to `out`.  Returns the octets
+    // appended.
+    size_t encode_into(std::string_view input, std::vector<std::byte> &out) const;
 };
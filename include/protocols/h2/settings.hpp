@@ -0,0 +1,40 @@
+#pragma once
+
+#include "flow_control.hpp"
+#include <protocols/h2.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace h2 {
+// RFC 9113 6.5.2 initial values and bounds
+constexpr uint32_t DEFAULT_HEADER_TABLE_SIZE = 4096;
+constexpr uint32_t DEFAULT_MAX_FRAME_SIZE = 16384;
+constexpr uint32_t MAX_MAX_FRAME_SIZE = 16777215;
+constexpr uint32_t UNLIMITED = std::numeric_limits<uint32_t>::max();
+
+// The SETTINGS of one endpoint, starting at the values the protocol
+// assumes until a SETTINGS frame says otherwise.
+struct settings {
+    enum class error { eNone, eProtocol, eFlowControl };
+
+    uint32_t header_table_size = DEFAULT_HEADER_TABLE_SIZE;
+    bool     enable_push = true;
+    uint32_t max_concurrent_streams = UNLIMITED;
+    uint32_t initial_window_size = DEFAULT_WINDOW_SIZE;
+    uint32_t max_frame_size = DEFAULT_MAX_FRAME_SIZE;
+    uint32_t max_header_list_size = UNLIMITED;
+
+    // Apply the parameters of a SETTINGS payload in order.  Unknown
+    // parameters are ignored, an invalid value is reported as the
+    // connection error it warrants (the payload length is checked by
+    // the caller).
+    error apply(std::span<const std::byte> payload);
+
+    // SETTINGS payload announcing every parameter that differs from
+    // the initial values.
+    std::vector<std::byte> pack() const;
+};
+};
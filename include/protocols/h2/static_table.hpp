@@ -0,0 +1,170 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace h2::detail {
+struct header_view {
+    std::string_view key, value;
+};
+
+// RFC 7541 Appendix A, index 0 is not used.
+// clang-format off
+inline constexpr std::array<header_view, 62> STATIC_TABLE = { {
+    { "", "" },
+    { ":authority", "" }, // 1
+    { ":method", "GET" }, // 2
+    { ":method", "POST" }, // 3
+    { ":path", "/" }, // 4
+    { ":path", "/index.html" }, // 5
+    { ":scheme", "http" }, // 6
+    { ":scheme", "https" }, // 7
+    { ":status", "200" }, // 8
+    { ":status", "204" }, // 9
+    { ":status", "206" }, // 10
+    { ":status", "304" }, // 11
+    { ":status", "400" }, // 12
+    { ":status", "404" }, // 13
+    { ":status", "500" }, // 14
+    { "accept-charset", "" }, // 15
+    { "accept-encoding", "gzip, deflate" }, // 16
+    { "accept-language", "" }, // 17
+    { "accept-ranges", "" }, // 18
+    { "accept", "" }, // 19
+    { "access-control-allow-origin", "" }, // 20
+    { "age", "" }, // 21
+    { "allow", "" }, // 22
+    { "authorization", "" }, // 23
+    { "cache-control", "" }, // 24
+    { "content-disposition", "" }, // 25
+    { "content-encoding", "" }, // 26
+    { "content-language", "" }, // 27
+    { "content-length", "" }, // 28
+    { "content-location", "" }, // 29
+    { "content-range", "" }, // 30
+    { "content-type", "" }, // 31
+    { "cookie", "" }, // 32
+    { "date", "" }, // 33
+    { "etag", "" }, // 34
+    { "expect", "" }, // 35
+    { "expires", "" }, // 36
+    { "from", "" }, // 37
+    { "host", "" }, // 38
+    { "if-match", "" }, // 39
+    { "if-modified-since", "" }, // 40
+    { "if-none-match", "" }, // 41
+    { "if-range", "" }, // 42
+    { "if-unmodified-since", "" }, // 43
+    { "last-modified", "" }, // 44
+    { "link", "" }, // 45
+    { "location", "" }, // 46
+    { "max-forwards", "" }, // 47
+    { "proxy-authenticate", "" }, // 48
+    { "proxy-authorization", "" }, // 49
+    { "range", "" }, // 50
+    { "referer", "" }, // 51
+    { "refresh", "" }, // 52
+    { "retry-after", "" }, // 53
+    { "server", "" }, // 54
+    { "set-cookie", "" }, // 55
+    { "strict-transport-security", "" }, // 56
+    { "transfer-encoding", "" }, // 57
+    { "user-agent", "" }, // 58
+    { "vary", "" }, // 59
+    { "via", "" }, // 60
+    { "www-authenticate", "" }, // 61
+} };
+// clang-format on
+
+constexpr char
+to_lower(char c) {
+    return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+}
+
+// Names are matched ignoring case, values exactly
+constexpr bool
+equals_lower(std::string_view lower, std::string_view name) {
+    if (lower.size() != name.size())
+        return false;
+    for (size_t i = 0; i < name.size(); ++i) {
+        if (lower[i] != to_lower(name[i]))
+            return false;
+    }
+    return true;
+}
+
+// FNV-1a over the lowercase name (and the value), `seed` picks one
+// member of the family.
+constexpr uint32_t
+static_hash(uint32_t seed, std::string_view name) {
+    uint32_t hash = 2166136261u ^ seed;
+    for (char c : name)
+        hash = (hash ^ static_cast<uint8_t>(to_lower(c))) * 16777619u;
+    return hash;
+}
+
+constexpr uint32_t
+static_hash(uint32_t seed, std::string_view name, std::string_view value) {
+    uint32_t hash = static_hash(seed, name) * 16777619u;
+    for (char c : value)
+        hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+    return hash;
+}
+
+// Reverse index into STATIC_TABLE: a perfect hash, the slot of every
+// key holds its (lowest) index and no two keys share a slot.  The seed
+// is searched for at compile time.
+struct static_index {
+    static constexpr size_t SLOTS = 512;
+
+    uint32_t                   seed = 0;
+    std::array<uint8_t, SLOTS> slots{};
+};
+
+template<bool WithValue>
+constexpr uint32_t
+static_slot(uint32_t seed, const header_view &h) {
+    if constexpr (WithValue)
+        return static_hash(seed, h.key, h.value) % static_index::SLOTS;
+    else
+        return static_hash(seed, h.key) % static_index::SLOTS;
+}
+
+template<bool WithValue>
+constexpr static_index
+build_static_index() {
+    for (uint32_t seed = 0;; ++seed) {
+        static_index index{ .seed = seed, .slots = {} };
+        bool         perfect = true;
+        for (uint8_t i = 1; i < STATIC_TABLE.size() && perfect; ++i) {
+            auto &slot = index.slots[static_slot<WithValue>(seed, STATIC_TABLE[i])];
+            if (slot == 0)
+                slot = i;
+            // Names repeat, the first index is kept
+            else if (WithValue || STATIC_TABLE[slot].key != STATIC_TABLE[i].key)
+                perfect = false;
+        }
+        if (perfect)
+            return index;
+    }
+}
+
+inline constexpr static_index STATIC_NAMES = build_static_index<false>();
+inline constexpr static_index STATIC_FIELDS = build_static_index<true>();
+
+// Index of the first entry named `name` (any case), 0 if there is none
+constexpr size_t
+find_static(std::string_view name) {
+    uint8_t index = STATIC_NAMES.slots[static_hash(STATIC_NAMES.seed, name) % static_index::SLOTS];
+    return index != 0 && equals_lower(STATIC_TABLE[index].key, name) ? index : 0;
+}
+
+// Index of the entry `name: value`, 0 if there is none
+constexpr size_t
+find_static(std::string_view name, std::string_view value) {
+    uint8_t index = STATIC_FIELDS.slots[static_hash(STATIC_FIELDS.seed, name, value) % static_index::SLOTS];
+    return index != 0 && STATIC_TABLE[index].value == value && equals_lower(STATIC_TABLE[index].key, name) ? index : 0;
+}
+};
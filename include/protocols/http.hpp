@@ -1,9 +1,11 @@
 #pragma once
+#include <chrono>
 #include <iostream>
 #include <memory>
 
 #include "http/behaviour.hpp"
 #include "plain.hpp"
+#include "protocols/http1.hpp"
 #include "server.hpp"
 
 struct http {
@@ -15,6 +17,8 @@ class rite::server<http> : public rite::server<void> {
     public:
     struct config : public rite::server<void>::config {
         std::shared_ptr<rite::http::layer> behaviour_;
+        size_t                             max_body_size_ = rite::http::reader::DEFAULT_MAX_BODY_SIZE;
+        std::chrono::milliseconds          header_timeout_ = std::chrono::seconds(10);
 
         public:
         config &behaviour(std::shared_ptr<rite::http::layer> impl) {
@@ -22,6 +26,19 @@ class rite::server<http> : public rite::server<void> {
             return *this;
         }
 
+        // Requests with larger bodies are rejected
+        config &max_body_size(size_t bytes) {
+            max_body_size_ = bytes;
+            return *this;
+        }
+
+        // Clients that take longer to send a request head are
+        // disconnected
+        config &header_timeout(std::chrono::milliseconds timeout) {
+            header_timeout_ = timeout;
+            return *this;
+        }
+
         friend class rite::server<::http>;
     };
 
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <utility>
+
+#include "connection.hpp"
+#include "http/reader.hpp"
+#include "http/response_queue.hpp"
+
+// HTTP/1.1 spoken over `Transport` (plain, tls)
+template<typename Transport>
+struct http1 {};
+
+template<typename Transport>
+class connection<http1<Transport>> : public connection<Transport> {
+    public:
+    using connection<Transport>::connection;
+
+    connection(connection<Transport> &&other)
+      : connection<Transport>(std::move(other)) {}
+
+    // Buffered input & parser state, survives across reads.  Readiness
+    // events may be handled concurrently, `read_lock` serializes them.
+    rite::http::reader reader;
+    std::mutex         read_lock;
+    // Set (under `read_lock`) once a request ended the connection,
+    // anything the client pipelined after it is ignored.
+    bool closing = false;
+    // Time a client gets to complete a request head once it started
+    // sending it, armed on the timer wheel (under `read_lock`).
+    std::chrono::microseconds head_timeout = std::chrono::seconds(10);
+    rite::timer_wheel::id     head_timer = rite::timer_wheel::invalid;
+
+    // Pipelined responses go out in request order
+    rite::http::response_queue responses;
+};
+
+namespace rite::http {
+class layer;
+
+// Read whatever `socket` has to offer and hand every complete request in
+// it to `behaviour`, responses are written in request order.  Consumes
+// the reference taken for the readiness event.  Instantiated for plain
+// and tls transports.
+template<typename Transport>
+void serve(connection<http1<Transport>> *socket, rite::http::layer &behaviour);
+};
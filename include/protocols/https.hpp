@@ -1,11 +1,14 @@
 #pragma once
+#include <chrono>
 #include <iostream>
 #include <memory>
 #include <openssl/err.h>
 #include <openssl/ssl.h>
 #include <stdexcept>
 
+#include "protocols/http1.hpp"
 #include "server.hpp"
+#include "session_cache.hpp"
 #include "tls.hpp"
 #include <http/behaviour.hpp>
 
@@ -17,9 +20,8 @@ struct protocol {};
 #pragma GCC diagnostic ignored "-Wunused-function"
 static int
 alpn_select_cb(SSL *, const unsigned char **out, unsigned char *outlen, const unsigned char *in, unsigned int inlen, void *) {
-    // Check the incoming protocols
-    const unsigned char *protocol = NULL;
-    unsigned int         protocol_len = 0;
+    // Prefer HTTP/2, HTTP/1.1 runs over the same TLS connection
+    const unsigned char *h2 = NULL, *http11 = NULL;
 
     // Iterate through the provided protocols
     while (inlen > 0) {
@@ -30,28 +32,29 @@ alpn_select_cb(SSL *, const unsigned char **out, unsigned char *outlen, const un
             return SSL_TLSEXT_ERR_NOACK;
         }
 
-        // Check if the protocol is "h2"
-        if (len == 2 && memcmp(in + 1, "h2", 2) == 0) {
-            // Found the HTTP/2 protocol
-            protocol = in + 1;  // Point to the protocol name
-            protocol_len = len; // Set the length
-            break;
-        }
+        if (len == 2 && memcmp(in + 1, "h2", 2) == 0)
+            h2 = in + 1;
+        else if (len == 8 && memcmp(in + 1, "http/1.1", 8) == 0)
+            http11 = in + 1;
 
         // Move to the next protocol
         in += len + 1;    // Move past the length byte and the protocol name
         inlen -= len + 1; // Decrease the remaining length
     }
 
-    if (protocol) {
-        // Set the output parameters to indicate the selected protocol
-        *out = protocol;          // Set the output to the selected protocol
-        *outlen = protocol_len;   // Set the length of the selected protocol
-        return SSL_TLSEXT_ERR_OK; // Indicate success
+    if (h2) {
+        *out = h2;
+        *outlen = 2;
+        return SSL_TLSEXT_ERR_OK;
+    }
+    if (http11) {
+        *out = http11;
+        *outlen = 8;
+        return SSL_TLSEXT_ERR_OK;
     }
 
-    // If we reach here, we didn't negotiate HTTP/2
-    return SSL_TLSEXT_ERR_NOACK; // Indicate that no protocol was selected
+    // Nothing we speak, the connection falls back to HTTP/1.1
+    return SSL_TLSEXT_ERR_NOACK;
 }
 
 template<>
@@ -61,6 +64,14 @@ class rite::server<https> : public rite::server<void> {
         std::string                        private_key_file_;
         std::string                        certificate_file_;
         std::shared_ptr<rite::http::layer> behaviour_;
+        bool                               ktls_ = false;
+        size_t                             session_cache_size_ = 20480;
+        std::chrono::seconds               session_ttl_ = std::chrono::minutes(5);
+        std::chrono::seconds               ticket_rotation_ = std::chrono::hours(1);
+        uint32_t                           max_concurrent_streams_ = 128;
+        uint32_t                           max_header_list_size_ = 65536;
+        size_t                             max_body_size_ = rite::http::reader::DEFAULT_MAX_BODY_SIZE;
+        std::chrono::milliseconds          header_timeout_ = std::chrono::seconds(10);
 
         public:
         config &private_key_file(std::string file) {
@@ -78,12 +89,69 @@ class rite::server<https> : public rite::server<void> {
             return *this;
         }
 
+        // Let the kernel encrypt sent records (kTLS, Linux only), which
+        // enables sendfile for HTTPS.  Connections whose cipher the
+        // kernel does not support, or hosts without the tls ULP, keep
+        // encrypting in userspace.
+        config &ktls(bool enable) {
+            ktls_ = enable;
+            return *this;
+        }
+
+        // Server side session cache for session id (TLS 1.2) and
+        // stateful resumption, `capacity` sessions kept for up to `ttl`.
+        config &session_cache(size_t capacity, std::chrono::seconds ttl) {
+            session_cache_size_ = capacity;
+            session_ttl_ = ttl;
+            return *this;
+        }
+
+        // Session tickets are encrypted with keys rotated every
+        // `interval`, tickets of the previous key are still accepted.
+        config &ticket_key_rotation(std::chrono::seconds interval) {
+            ticket_rotation_ = interval;
+            return *this;
+        }
+
+        // Limits announced to HTTP/2 clients in our SETTINGS, they bound
+        // what a single connection can make us hold in memory.  Streams
+        // beyond them are reset.
+        config &http2_limits(uint32_t max_concurrent_streams, uint32_t max_header_list_size) {
+            max_concurrent_streams_ = max_concurrent_streams;
+            max_header_list_size_ = max_header_list_size;
+            return *this;
+        }
+
+        // Requests with larger bodies are rejected (HTTP/1.1) or reset
+        // (HTTP/2)
+        config &max_body_size(size_t bytes) {
+            max_body_size_ = bytes;
+            return *this;
+        }
+
+        // Clients that take longer to send a request head (HTTP/1.1) or
+        // their connection preface (HTTP/2) are disconnected
+        config &header_timeout(std::chrono::milliseconds timeout) {
+            header_timeout_ = timeout;
+            return *this;
+        }
+
         friend class server<https>;
     };
 
     protected:
-    config   config_;
-    SSL_CTX *ctx_;
+    config                               config_;
+    SSL_CTX                             *ctx_;
+    std::unique_ptr<rite::session_cache> sessions_;
+    std::unique_ptr<rite::ticket_keys>   tickets_;
+
+    // OpenSSL callbacks, the server is the SSL_CTX app data
+    static int          new_session(SSL *ssl, SSL_SESSION *session);
+    static SSL_SESSION *get_session(SSL *ssl, const unsigned char *id, int length, int *copy);
+    static void         remove_session(SSL_CTX *ctx, SSL_SESSION *session);
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    static int ticket_key(SSL *ssl, unsigned char *name, unsigned char *iv, EVP_CIPHER_CTX *cipher, EVP_MAC_CTX *mac, int encrypt);
+#endif
 
     public:
     // TODO: Throw an exception should `behaviour` not be set on the config.
@@ -91,5 +159,7 @@ class rite::server<https> : public rite::server<void> {
 
     connection<void> *on_accept(connection<void>::native_handle socket, struct sockaddr_storage addr, socklen_t len) override;
 
+    connection<void> *on_handshake(connection<void> *socket) override;
+
     void on_read(connection<void> *socket) override;
 };
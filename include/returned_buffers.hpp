@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rite {
+
+// Ids of the buffers a reactor lent to connections and got back.
+//
+// Readers hand buffers back from any thread once they copied the bytes
+// out, the reactor takes all of them at once and returns them to the
+// kernel.  A lock-free stack linked through the ids: pushing plus
+// taking everything is free of the ABA problem.  An id may only be
+// pushed again after it was taken.
+class returned_buffers {
+    public:
+    static constexpr uint16_t NONE = 0xFFFF;
+
+    explicit returned_buffers(size_t count)
+      : next_(count, NONE) {}
+
+    void push(uint16_t id) {
+        uint16_t head = head_.load(std::memory_order_relaxed);
+        do {
+            next_[id] = head;
+        } while (!head_.compare_exchange_weak(head, id, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    // Calls `f(id)` for every buffer handed back since the last call,
+    // returns how many there were.  Only the owning reactor calls this.
+    template<typename F>
+    size_t take(F &&f) {
+        size_t   count = 0;
+        uint16_t id = head_.exchange(NONE, std::memory_order_acquire);
+        while (id != NONE) {
+            // `f` may lend the buffer out again
+            uint16_t next = next_[id];
+            f(id);
+            id = next;
+            count++;
+        }
+        return count;
+    }
+
+    private:
+    std::vector<uint16_t> next_;
+    std::atomic<uint16_t> head_ = NONE;
+};
+};
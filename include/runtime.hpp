@@ -2,24 +2,68 @@
 
 #include <jt.hpp>
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "task.hpp"
 
 namespace rite {
+
+// How a server's reactors wait for I/O.  `io_uring` requires rite to be
+// built with RITE_IO_URING and a recent kernel, reactors fall back to
+// epoll otherwise.
+enum class io_backend {
+    epoll,
+    io_uring,
+};
+
+// Work-stealing thread pool.
+//
+// Every worker owns a deque: tasks dispatched from a worker are pushed
+// to and popped from the back of its own deque (LIFO, the most recently
+// spawned task is the one whose data is still hot).  Tasks dispatched
+// from anywhere else (reactor threads) go to a shared injection queue.
+// Idle workers first drain the injection queue, then steal from the
+// front of a randomly chosen victim.
 class runtime {
-    jt::mpsc<std::function<void()>> thread_pool_;
-    std::vector<std::thread>        threads_;
-    size_t                          num_workers_;
+    struct worker {
+        std::mutex       lock;
+        std::deque<task> tasks;
+    };
+
+    std::vector<std::unique_ptr<worker>> workers_;
+    std::mutex                           injection_lock_;
+    std::deque<task>                     injection_;
+
+    // Workers sleep on `wake_` when there is nothing to run or steal.
+    std::mutex              sleep_lock_;
+    std::condition_variable wake_;
+    std::atomic_size_t      pending_ = 0;
+    std::atomic_size_t      sleeping_ = 0;
+
+    std::vector<std::thread> threads_;
+    size_t                   num_workers_ = 0;
+
+    bool next(size_t self, task &out);
+    void work(size_t self);
 
     public:
     template<typename T>
-    void attach(T &run) {
+    void attach(T &run, io_backend backend = io_backend::epoll) {
         run.runtime = this;
+        run.backend_ = backend;
         std::thread([&run]() mutable { run(); }).detach();
     }
 
     void worker_threads(size_t);
 
-    void dispatch(std::function<void()> &&);
+    void dispatch(rite::task &&);
 
     [[noreturn]]
     void start();
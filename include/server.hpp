@@ -1,7 +1,11 @@
 #pragma once
 
 #include "connection.hpp"
+#include "returned_buffers.hpp"
 #include "runtime.hpp"
+#include "slot_table.hpp"
+#include "timer_wheel.hpp"
+#include <algorithm>
 #include <asm-generic/socket.h>
 #include <chrono>
 #include <cstdint>
@@ -10,10 +14,21 @@
 #include <memory>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <pthread.h>
+#include <sched.h>
 #include <stdexcept>
 #include <sys/epoll.h>
 #include <sys/socket.h>
+#include <thread>
 #include <unistd.h>
+#include <vector>
+
+#ifdef RITE_IO_URING
+#include <liburing.h>
+#include <poll.h>
+#include <cstring>
+#include <sys/utsname.h>
+#endif
 
 namespace rite {
 
@@ -24,12 +39,89 @@ class server {
     static constexpr int DOMAIN = AF_INET;
     static constexpr int SOCKET_TYPE = SOCK_STREAM | SOCK_NONBLOCK;
 
-    rite::runtime                  *runtime = nullptr;
-    std::vector<connection<void> *> connections_;
-    struct {
-        int server;
-        int epoll;
-    } fd;
+    // A reactor owns one SO_REUSEPORT listening socket, its own epoll
+    // set and every connection it accepted.  Connections never move
+    // between reactors; the kernel balances new connections across the
+    // listening sockets for us.
+    //
+    // Clients are registered with the handle of their slot as epoll
+    // data, events for a slot that was released (and possibly reused)
+    // in the meantime no longer resolve and are dropped.  Keep-alive
+    // expiry runs on the reactor's timer wheel.
+    struct slot {
+        connection<void>     *client = nullptr;
+        rite::timer_wheel::id expiry = rite::timer_wheel::invalid;
+        // Until the transport handshake is done, readiness advances the
+        // handshake on the reactor instead of dispatching `on_read`.
+        bool handshaking = true;
+        // Write readiness is only watched while the handshake waits for it
+        bool want_write = false;
+    };
+    using handle = typename rite::slot_table<slot>::handle;
+
+#ifdef RITE_IO_URING
+    // io_uring backend state of one reactor: the ring and the provided
+    // buffer ring that multishot receives pick their buffers from.
+    // Received buffers are lent to their connection and come back
+    // through `returned` once read.
+    struct uring {
+        static constexpr unsigned ENTRIES = 4096;
+        static constexpr unsigned BUFFERS = 512;
+        static constexpr unsigned BUFFER_SIZE = 4096;
+        static constexpr int      BUFFER_GROUP = 0;
+        // user_data of submissions whose completion we do not care about
+        static constexpr uint64_t IGNORE = ~1ULL;
+
+        struct io_uring               ring;
+        struct io_uring_buf_ring     *buffers = nullptr;
+        std::unique_ptr<std::byte[]> pool;
+        rite::returned_buffers       returned{ BUFFERS };
+        // Buffers out with connections, and the clients whose receive
+        // ended because there were none left.
+        size_t              lent = 0;
+        std::vector<handle> starved;
+
+        ~uring() {
+            if (buffers)
+                io_uring_free_buf_ring(&ring, buffers, BUFFERS, BUFFER_GROUP);
+            io_uring_queue_exit(&ring);
+        }
+
+        // A full submission queue is flushed to make room, nullptr if
+        // even that failed.
+        struct io_uring_sqe *sqe() {
+            struct io_uring_sqe *entry = io_uring_get_sqe(&ring);
+            if (entry == nullptr) {
+                io_uring_submit(&ring);
+                entry = io_uring_get_sqe(&ring);
+            }
+            return entry;
+        }
+
+        // Hand buffer `id` back to the kernel
+        void recycle(unsigned id) {
+            io_uring_buf_ring_add(buffers, pool.get() + id * BUFFER_SIZE, BUFFER_SIZE, id, io_uring_buf_ring_mask(BUFFERS), 0);
+            io_uring_buf_ring_advance(buffers, 1);
+        }
+    };
+#endif
+
+    struct reactor {
+        size_t id = 0;
+        struct {
+            int listener;
+            int epoll;
+        } fd = { 0, 0 };
+        rite::slot_table<slot> connections_;
+        rite::timer_wheel      timers;
+#ifdef RITE_IO_URING
+        std::unique_ptr<uring> ring;
+#endif
+    };
+
+    rite::runtime                        *runtime = nullptr;
+    rite::io_backend                      backend_ = rite::io_backend::epoll;
+    std::vector<std::unique_ptr<reactor>> reactors_;
     friend class runtime;
 
     public:
@@ -38,6 +130,8 @@ class server {
         ssize_t  max_connections_ = SOMAXCONN;
         uint16_t port_;
         uint64_t ip_;
+        size_t   reactors_ = 1;
+        bool     pin_reactors_ = false;
         friend class server<T>;
 
         public:
@@ -56,23 +150,74 @@ class server {
             max_connections_ = max;
             return *this;
         }
+
+        /// Number of reactor threads accepting & polling connections.
+        /// Every reactor binds its own listening socket, `max_connections`
+        /// is split evenly between them.  When `pin` is set, reactor N is
+        /// pinned to CPU (N % hardware_concurrency).
+        config &reactors(size_t count, bool pin = false) {
+            reactors_ = std::max<size_t>(count, 1);
+            pin_reactors_ = pin;
+            return *this;
+        }
     };
 
     private:
     config base_config_;
 
+    // Set up the listening socket & epoll set of `r`
+    void listen(reactor &r);
+
+    [[noreturn]]
+    void run(reactor &r);
+
+    [[noreturn]]
+    void run_epoll(reactor &r);
+
+#ifdef RITE_IO_URING
+    // Returns false if the kernel lacks what the io_uring backend needs
+    // (multishot accept/recv & provided buffer rings), `r` then falls
+    // back to epoll.
+    bool setup_uring(reactor &r);
+
+    [[noreturn]]
+    void run_uring(reactor &r);
+
+    // False if no submission could be queued
+    bool arm_uring(reactor &r, handle h);
+#endif
+
+    // Register a freshly accepted client with `r`.  Returns `invalid`
+    // if the server refused the client or `r` is out of slots.
+    handle admit(reactor &r, int client_socket, struct sockaddr_storage &address, socklen_t address_len);
+
+    // Readiness (or delivered data) for client `h`.
+    void ready(reactor &r, handle h, bool readable, bool writable, bool hangup);
+
+    // Watch (or stop watching) client `h` for write readiness
+    void want_write(reactor &r, handle h, bool write);
+
     public:
     server(config conf)
-      : fd(decltype(fd){ 0, 0 })
-      , base_config_(conf) {}
+      : base_config_(conf) {}
 
     virtual connection<void> *on_accept(connection<void>::native_handle socket, struct sockaddr_storage, socklen_t) = 0;
     virtual void              on_read(connection<void> *) = 0;
 
+    // Called on the reactor thread once the transport handshake of
+    // `client` is done, before its first `on_read`.  Returns the
+    // connection to continue with; protocols negotiated during the
+    // handshake (ALPN) may move `client` into an upgraded connection
+    // and delete it.
+    virtual connection<void> *on_handshake(connection<void> *client) { return client; }
+
     [[noreturn]]
     virtual void operator()();
 
-    virtual void connection_sentinel(size_t, server *);
+    // Reclaim connection slot `h` of `r` once it is idle or closed and
+    // unreferenced, otherwise re-arm its expiry timer.  Runs on the
+    // reactor thread.
+    void expire(reactor &r, handle h);
 };
 
 };
@@ -80,17 +225,36 @@ class server {
 template<typename T>
 void
 rite::server<T>::operator()() {
-    fd.server = socket(rite::server<T>::DOMAIN, rite::server<T>::SOCKET_TYPE, rite::server<T>::PROTOCOL);
-    if (fd.server < 0) {
+    size_t count = base_config_.reactors_;
+    for (size_t i = 0; i < count; ++i) {
+        reactors_.emplace_back(std::make_unique<reactor>());
+        reactors_.back()->id = i;
+        listen(*reactors_.back());
+    }
+
+    // Reactor 0 runs on the thread that `runtime::attach` gave us.
+    for (size_t i = 1; i < count; ++i) {
+        std::thread([this, i]() { run(*reactors_[i]); }).detach();
+    }
+    run(*reactors_[0]);
+}
+
+template<typename T>
+void
+rite::server<T>::listen(reactor &r) {
+    r.fd.listener = socket(rite::server<T>::DOMAIN, rite::server<T>::SOCKET_TYPE, rite::server<T>::PROTOCOL);
+    if (r.fd.listener < 0) {
         throw std::runtime_error("Failed to create socket");
     }
 
     int enable = 1;
     // Some common sock opts
-    setsockopt(fd.server, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(int));
-    setsockopt(fd.server, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(int));
+    setsockopt(r.fd.listener, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(int));
+    // Every reactor binds the same address, the kernel then load-balances
+    // incoming connections between the listening sockets.
+    setsockopt(r.fd.listener, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(int));
     if (rite::server<T>::PROTOCOL == IPPROTO_TCP) {
-        setsockopt(fd.server, SOL_SOCKET, TCP_NODELAY, &enable, sizeof(int));
+        setsockopt(r.fd.listener, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(int));
     }
 
     // Construct sockaddr
@@ -99,108 +263,417 @@ rite::server<T>::operator()() {
     };
 
     // Bind & listen to the socket
-    int result = bind(fd.server, (struct sockaddr *)&address, sizeof(address));
+    int result = bind(r.fd.listener, (struct sockaddr *)&address, sizeof(address));
     if (result != 0) {
         throw std::runtime_error("Failed to bind socket");
     }
-    result = listen(fd.server, base_config_.max_connections_);
+    result = ::listen(r.fd.listener, base_config_.max_connections_);
 
-    // Refer to docs/connections.org
-    connections_.resize(base_config_.max_connections_, (connection<void> *)((uintptr_t)1 << 63));
+    ssize_t slots = std::max<ssize_t>(1, (base_config_.max_connections_ + base_config_.reactors_ - 1) / base_config_.reactors_);
+    r.connections_.resize(slots);
 
     // Create epoll socket
-    fd.epoll = epoll_create1(0);
-    if (fd.epoll < 1) {
+    r.fd.epoll = epoll_create1(0);
+    if (r.fd.epoll < 1) {
         throw std::runtime_error("Failed create epoll socket");
     }
+    // The listening socket is tagged with the one handle that never
+    // resolves to a slot.
     struct epoll_event event;
     event.events = EPOLLIN;
-    event.data.fd = fd.server;
-    if (epoll_ctl(fd.epoll, EPOLL_CTL_ADD, fd.server, &event) != 0) {
+    event.data.u64 = rite::slot_table<slot>::invalid;
+    if (epoll_ctl(r.fd.epoll, EPOLL_CTL_ADD, r.fd.listener, &event) != 0) {
         perror("Failed to add epoll sock");
         throw std::runtime_error("Failed to add server socket to epoll set");
     }
+}
+
+template<typename T>
+void
+rite::server<T>::run(reactor &r) {
+    if (base_config_.pin_reactors_) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(r.id % std::max(1u, std::thread::hardware_concurrency()), &cpus);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0) {
+            std::print("Reactor {}: failed to set CPU affinity\n", r.id);
+        }
+    }
+
+    if (backend_ == rite::io_backend::io_uring) {
+#ifdef RITE_IO_URING
+        if (setup_uring(r))
+            run_uring(r);
+        std::print("Reactor {}: io_uring is not supported by this kernel, falling back to epoll\n", r.id);
+#else
+        std::print("Reactor {}: rite was built without io_uring support (RITE_IO_URING), falling back to epoll\n", r.id);
+#endif
+    }
+    run_epoll(r);
+}
 
-    std::unique_ptr<struct epoll_event[]> events = std::make_unique_for_overwrite<struct epoll_event[]>(base_config_.max_connections_);
+template<typename T>
+typename rite::server<T>::handle
+rite::server<T>::admit(reactor &r, int client_socket, struct sockaddr_storage &address, socklen_t address_len) {
+    connection<void> *con = on_accept(client_socket, address, address_len);
+    if (con == nullptr) {
+        // Failed to accept; ignore.
+        return rite::slot_table<slot>::invalid;
+    }
+
+    handle h = r.connections_.acquire(slot{ .client = con });
+    if (h == rite::slot_table<slot>::invalid) {
+        // All slots are taken.
+        delete con;
+        return h;
+    }
+    con->set_timers(&r.timers);
+    r.connections_.get(h)->expiry = r.timers.schedule(con->last_active() + con->get_keep_alive(), [this, &r, h]() { expire(r, h); });
+    return h;
+}
+
+template<typename T>
+void
+rite::server<T>::ready(reactor &r, handle h, bool readable, bool writable, bool hangup) {
+    slot *entry = r.connections_.get(h);
+    if (entry == nullptr) {
+        // Event was dispatched for client that has already been deallocated.
+        std::cout << "Skipping dead client" << std::endl;
+        return;
+    }
+    connection<void> *client = entry->client;
+
+    if (hangup) {
+        // Peer hung up or we shut the socket down, check for
+        // reclamation on the next tick instead of waiting for
+        // the keep-alive to run out.
+        if (r.timers.cancel(entry->expiry)) {
+            entry->expiry = r.timers.schedule(steady_clock::now(), [this, &r, h]() { expire(r, h); });
+        }
+    }
+
+    if (entry->handshaking && (readable || writable) && !client->is_closed()) {
+        // Handshake progress does not count as activity, a client gets
+        // one keep-alive period to finish it.
+        switch (client->advance_handshake()) {
+            case connection<void>::handshake::eWantRead:
+                want_write(r, h, false);
+                return;
+            case connection<void>::handshake::eWantWrite:
+                want_write(r, h, true);
+                return;
+            case connection<void>::handshake::eFailed:
+                client->close();
+                if (r.timers.cancel(entry->expiry))
+                    entry->expiry = r.timers.schedule(steady_clock::now(), [this, &r, h]() { expire(r, h); });
+                return;
+            case connection<void>::handshake::eDone:
+                break;
+        }
+        entry->handshaking = false;
+        want_write(r, h, false);
+        client = entry->client = on_handshake(client);
+        // Data that arrived along with the end of the handshake raises
+        // no further edge.
+        readable = true;
+    }
+
+    if (readable && !client->is_closed()) {
+        client->take();
+        client->was_active();
+        runtime->dispatch([this, client]() { on_read(client); });
+    }
+}
+
+template<typename T>
+void
+rite::server<T>::want_write(reactor &r, handle h, bool write) {
+    slot *entry = r.connections_.get(h);
+    if (entry == nullptr || entry->want_write == write)
+        return;
+
+    int fd = entry->client->socket();
+#ifdef RITE_IO_URING
+    if (r.ring) {
+        // Changes the events of the pending multishot poll in place.
+        // Without room for the update the interest stays as it is, and
+        // the next readiness event tries again.
+        struct io_uring_sqe *sqe = r.ring->sqe();
+        if (sqe == nullptr)
+            return;
+        io_uring_prep_poll_update(sqe, h, h, POLLIN | POLLRDHUP | (write ? POLLOUT : 0), IORING_POLL_UPDATE_EVENTS);
+        io_uring_sqe_set_data64(sqe, uring::IGNORE);
+        entry->want_write = write;
+        return;
+    }
+#endif
+    // Re-evaluates readiness, a socket that is writable already
+    // raises an edge right away.
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLRDHUP | EPOLLET | (write ? EPOLLOUT : 0);
+    ev.data.u64 = h;
+    if (epoll_ctl(r.fd.epoll, EPOLL_CTL_MOD, fd, &ev) == -1) {
+        perror("Failed to modify epoll socket");
+        return;
+    }
+    entry->want_write = write;
+}
+
+template<typename T>
+void
+rite::server<T>::run_epoll(reactor &r) {
+    ssize_t                               max_events = r.connections_.capacity() + 1;
+    std::unique_ptr<struct epoll_event[]> events = std::make_unique_for_overwrite<struct epoll_event[]>(max_events);
     struct sockaddr_storage               client_address;
     socklen_t                             client_address_len = sizeof(client_address);
     for (;;) {
-        size_t ready = epoll_wait(fd.epoll, events.get(), base_config_.max_connections_, -1);
-        for (size_t i = 0; i < ready; ++i) {
+        int ready = epoll_wait(r.fd.epoll, events.get(), max_events, r.timers.next_timeout());
+        for (int i = 0; i < ready; ++i) {
             struct epoll_event &event = events[i];
-            if (event.data.fd == fd.server) { // Server socket
-                int client_socket = accept(fd.server, (struct sockaddr *)&client_address, &client_address_len);
+            if (event.data.u64 == rite::slot_table<slot>::invalid) { // Server socket
+                client_address_len = sizeof(client_address);
+                int client_socket = accept(r.fd.listener, (struct sockaddr *)&client_address, &client_address_len);
                 if (client_socket < 1) {
                     perror("Failed to accept client");
                     continue;
                 }
 
-                struct epoll_event ev;
-                ev.events = EPOLLIN | EPOLLET;
-                {
-                    connection<void> *con = on_accept(client_socket, client_address, client_address_len);
-                    if(con == nullptr) {
-                        // Failed to accept; ignore.
-                        delete con;
-                        continue;
-                    }
-
-                    auto              next_it = std::find_if(connections_.begin(), connections_.end(), [](auto ptr) {
-                        // Find inactive connection
-                        return (reinterpret_cast<uintptr_t>(ptr) & ((uintptr_t)1 << 63)) != 0;
-                    });
-                    if (next_it == connections_.end()) {
-                        delete con;
-                        continue;
-                    }
-                    auto next_idx = std::distance(connections_.begin(), next_it);
-                    connections_[next_idx] = con;
-
-                    ev.data.u64 = next_idx;
-                    std::thread(std::bind(&server::connection_sentinel, this, std::placeholders::_1, std::placeholders::_2), next_idx, this).detach();
-                }
+                handle h = admit(r, client_socket, client_address, client_address_len);
+                if (h == rite::slot_table<slot>::invalid)
+                    continue;
+
                 // Add client socket epoll set
-                if (epoll_ctl(fd.epoll, EPOLL_CTL_ADD, client_socket, &ev) == -1) {
+                struct epoll_event ev;
+                ev.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+                ev.data.u64 = h;
+                if (epoll_ctl(r.fd.epoll, EPOLL_CTL_ADD, client_socket, &ev) == -1) {
                     perror("Failed to add epoll socket");
                 }
             } else { // Client event
-                if (event.events & EPOLLIN) {
-                    connection<void> *client = reinterpret_cast<connection<void> *>(connections_[event.data.u64]);
-                    if (((uintptr_t)client & ((uintptr_t)1 << 63)) != 0) {
-                        // Event was dispatched for client that has already been deallocated.
-                        std::cout << "Skipping dead client" << std::endl;
-                        continue;
-                    }
-
-                    client = reinterpret_cast<connection<void> *>(((uintptr_t)client) & ((~0ULL) >> 16));
-                    client->take();
-                    client->was_active();
-                    runtime->dispatch(std::bind(&server::on_read, this, client));
-                }
+                this->ready(r, event.data.u64, event.events & EPOLLIN, event.events & EPOLLOUT, event.events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR));
             }
         }
+        r.timers.advance();
     }
 }
 
+#ifdef RITE_IO_URING
+template<typename T>
+bool
+rite::server<T>::setup_uring(reactor &r) {
+    // Multishot receive needs Linux 6.0
+    struct utsname name;
+    unsigned       major = 0, minor = 0;
+    if (uname(&name) != 0 || sscanf(name.release, "%u.%u", &major, &minor) != 2 || major < 6)
+        return false;
+
+    auto ring = std::make_unique<uring>();
+    if (io_uring_queue_init(uring::ENTRIES, &ring->ring, 0) < 0) {
+        // The destructor must not tear down a ring that was never set up.
+        ring.release();
+        return false;
+    }
+
+    int error = 0;
+    ring->buffers = io_uring_setup_buf_ring(&ring->ring, uring::BUFFERS, uring::BUFFER_GROUP, 0, &error);
+    if (ring->buffers == nullptr)
+        return false;
+
+    ring->pool = std::make_unique_for_overwrite<std::byte[]>(uring::BUFFERS * uring::BUFFER_SIZE);
+    for (unsigned i = 0; i < uring::BUFFERS; ++i) {
+        io_uring_buf_ring_add(ring->buffers, ring->pool.get() + i * uring::BUFFER_SIZE, uring::BUFFER_SIZE, i, io_uring_buf_ring_mask(uring::BUFFERS), i);
+    }
+    io_uring_buf_ring_advance(ring->buffers, uring::BUFFERS);
+
+    r.ring = std::move(ring);
+    return true;
+}
+
+// (Re-)arm the multishot operation of client `h`.  Plain connections
+// receive straight into the provided buffer ring and get the buffers
+// lent, transports that read the socket themselves (TLS) get a
+// multishot poll instead.
+template<typename T>
+bool
+rite::server<T>::arm_uring(reactor &r, handle h) {
+    slot *entry = r.connections_.get(h);
+    if (entry == nullptr)
+        return true;
+
+    struct io_uring_sqe *sqe = r.ring->sqe();
+    if (sqe == nullptr)
+        return false;
+
+    int fd = entry->client->socket();
+    if (entry->client->enable_delivery(&r.ring->returned)) {
+        io_uring_prep_recv_multishot(sqe, fd, nullptr, 0, 0);
+        sqe->flags |= IOSQE_BUFFER_SELECT;
+        sqe->buf_group = uring::BUFFER_GROUP;
+    } else {
+        io_uring_prep_poll_multishot(sqe, fd, POLLIN | POLLRDHUP | (entry->want_write ? POLLOUT : 0));
+    }
+    io_uring_sqe_set_data64(sqe, h);
+    return true;
+}
+
 template<typename T>
 void
-rite::server<T>::connection_sentinel(size_t connection_idx, rite::server<T> *server) {
-    connection<void> *con = reinterpret_cast<connection<void> *>(server->connections_[connection_idx]);
-    // Remove application specific information from the pointer
-    uintptr_t mask = (~(0ULL) >> 16);
-    con = reinterpret_cast<connection<void> *>(((uintptr_t)con) & mask);
+rite::server<T>::run_uring(reactor &r) {
+    struct io_uring &ring = r.ring->ring;
+
+    // Retried on every iteration until the submission fits
+    bool accepting = false;
+    auto accept = [&r, &accepting]() {
+        struct io_uring_sqe *sqe = r.ring->sqe();
+        if (sqe == nullptr)
+            return;
+        io_uring_prep_multishot_accept(sqe, r.fd.listener, nullptr, nullptr, 0);
+        io_uring_sqe_set_data64(sqe, rite::slot_table<slot>::invalid);
+        accepting = true;
+    };
+
+    // A client that could not be armed would never hear from the socket
+    // again, it is closed and reclaimed instead.
+    auto arm = [this, &r](handle h) {
+        if (arm_uring(r, h))
+            return;
+        slot *entry = r.connections_.get(h);
+        entry->client->close();
+        if (r.timers.cancel(entry->expiry))
+            entry->expiry = r.timers.schedule(steady_clock::now(), [this, &r, h]() { expire(r, h); });
+    };
 
     for (;;) {
-        std::unique_lock<std::mutex> lk(con->mutex());
-        auto                         last_active = con->last_active();
-        auto                         keep_alive = con->get_keep_alive();
-        auto                         next_wakeup = last_active + keep_alive;
+        if (!accepting)
+            accept();
+
+        // Buffers that readers are done with go back to the kernel, and
+        // receives that ran dry resume once there are some.
+        r.ring->lent -= r.ring->returned.take([&r](uint16_t id) { r.ring->recycle(id); });
+        if (!r.ring->starved.empty() && r.ring->lent < uring::BUFFERS) {
+            for (handle h : std::exchange(r.ring->starved, {}))
+                arm(h);
+        }
+
+        struct io_uring_cqe     *cqe = nullptr;
+        struct __kernel_timespec timeout;
+        int                      wait = r.timers.next_timeout();
+        // Returned buffers raise no completion, look for them regularly
+        // while clients are starved.
+        if (!r.ring->starved.empty())
+            wait = wait < 0 ? 1 : std::min(wait, 1);
+        if (wait >= 0) {
+            timeout.tv_sec = wait / 1000;
+            timeout.tv_nsec = (wait % 1000) * 1'000'000;
+        }
+        io_uring_submit_and_wait_timeout(&ring, &cqe, 1, wait >= 0 ? &timeout : nullptr, nullptr);
+
+        unsigned head, seen = 0;
+        io_uring_for_each_cqe(&ring, head, cqe) {
+            seen++;
+            uint64_t tag = io_uring_cqe_get_data64(cqe);
+            bool     more = cqe->flags & IORING_CQE_F_MORE;
+
+            if (tag == uring::IGNORE)
+                continue;
+
+            if (tag == rite::slot_table<slot>::invalid) { // Multishot accept
+                if (cqe->res >= 0) {
+                    struct sockaddr_storage client_address;
+                    socklen_t               client_address_len = sizeof(client_address);
+                    getpeername(cqe->res, (struct sockaddr *)&client_address, &client_address_len);
+
+                    handle h = admit(r, cqe->res, client_address, client_address_len);
+                    if (h != rite::slot_table<slot>::invalid)
+                        arm(h);
+                } else {
+                    std::print("Reactor {}: accept failed: {}\n", r.id, strerror(-cqe->res));
+                }
+                if (!more)
+                    accepting = false;
+                continue;
+            }
+
+            slot *entry = r.connections_.get(tag);
+            if (entry == nullptr) {
+                // Stale completion of a released slot, still hand back
+                // the buffer it consumed.
+                if (cqe->flags & IORING_CQE_F_BUFFER)
+                    r.ring->recycle(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+                continue;
+            }
 
-        con->cv().wait_until(lk, next_wakeup, [&con]() { return (con->idle() && con->use_count() <= 0) || con->is_closed(); });
-        if ((con->idle() && con->use_count() <= 0) || (con->is_closed() && con->use_count() <= 0))
-            break;
+            bool readable = false, writable = false, hangup = false;
+            if (cqe->flags & IORING_CQE_F_BUFFER) {
+                // Multishot receive, the buffer is lent to the connection
+                // unless it had to copy the bytes.
+                unsigned   id = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+                std::byte *data = r.ring->pool.get() + id * uring::BUFFER_SIZE;
+                if (entry->client->deliver(std::span<const std::byte>(data, std::max(cqe->res, 0)), id, cqe->res == 0))
+                    r.ring->lent++;
+                else
+                    r.ring->recycle(id);
+                readable = true;
+            } else if (cqe->res == -ENOBUFS && r.ring->lent >= uring::BUFFERS) {
+                // Every buffer is out with a reader, resume once one is back
+                r.ring->starved.push_back(tag);
+                more = true; // Do not re-arm
+            } else if (cqe->res == 0 || (cqe->res < 0 && cqe->res != -ENOBUFS)) {
+                // EOF or receive error
+                entry->client->deliver({}, rite::returned_buffers::NONE, true);
+                readable = hangup = true;
+                more = true; // Do not re-arm
+            } else if (cqe->res > 0) {
+                // Multishot poll
+                readable = cqe->res & (POLLIN | POLLRDHUP | POLLHUP);
+                writable = cqe->res & POLLOUT;
+                hangup = cqe->res & (POLLRDHUP | POLLHUP | POLLERR);
+            }
+
+            this->ready(r, tag, readable, writable, hangup);
+            // The kernel ended the multishot request (e.g. it ran out of
+            // provided buffers), submit a new one.
+            if (!more && !hangup)
+                arm(tag);
+        }
+        io_uring_cq_advance(&ring, seen);
+        r.timers.advance();
+    }
+}
+#endif
+
+template<typename T>
+void
+rite::server<T>::expire(reactor &r, handle h) {
+    slot *entry = r.connections_.get(h);
+    if (entry == nullptr)
+        return;
+
+    connection<void> *con = entry->client;
+    entry->expiry = rite::timer_wheel::invalid;
+    if (con->use_count() <= 0 && (con->idle() || con->is_closed())) {
+#ifdef RITE_IO_URING
+        if (r.ring) {
+            // The pending multishot request holds a reference to the
+            // socket, cancel it or the socket is never closed.  Without
+            // room for the cancellation try again on the next tick.
+            struct io_uring_sqe *sqe = r.ring->sqe();
+            if (sqe == nullptr) {
+                entry->expiry = r.timers.schedule(steady_clock::now(), [this, &r, h]() { expire(r, h); });
+                return;
+            }
+            io_uring_prep_cancel64(sqe, h, 0);
+            io_uring_sqe_set_data64(sqe, uring::IGNORE);
+        }
+#endif
+        r.connections_.release(h);
+        delete con;
+        return;
     }
 
-    connections_[connection_idx] = (connection<void> *)((uintptr_t)con | (((uintptr_t)1) << 63));
-    delete con;
+    // Still in use or active recently.  Closed connections only wait for
+    // their last reference to be released, re-check those on the next tick.
+    auto now = steady_clock::now();
+    auto next = con->is_closed() ? now : std::max(con->last_active() + con->get_keep_alive(), now);
+    entry->expiry = r.timers.schedule(next, [this, &r, h]() { expire(r, h); });
 }
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace rite {
+
+// In-memory cache of serialized TLS sessions, keyed by session id.
+//
+// Split into shards that each hold an LRU list under their own lock, so
+// concurrent handshakes rarely contend.  Every shard holds up to
+// `capacity / SHARDS` sessions (evicting the least recently used one),
+// sessions older than `ttl` are never returned.
+class session_cache {
+    public:
+    using clock = std::chrono::steady_clock;
+
+    static constexpr size_t SHARDS = 16;
+
+    session_cache(size_t capacity, std::chrono::seconds ttl);
+
+    void                                insert(std::string_view id, std::vector<uint8_t> &&session, clock::time_point now = clock::now());
+    std::optional<std::vector<uint8_t>> find(std::string_view id, clock::time_point now = clock::now());
+    void                                erase(std::string_view id);
+
+    size_t size() const;
+
+    private:
+    struct entry {
+        std::string          id;
+        std::vector<uint8_t> session;
+        clock::time_point    expires;
+    };
+
+    struct shard {
+        mutable std::mutex                                               lock;
+        std::list<entry>                                                 lru; // most recently used first
+        std::unordered_map<std::string_view, std::list<entry>::iterator> index;
+    };
+
+    shard &shard_of(std::string_view id);
+
+    size_t                    per_shard_;
+    std::chrono::seconds      ttl_;
+    std::array<shard, SHARDS> shards_;
+};
+
+// Session ticket encryption keys (RFC 5077), rotated every `interval`.
+// A ticket stays decryptable for one more interval after its key was
+// replaced, clients holding it are then issued a fresh ticket.
+class ticket_keys {
+    public:
+    using clock = std::chrono::steady_clock;
+
+    struct key {
+        std::array<uint8_t, 16> name;
+        std::array<uint8_t, 32> aes;
+        std::array<uint8_t, 32> hmac;
+    };
+
+    ticket_keys(std::chrono::seconds interval);
+
+    // Key to encrypt new tickets with, rotating it when due
+    key current(clock::time_point now = clock::now());
+    // Key named `name` and whether it is the current one, for decryption
+    std::optional<std::pair<key, bool>> find(const uint8_t *name, clock::time_point now = clock::now());
+
+    private:
+    void rotate(clock::time_point now);
+
+    std::mutex           lock_;
+    std::chrono::seconds interval_;
+    clock::time_point    rotated_;
+    key                  current_;
+    std::optional<key>   previous_;
+};
+
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace rite {
+
+// Fixed capacity table with a freelist of unused slots.
+//
+// `acquire` hands out a 64-bit handle that packs the slot index into
+// the lower and the slot's generation into the upper 32 bits.  Every
+// `release` bumps the generation, a handle kept around (e.g. inside an
+// epoll event or a timer) after its slot was released and reused thus
+// no longer resolves.  All operations are O(1).
+//
+// Not thread-safe, a table is owned by a single reactor.
+template<typename T>
+class slot_table {
+    public:
+    using handle = uint64_t;
+    static constexpr handle invalid = ~0ULL;
+
+    slot_table() = default;
+    slot_table(size_t capacity) { resize(capacity); }
+
+    // Only call this while no slot is in use.
+    void resize(size_t capacity) {
+        slots_.resize(capacity);
+        for (size_t i = 0; i < capacity; ++i) {
+            slots_[i].used = false;
+            slots_[i].next = i + 1 < capacity ? i + 1 : npos;
+        }
+        free_ = capacity > 0 ? 0 : npos;
+        used_ = 0;
+    }
+
+    // Returns `invalid` if the table is full.
+    handle acquire(T &&value) {
+        if (free_ == npos)
+            return invalid;
+
+        uint32_t index = free_;
+        slot    &s = slots_[index];
+        free_ = s.next;
+        s.value = std::move(value);
+        s.used = true;
+        used_++;
+        return ((uint64_t)s.generation << 32) | index;
+    }
+
+    // Resolve `h`, returns nullptr for stale or invalid handles.
+    T *get(handle h) {
+        uint32_t index = h & 0xFFFFFFFF;
+        if (index >= slots_.size())
+            return nullptr;
+
+        slot &s = slots_[index];
+        if (!s.used || s.generation != (h >> 32))
+            return nullptr;
+        return &s.value;
+    }
+
+    bool release(handle h) {
+        if (get(h) == nullptr)
+            return false;
+
+        uint32_t index = h & 0xFFFFFFFF;
+        slot    &s = slots_[index];
+        s.value = T{};
+        s.used = false;
+        s.generation++;
+        s.next = free_;
+        free_ = index;
+        used_--;
+        return true;
+    }
+
+    size_t size() const { return used_; }
+    size_t capacity() const { return slots_.size(); }
+    bool   full() const { return free_ == npos; }
+
+    private:
+    static constexpr uint32_t npos = ~0U;
+
+    struct slot {
+        T        value{};
+        uint32_t generation = 0;
+        uint32_t next = npos;
+        bool     used = false;
+    };
+
+    std::vector<slot> slots_;
+    uint32_t          free_ = npos;
+    size_t            used_ = 0;
+};
+
+};
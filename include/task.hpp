@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace rite {
+
+namespace detail {
+template<typename F>
+constexpr bool is_function = false;
+template<typename S>
+constexpr bool is_function<std::function<S>> = true;
+};
+
+template<typename Signature, size_t Capacity = 128>
+class basic_task;
+
+// Move-only replacement for std::function.
+//
+// Callables of up to `Capacity` bytes (that are nothrow move
+// constructible) are stored inline, only larger ones are moved to the
+// heap.  Every closure the framework itself dispatches (readiness
+// events, timers, response callbacks) fits into the default 128 bytes,
+// so handing work to the runtime does not allocate.
+template<typename R, typename... Args, size_t Capacity>
+class basic_task<R(Args...), Capacity> {
+    struct operations {
+        R (*invoke)(void *, Args &&...);
+        // Move construct into uninitialized `to` and destroy `from`
+        void (*relocate)(void *to, void *from) noexcept;
+        void (*destroy)(void *) noexcept;
+    };
+
+    template<typename F>
+    static constexpr bool stored_inline = sizeof(F) <= Capacity && alignof(F) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<F>;
+
+    template<typename F>
+    struct inline_storage {
+        static F *get(void *storage) { return std::launder(reinterpret_cast<F *>(storage)); }
+
+        static constexpr operations ops{
+            .invoke = [](void *storage, Args &&...args) -> R { return std::invoke(*get(storage), std::forward<Args>(args)...); },
+            .relocate =
+              [](void *to, void *from) noexcept {
+                  ::new (to) F(std::move(*get(from)));
+                  get(from)->~F();
+              },
+            .destroy = [](void *storage) noexcept { get(storage)->~F(); },
+        };
+    };
+
+    template<typename F>
+    struct heap_storage {
+        static F *&get(void *storage) { return *std::launder(reinterpret_cast<F **>(storage)); }
+
+        static constexpr operations ops{
+            .invoke = [](void *storage, Args &&...args) -> R { return std::invoke(*get(storage), std::forward<Args>(args)...); },
+            .relocate = [](void *to, void *from) noexcept { ::new (to) F *(std::exchange(get(from), nullptr)); },
+            .destroy = [](void *storage) noexcept { delete get(storage); },
+        };
+    };
+
+    alignas(std::max_align_t) std::byte storage_[Capacity];
+    const operations *ops_ = nullptr;
+
+    public:
+    basic_task() noexcept = default;
+    basic_task(std::nullptr_t) noexcept {}
+
+    template<typename F>
+        requires(!std::is_same_v<std::remove_cvref_t<F>, basic_task> && std::is_invocable_r_v<R, std::decay_t<F> &, Args...>)
+    basic_task(F &&callable) {
+        using type = std::decay_t<F>;
+        if constexpr (std::is_pointer_v<type> || std::is_member_pointer_v<type> || detail::is_function<type>) {
+            // Empty function pointers & std::function's stay empty
+            if (callable == nullptr)
+                return;
+        }
+
+        if constexpr (stored_inline<type>) {
+            ::new (static_cast<void *>(storage_)) type(std::forward<F>(callable));
+            ops_ = &inline_storage<type>::ops;
+        } else {
+            ::new (static_cast<void *>(storage_)) type *(new type(std::forward<F>(callable)));
+            ops_ = &heap_storage<type>::ops;
+        }
+    }
+
+    basic_task(basic_task &&other) noexcept
+      : ops_(std::exchange(other.ops_, nullptr)) {
+        if (ops_)
+            ops_->relocate(storage_, other.storage_);
+    }
+
+    basic_task &operator=(basic_task &&other) noexcept {
+        if (this != &other) {
+            reset();
+            if ((ops_ = std::exchange(other.ops_, nullptr)))
+                ops_->relocate(storage_, other.storage_);
+        }
+        return *this;
+    }
+
+    basic_task &operator=(std::nullptr_t) noexcept {
+        reset();
+        return *this;
+    }
+
+    basic_task(const basic_task &) = delete;
+    basic_task &operator=(const basic_task &) = delete;
+
+    ~basic_task() { reset(); }
+
+    R operator()(Args... args) {
+        if (ops_ == nullptr)
+            throw std::bad_function_call();
+        return ops_->invoke(storage_, std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+    // Whether a callable of type `F` is stored without allocating.
+    template<typename F>
+    static constexpr bool fits = stored_inline<std::decay_t<F>>;
+
+    private:
+    void reset() noexcept {
+        if (ops_)
+            std::exchange(ops_, nullptr)->destroy(storage_);
+    }
+};
+
+using task = basic_task<void()>;
+
+};
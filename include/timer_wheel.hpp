@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "task.hpp"
+
+namespace rite {
+
+// Hierarchical timer wheel.
+//
+// Time is divided into ticks of `resolution` length.  Level 0 holds
+// the timers that expire within the next 64 ticks, level 1 those
+// within the next 64^2 ticks and so on.  Whenever level N wraps
+// around, the due slot of level N+1 is cascaded down, so inserting,
+// cancelling and expiring a timer are all O(1).
+//
+// Scheduling and cancelling are thread-safe; `advance` is meant to be
+// called by a single thread (i.e. the reactor owning the wheel), the
+// callbacks run on that thread without the internal lock held, they
+// may thus schedule new timers themselves.
+class timer_wheel {
+    public:
+    using clock = std::chrono::steady_clock;
+    using callback = rite::task;
+    // Generation-tagged handle, stale handles are ignored by `cancel`
+    using id = uint64_t;
+
+    static constexpr id     invalid = ~0ULL;
+    static constexpr size_t LEVELS = 4;
+    static constexpr size_t SLOT_BITS = 6;
+    static constexpr size_t SLOTS = 1 << SLOT_BITS;
+
+    timer_wheel(std::chrono::milliseconds resolution = std::chrono::milliseconds(100));
+
+    // Timeouts beyond 64^4 ticks (~19 days at 100ms) are clamped.
+    id schedule(clock::time_point deadline, callback &&cb);
+    id schedule(clock::duration timeout, callback &&cb) { return schedule(clock::now() + timeout, std::move(cb)); }
+
+    // Returns false if the timer already fired or was cancelled.
+    bool cancel(id timer);
+
+    // Fire every timer that is due at `now`, returns the number of
+    // callbacks run.
+    size_t advance(clock::time_point now = clock::now());
+
+    // Milliseconds until the next tick (suitable for `epoll_wait`), or
+    // -1 if there is no pending timer.
+    int next_timeout(clock::time_point now = clock::now()) const;
+
+    size_t size() const;
+
+    std::chrono::milliseconds resolution() const { return resolution_; }
+
+    private:
+    static constexpr uint32_t npos = ~0U;
+
+    struct node {
+        callback cb;
+        uint64_t deadline;
+        uint32_t generation;
+        uint32_t prev, next;
+        uint16_t level, slot;
+        bool     active;
+    };
+
+    uint64_t ticks(clock::time_point) const;
+    void     place(uint32_t index);
+    void     unlink(uint32_t index);
+    void     cascade(size_t level);
+
+    mutable std::mutex                                 lock_;
+    std::chrono::milliseconds                          resolution_;
+    clock::time_point                                  epoch_;
+    uint64_t                                           current_;
+    size_t                                             pending_;
+    std::vector<node>                                  nodes_;
+    uint32_t                                           free_;
+    std::array<std::array<uint32_t, SLOTS>, LEVELS>    slots_;
+};
+
+};
@@ -1,9 +1,14 @@
 #pragma once
 
 #include "connection.hpp"
+#include "tls_stats.hpp"
 #include <openssl/crypto.h>
 #include <openssl/err.h>
 #include <openssl/ssl.h>
+#include <algorithm>
+#include <cerrno>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <utility>
 
@@ -13,33 +18,138 @@ template<>
 class connection<tls> : public connection<void> {
     private:
     SSL *ssl_;
+    bool handshaken_ = false;
+    // Accepted at, for the handshake latency
+    steady_clock::time_point accepted_;
+    // The kernel encrypts what we send (kTLS), files can be sent without
+    // being copied through userspace.  Everything else still goes
+    // through SSL_write, which keeps the record state consistent.
+    bool ktls_send_ = false;
+    // An SSL object must not be used from two threads at once, requests
+    // are read while responses complete on other threads.
+    std::mutex ssl_lock_;
+
+    // Whether OpenSSL managed to hand the keys to the kernel, falls back
+    // to userspace when the tls ULP or the cipher is not supported.
+    void detect_ktls() { ktls_send_ = BIO_get_ktls_send(SSL_get_wbio(ssl_)); }
+
+    // Map an SSL_read/SSL_write return value onto the recv/send
+    // conventions the callers expect: EAGAIN whenever SSL wants to wait
+    // for the socket (errno may be stale after non application records),
+    // zero on a clean shutdown.
+    ssize_t result(int bytes) {
+        if (bytes > 0)
+            return bytes;
+        switch (SSL_get_error(ssl_, bytes)) {
+            case SSL_ERROR_WANT_READ:
+            case SSL_ERROR_WANT_WRITE:
+                errno = EAGAIN;
+                return -1;
+            case SSL_ERROR_ZERO_RETURN:
+                return 0;
+            case SSL_ERROR_SYSCALL:
+                if (errno == 0)
+                    errno = ECONNRESET;
+                return -1;
+            default:
+                errno = EPROTO;
+                return -1;
+        }
+    }
 
     public:
+    // The handshake is driven by `advance_handshake`, `socket` should be
+    // non-blocking.
     connection(SSL_CTX *ctx, sockfd socket, struct sockaddr_storage address, size_t addr_len)
-      : connection<void>(socket, address, addr_len) {
+      : connection<void>(socket, address, addr_len)
+      , accepted_(steady_clock::now()) {
         ssl_ = SSL_new(ctx);
         SSL_set_fd(ssl_, socket_);
-        if (SSL_accept(ssl_) <= 0) {
-            ERR_print_errors_fp(stderr);
-            throw std::runtime_error("ssl accept failed");
-        }
+        SSL_set_accept_state(ssl_);
     }
 
     connection(connection<tls> &&other)
       : connection<void>(std::move(other))
-      , ssl_(std::exchange(other.ssl_, nullptr)) {
+      , ssl_(std::exchange(other.ssl_, nullptr))
+      , handshaken_(other.handshaken_)
+      , accepted_(other.accepted_)
+      , ktls_send_(other.ktls_send_) {
         other.socket_ = -1;
     }
 
+    ~connection() {
+        if (ssl_)
+            SSL_free(ssl_);
+    }
+
+    handshake advance_handshake() override {
+        if (handshaken_)
+            return handshake::eDone;
+
+        std::lock_guard<std::mutex> guard(ssl_lock_);
+        ERR_clear_error();
+        int result = SSL_do_handshake(ssl_);
+        if (result == 1) {
+            handshaken_ = true;
+            detect_ktls();
+            rite::tls_stats::global().handshake(duration_cast<microseconds>(steady_clock::now() - accepted_), SSL_session_reused(ssl_));
+            return handshake::eDone;
+        }
+        switch (SSL_get_error(ssl_, result)) {
+            case SSL_ERROR_WANT_READ:
+                return handshake::eWantRead;
+            case SSL_ERROR_WANT_WRITE:
+                return handshake::eWantWrite;
+            default:
+                rite::tls_stats::global().handshake_failed();
+                return handshake::eFailed;
+        }
+    }
+
     SSL *ssl() { return ssl_; }
+    bool ktls() const { return ktls_send_; }
 
     ssize_t read(std::span<std::byte> where, int) {
+        std::lock_guard<std::mutex> guard(ssl_lock_);
         ERR_clear_error();
-        return SSL_read(ssl_, where.data(), where.size_bytes());
+        return result(SSL_read(ssl_, where.data(), where.size_bytes()));
     }
 
     ssize_t write(std::span<const std::byte> what, int) {
+        std::lock_guard<std::mutex> guard(ssl_lock_);
         ERR_clear_error();
-        return SSL_write(ssl_, what.data(), what.size_bytes());
+        return result(SSL_write(ssl_, what.data(), what.size_bytes()));
+    }
+
+    // SSL has no gather write, coalesce what fits into one record
+    // instead of emitting a record per buffer.
+    ssize_t write(std::span<const struct iovec> buffers, int flags) override {
+        constexpr size_t                          RECORD = 16384;
+        thread_local std::unique_ptr<std::byte[]> record = std::make_unique_for_overwrite<std::byte[]>(RECORD);
+        size_t                                    total = 0;
+        for (const struct iovec &buffer : buffers)
+            total += buffer.iov_len;
+        if (total > RECORD)
+            return connection<void>::write(buffers, flags);
+
+        std::byte *out = record.get();
+        for (const struct iovec &buffer : buffers)
+            out = std::copy_n(static_cast<const std::byte *>(buffer.iov_base), buffer.iov_len, out);
+        return write(std::span<const std::byte>(record.get(), total), flags);
+    }
+
+    ssize_t send_file(int fd, off_t &offset, size_t count) override {
+#ifdef SSL_OP_ENABLE_KTLS
+        if (ktls_send_) {
+            std::lock_guard<std::mutex> guard(ssl_lock_);
+            ERR_clear_error();
+            ossl_ssize_t bytes = SSL_sendfile(ssl_, fd, offset, count, 0);
+            if (bytes <= 0)
+                return result(static_cast<int>(bytes));
+            offset += bytes;
+            return bytes;
+        }
+#endif
+        return connection<void>::send_file(fd, offset, count);
     }
 };
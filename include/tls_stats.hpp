@@ -0,0 +1,73 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+
+namespace rite {
+
+// Process wide TLS statistics, every server<https> reports here and
+// extensions (e.g. Odin) read them.
+class tls_stats {
+    public:
+    // Handshake latencies are kept in power of two buckets of
+    // microseconds, bucket N holds latencies below 2^N us.
+    static constexpr size_t BUCKETS = 32;
+
+    // A finished handshake, `resumed` if it resumed an earlier session
+    void handshake(std::chrono::microseconds latency, bool resumed = false) {
+        uint64_t us = std::max<int64_t>(latency.count(), 0);
+        size_t   bucket = std::min<size_t>(std::bit_width(us), BUCKETS - 1);
+        latency_[bucket].fetch_add(1, std::memory_order_relaxed);
+        handshakes_.fetch_add(1, std::memory_order_relaxed);
+        if (resumed)
+            resumed_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void handshake_failed() { failed_.fetch_add(1, std::memory_order_relaxed); }
+
+    uint64_t handshakes() const { return handshakes_.load(std::memory_order_relaxed); }
+    uint64_t failed_handshakes() const { return failed_.load(std::memory_order_relaxed); }
+    uint64_t resumed_handshakes() const { return resumed_.load(std::memory_order_relaxed); }
+
+    // Share (0..1) of finished handshakes that resumed a session
+    double resumption_rate() const {
+        uint64_t total = handshakes();
+        return total == 0 ? 0.0 : double(resumed_handshakes()) / total;
+    }
+
+    // Upper bound of the bucket holding the `p`th (0..1) percentile of
+    // handshake latencies, zero before the first handshake.
+    std::chrono::microseconds handshake_percentile(double p) const {
+        std::array<uint64_t, BUCKETS> counts;
+        uint64_t                      total = 0;
+        for (size_t i = 0; i < BUCKETS; ++i)
+            total += counts[i] = latency_[i].load(std::memory_order_relaxed);
+        if (total == 0)
+            return std::chrono::microseconds(0);
+
+        uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(p * total + 0.5)), seen = 0;
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            seen += counts[i];
+            if (seen >= rank)
+                return std::chrono::microseconds(uint64_t(1) << i);
+        }
+        return std::chrono::microseconds(uint64_t(1) << (BUCKETS - 1));
+    }
+
+    static tls_stats &global() {
+        static tls_stats stats;
+        return stats;
+    }
+
+    private:
+    std::atomic<uint64_t>                      handshakes_{ 0 };
+    std::atomic<uint64_t>                      failed_{ 0 };
+    std::atomic<uint64_t>                      resumed_{ 0 };
+    std::array<std::atomic<uint64_t>, BUCKETS> latency_{};
+};
+
+};
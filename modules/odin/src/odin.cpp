@@ -9,6 +9,7 @@
 #include <rite/extensions/odin.hpp>
 #include <sys/socket.h>
 #include <thread>
+#include <tls_stats.hpp>
 
 #include "rite/extensions/odin/resources.hpp"
 
@@ -162,12 +163,12 @@ odin::index(http_request &request, path::result) {
 <h1>Admin Panel</h1>
 <div class="flex justify-between">
 <h2>Overview</h2>
-<button class="flex center" hx-trigger="click" hx-get="/__server/!component/card?metric=RPS&metric=P90&metric=P75&metric=P50&metric=total_served&metric=2xx&metric=4xx&metric=5xx" hx-target="#bento" hx-swap="innerHTML">
+<button class="flex center" hx-trigger="click" hx-get="/__server/!component/card?metric=RPS&metric=P90&metric=P75&metric=P50&metric=total_served&metric=2xx&metric=4xx&metric=5xx&metric=TLS_handshake&metric=TLS_resumption" hx-target="#bento" hx-swap="innerHTML">
 <svg xmlns="http://www.w3.org/2000/svg" width="24" height="24" viewBox="0 0 24 24" fill="none" stroke="currentColor" stroke-width="2" stroke-linecap="round" stroke-linejoin="round" class="lucide lucide-refresh-ccw"><path d="M21 12a9 9 0 0 0-9-9 9.75 9.75 0 0 0-6.74 2.74L3 8"/><path d="M3 3v5h5"/><path d="M3 12a9 9 0 0 0 9 9 9.75 9.75 0 0 0 6.74-2.74L21 16"/><path d="M16 16h5v5"/></svg>
 </button>
 </div>
 <div class="grid gap-lg mb-lg" id="bento" style="--columns: repeat(4, 1fr) "
-hx-trigger="revealed" hx-get="/__server/!component/card?metric=RPS&metric=P90&metric=P75&metric=P50&metric=total_served&metric=2xx&metric=4xx&metric=5xx" hx-swap="innerHTML">
+hx-trigger="revealed" hx-get="/__server/!component/card?metric=RPS&metric=P90&metric=P75&metric=P50&metric=total_served&metric=2xx&metric=4xx&metric=5xx&metric=TLS_handshake&metric=TLS_resumption" hx-swap="innerHTML">
     <div class="h-full w-full flex center"><span class="big">Loading...</span></div>
 </div>
 <h2>Requests</h2>
@@ -277,6 +278,22 @@ odin::card(http_request &request, path::result) {
         } else if (metric == "5xx") {
             output_ +=
               render(template_, { { "name", "Server Error" }, { "value", std::format("{}", status_code_.server_error.load()) }, { "explanation", "Responses sent with status code 500-599" } });
+        } else if (metric == "TLS_handshake") {
+            const rite::tls_stats &tls = rite::tls_stats::global();
+            output_ += render(template_,
+                              { { "name", "TLS Handshake P50" },
+                                { "value", std::format("{:.1f}ms", tls.handshake_percentile(0.5).count() / 1000.0) },
+                                { "explanation",
+                                  std::format("Accept to finished handshake, P90 {:.1f}ms. {} handshakes, {} failed.",
+                                              tls.handshake_percentile(0.9).count() / 1000.0,
+                                              tls.handshakes(),
+                                              tls.failed_handshakes()) } });
+        } else if (metric == "TLS_resumption") {
+            const rite::tls_stats &tls = rite::tls_stats::global();
+            output_ += render(template_,
+                              { { "name", "TLS Resumption" },
+                                { "value", std::format("{:.1f}%", tls.resumption_rate() * 100) },
+                                { "explanation", std::format("Handshakes that resumed a session (cache or ticket), {} of {}.", tls.resumed_handshakes(), tls.handshakes()) } });
         }
     }
 
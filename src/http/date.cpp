@@ -0,0 +1,112 @@
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+
+#include "http/date.hpp"
+
+namespace {
+
+std::time_t
+now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    return ts.tv_sec;
+}
+
+// The formatted date packed into words and published with a sequence
+// lock, readers never block and never see a torn value.
+class date_cache {
+    static constexpr size_t WORDS = (rite::http::DATE_LENGTH + 7) / 8;
+
+    std::atomic<uint64_t>    sequence_{ 0 };
+    std::atomic<std::time_t> second_{ 0 };
+    std::atomic<uint64_t>    words_[WORDS];
+    std::atomic_flag         writing_;
+
+    void publish(std::time_t second) {
+        uint64_t                words[WORDS] = {};
+        rite::http::date_string date = rite::http::format_date(second);
+        std::memcpy(words, date.data(), date.size());
+
+        sequence_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; ++i)
+            words_[i].store(words[i], std::memory_order_relaxed);
+        sequence_.fetch_add(1, std::memory_order_release);
+        second_.store(second, std::memory_order_release);
+    }
+
+    public:
+    date_cache() {
+        for (auto &word : words_)
+            word.store(0, std::memory_order_relaxed);
+        publish(now());
+    }
+
+    rite::http::date_string get() {
+        std::time_t second = now();
+        // One thread reformats, the others keep serving the previous
+        // second until it is done.
+        if (second != second_.load(std::memory_order_acquire) && !writing_.test_and_set(std::memory_order_acquire)) {
+            if (second != second_.load(std::memory_order_relaxed))
+                publish(second);
+            writing_.clear(std::memory_order_release);
+        }
+
+        uint64_t words[WORDS];
+        uint64_t before, after;
+        do {
+            before = sequence_.load(std::memory_order_acquire);
+            for (size_t i = 0; i < WORDS; ++i)
+                words[i] = words_[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence_.load(std::memory_order_relaxed);
+        } while (before != after || before & 1);
+
+        rite::http::date_string date;
+        std::memcpy(date.data(), words, date.size());
+        return date;
+    }
+};
+
+};
+
+rite::http::date_string
+rite::http::format_date(std::time_t when) {
+    static constexpr char days[7][4] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+    static constexpr char months[12][4] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+
+    struct tm tm;
+    gmtime_r(&when, &tm);
+
+    date_string date;
+    auto        two = [](char *at, int value) {
+        at[0] = '0' + value / 10;
+        at[1] = '0' + value % 10;
+    };
+    char *p = date.data();
+    std::memcpy(p, days[tm.tm_wday], 3);
+    std::memcpy(p + 3, ", ", 2);
+    two(p + 5, tm.tm_mday);
+    p[7] = ' ';
+    std::memcpy(p + 8, months[tm.tm_mon], 3);
+    p[11] = ' ';
+    int year = tm.tm_year + 1900;
+    two(p + 12, year / 100);
+    two(p + 14, year % 100);
+    p[16] = ' ';
+    two(p + 17, tm.tm_hour);
+    p[19] = ':';
+    two(p + 20, tm.tm_min);
+    p[22] = ':';
+    two(p + 23, tm.tm_sec);
+    std::memcpy(p + 25, " GMT", 4);
+    return date;
+}
+
+rite::http::date_string
+rite::http::current_date() {
+    static date_cache cache;
+    return cache.get();
+}
@@ -5,95 +5,221 @@
 #include "connection.hpp"
 #include "http/parser.hpp"
 #include "http/request.hpp"
-#include <iostream>
+#include "http/scan.hpp"
 
-bool
-// parser<http_request>::parse(const std::shared_ptr<connection> &conn, std::span<const std::byte> data, http_request &req) {
-parser<http_request>::parse(connection<void> *conn, std::span<const std::byte> data, http_request &req) {
-    req.client_ = conn;
-    std::string        request_string(reinterpret_cast<const char *>(data.data()), data.size());
-    std::istringstream request_stream(request_string);
-    std::string        line;
+namespace {
 
-    // Parse the request line
-    if (!std::getline(request_stream, line)) {
+constexpr bool
+iequals(std::string_view a, std::string_view lower) {
+    if (a.size() != lower.size())
         return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if ((a[i] >= 'A' && a[i] <= 'Z' ? a[i] | 0x20 : a[i]) != lower[i])
+            return false;
     }
+    return true;
+}
 
-    std::istringstream request_line(line);
-    std::string        method_str;
-    std::string        path;
-    std::string        version;
+};
 
-    // Read method, path, and version
-    if (!(request_line >> method_str >> path >> version)) {
-        return false;
+std::optional<http_method>
+parser<http_request>::decode_method(std::string_view method) {
+    switch (method.size()) {
+    case 3:
+        if (method == "GET")
+            return http_method::GET;
+        if (method == "PUT")
+            return http_method::PUT;
+        break;
+    case 4:
+        if (method == "POST")
+            return http_method::POST;
+        if (method == "HEAD")
+            return http_method::HEAD;
+        break;
+    case 5:
+        if (method == "PATCH")
+            return http_method::PATCH;
+        if (method == "TRACE")
+            return http_method::TRACE;
+        break;
+    case 6:
+        if (method == "DELETE")
+            return http_method::DELETE;
+        break;
+    case 7:
+        if (method == "OPTIONS")
+            return http_method::OPTIONS;
+        if (method == "CONNECT")
+            return http_method::CONNECT;
+        break;
     }
+    return std::nullopt;
+}
 
-    if (version == "HTTP/1.1") {
-        req.version_ = http_version::HTTP_1_1;
-    } else if (version == "HTTP/2.0") {
-        req.version_ = http_version::HTTP_2_0;
-    } else if (version == "HTTP/3.0") {
-        req.version_ = http_version::HTTP_3_0;
-    } else if (version == "HTTP/1.0") {
-        req.version_ = http_version::HTTP_1_0;
-    } else {
-        return false;
-    }
+parser<http_request>::result
+parser<http_request>::parse_head(std::span<const std::byte> data, head &out) {
+    const char *begin = reinterpret_cast<const char *>(data.data());
+    const char *end = begin + std::min(data.size(), MAX_HEAD_SIZE);
+    const char *p = begin;
+    // Running out of data is only fine while we are below the limit
+    const result incomplete = data.size() < MAX_HEAD_SIZE ? result::eIncomplete : result::eInvalid;
 
-    if (path.find('?') != std::string::npos) {
-        query_parameters query = parser<query_parameters>{}.parse(path).value();
-        req.query_ = query;
-    }
+    if (out.parsed == 0) {
+        // Method, upper-case letters only
+        const char *token = p;
+        while (p < end && *p >= 'A' && *p <= 'Z')
+            ++p;
+        if (p == end)
+            return p - token > 7 ? result::eInvalid : incomplete;
+        if (*p != ' ')
+            return result::eInvalid;
 
-    // Set the method
-    if (method_str == "GET") {
-        req.method_ = http_method::GET;
-    } else if (method_str == "HEAD") {
-        req.method_ = http_method::HEAD;
-    } else if (method_str == "POST") {
-        req.method_ = http_method::POST;
-    } else if (method_str == "PUT") {
-        req.method_ = http_method::PUT;
-    } else if (method_str == "DELETE") {
-        req.method_ = http_method::DELETE;
-    } else if (method_str == "CONNECT") {
-        req.method_ = http_method::CONNECT;
-    } else if (method_str == "OPTIONS") {
-        req.method_ = http_method::OPTIONS;
-    } else if (method_str == "TRACE") {
-        req.method_ = http_method::TRACE;
-    } else if (method_str == "PATCH") {
-        req.method_ = http_method::PATCH;
-    } else {
-        return false;
+        auto method = decode_method(std::string_view(token, p - token));
+        if (!method)
+            return result::eInvalid;
+        out.method = *method;
+
+        // Request target, origin-form, absolute-form or asterisk-form
+        token = ++p;
+        while (p < end && (unsigned char)*p > 0x20 && *p != 0x7f)
+            ++p;
+        if (p == end)
+            return incomplete;
+        if (*p != ' ' || p == token)
+            return result::eInvalid;
+        out.target = std::string_view(token, p - token);
+        ++p;
+
+        // Version, only HTTP/1.x is spoken here
+        constexpr std::string_view http11 = "HTTP/1.1\r\n", http10 = "HTTP/1.0\r\n";
+        size_t                     available = std::min<size_t>(end - p, http11.size());
+        std::string_view           version(p, available);
+        if (version != http11.substr(0, available) && version != http10.substr(0, available))
+            return result::eInvalid;
+        if (available < http11.size())
+            return incomplete;
+        out.version = p[7] == '1' ? http_version::HTTP_1_1 : http_version::HTTP_1_0;
+        p += http11.size();
+
+        out.field_count = 0;
+        out.content_length.reset();
+        out.parsed = p - begin;
     }
+    p = begin + out.parsed;
 
-    req.path_ = path;
-
-    // Parse headers
-    while (std::getline(request_stream, line) && (!line.empty() && line != "\r")) {
-        auto colon_pos = line.find(':');
-        if (colon_pos != std::string::npos) {
-            std::string key = line.substr(0, colon_pos);
-            std::string value = line.substr(colon_pos + 1);
-            // Trim whitespace from key and value
-            key.erase(key.find_last_not_of(" \n\r\t") + 1);
-            value.erase(0, value.find_first_not_of(" \n\r\t"));
-            req.headers_[key] = value;
+    // Header fields
+    const char *token;
+    for (;;) {
+        if (p == end)
+            return incomplete;
+        if (*p == '\r') {
+            if (p + 1 == end)
+                return incomplete;
+            if (p[1] != '\n')
+                return result::eInvalid;
+            out.length = p + 2 - begin;
+            return result::eComplete;
         }
+
+        // field-name, anything but a token character (including
+        // whitespace before the colon and obs-fold) is rejected
+        token = p;
+        p = rite::http::scan::token(p, end);
+        if (p == end)
+            return incomplete;
+        if (*p != ':' || p == token)
+            return result::eInvalid;
+        std::string_view name(token, p - token);
+        ++p;
+
+        // OWS field-value OWS CRLF
+        while (p < end && (*p == ' ' || *p == '\t'))
+            ++p;
+        token = p;
+        p = rite::http::scan::field_value(p, end);
+        if (p == end || p + 1 == end)
+            return incomplete;
+        if (p[0] != '\r' || p[1] != '\n')
+            return result::eInvalid;
+        const char *value_end = p;
+        while (value_end > token && (value_end[-1] == ' ' || value_end[-1] == '\t'))
+            --value_end;
+        std::string_view value(token, value_end - token);
+        p += 2;
+
+        if (out.field_count == MAX_HEADERS)
+            return result::eInvalid;
+        out.fields[out.field_count++] = { name, value };
+
+        if (iequals(name, "content-length")) {
+            size_t length = 0;
+            if (value.empty() || value.size() > 18)
+                return result::eInvalid;
+            for (char c : value) {
+                if (c < '0' || c > '9')
+                    return result::eInvalid;
+                length = length * 10 + (c - '0');
+            }
+            // Conflicting lengths are a smuggling attempt
+            if (out.content_length && *out.content_length != length)
+                return result::eInvalid;
+            out.content_length = length;
+        } else if (iequals(name, "transfer-encoding")) {
+            // Chunked request bodies are not supported
+            return result::eInvalid;
+        }
+        out.parsed = p - begin;
     }
+}
 
-    // Read the body if needed (for POST/PUT requests)
-    if (req.method_ == http_method::POST || req.method_ == http_method::PUT) {
-        // Read the remaining data from the request stream as the body
-        std::string body_string((std::istreambuf_iterator<char>(request_stream)), std::istreambuf_iterator<char>());
+void
+parser<http_request>::head::rebase(const std::byte *from, const std::byte *to) {
+    auto move = [from, to](std::string_view &view) {
+        if (view.data() != nullptr)
+            view = std::string_view(reinterpret_cast<const char *>(to) + (view.data() - reinterpret_cast<const char *>(from)), view.size());
+    };
+    move(target);
+    for (size_t i = 0; i < field_count; ++i) {
+        move(fields[i].first);
+        move(fields[i].second);
+    }
+}
 
-        // Convert the string body to std::vector<std::byte>
-        req.body_.resize(body_string.size());
-        std::transform(body_string.begin(), body_string.end(), req.body_.begin(), [](char c) { return static_cast<std::byte>(c); });
+void
+parser<http_request>::build(connection<void> *conn, const head &parsed, std::span<const std::byte> body, http_request &req) {
+    req.client_ = conn;
+    req.method_ = parsed.method;
+    req.version_ = parsed.version;
+
+    size_t query = parsed.target.find('?');
+    if (query != std::string_view::npos) {
+        req.query_ = parser<query_parameters>{}.parse(parsed.target).value();
     }
+    req.path_ = decode_uri_component(std::string(parsed.target.substr(0, query)));
+
+    size_t bytes = 0;
+    for (size_t i = 0; i < parsed.field_count; ++i)
+        bytes += parsed.fields[i].first.size() + parsed.fields[i].second.size();
+    req.headers_.clear();
+    req.headers_.reserve(bytes, parsed.field_count);
+    for (size_t i = 0; i < parsed.field_count; ++i)
+        req.headers_.add(parsed.fields[i].first, parsed.fields[i].second);
+
+    req.body_.assign(body.begin(), body.end());
+}
+
+bool
+parser<http_request>::parse(connection<void> *conn, std::span<const std::byte> data, http_request &req) {
+    head parsed;
+    if (parse_head(data, parsed) != result::eComplete)
+        return false;
+
+    size_t body = parsed.content_length.value_or(0);
+    if (data.size() - parsed.length < body)
+        return false;
+
+    build(conn, parsed, data.subspan(parsed.length, body), req);
     return true;
 }
 
@@ -128,13 +254,21 @@ parser<query_parameters>::parse(std::string_view query_string) {
 
 std::string
 decode_uri_component(const std::string &encoded) {
+    auto hex = [](char c) -> int {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f')
+            return (c | 0x20) - 'a' + 10;
+        return -1;
+    };
+
     std::string decoded;
-    char        ch;
-    size_t      i = 0;
+    decoded.reserve(encoded.size());
+    size_t i = 0;
     while (i < encoded.length()) {
-        if (encoded[i] == '%') {
-            sscanf(encoded.substr(i + 1, 2).c_str(), "%x", (unsigned int *)&ch);
-            decoded += ch;
+        int high, low;
+        if (encoded[i] == '%' && i + 2 < encoded.length() && (high = hex(encoded[i + 1])) >= 0 && (low = hex(encoded[i + 2])) >= 0) {
+            decoded += static_cast<char>(high << 4 | low);
             i += 3; // Skip past the %xx
         } else {
             decoded += encoded[i++];
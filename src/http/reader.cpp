@@ -0,0 +1,64 @@
+#include <algorithm>
+#include <cstring>
+
+#include "http/reader.hpp"
+
+std::span<std::byte>
+rite::http::reader::prepare(size_t min) {
+    if (capacity_ - end_ < min)
+        reserve(min);
+    return std::span<std::byte>(buffer_.get() + end_, capacity_ - end_);
+}
+
+void
+rite::http::reader::reserve(size_t bytes) {
+    const std::byte *from = buffer_.get() + begin_;
+    size_t           pending = end_ - begin_;
+
+    if (pending + bytes <= capacity_) {
+        // Enough room once the consumed requests are dropped
+        std::memmove(buffer_.get(), buffer_.get() + begin_, pending);
+    } else {
+        // Double, in bounded steps, up to the end of the request when
+        // its size is known.  Bodies are only buffered as they arrive.
+        size_t capacity = capacity_ + std::min(capacity_, MAX_GROWTH);
+        if (head_complete_)
+            capacity = std::min(capacity, head_.length + head_.content_length.value_or(0));
+        capacity = std::max(capacity, pending + bytes);
+        auto   buffer = std::make_unique_for_overwrite<std::byte[]>(capacity);
+        if (pending > 0)
+            std::memcpy(buffer.get(), buffer_.get() + begin_, pending);
+        buffer_ = std::move(buffer);
+        capacity_ = capacity;
+    }
+
+    head_.rebase(from, buffer_.get());
+    begin_ = 0;
+    end_ = pending;
+}
+
+rite::http::reader::result
+rite::http::reader::next(connection<void> *connection, http_request &req) {
+    std::span<const std::byte> pending(buffer_.get() + begin_, end_ - begin_);
+    if (!head_complete_) {
+        result r = parser<http_request>{}.parse_head(pending, head_);
+        if (r != result::eComplete)
+            return r;
+        if (head_.content_length.value_or(0) > max_body_)
+            return result::eInvalid;
+        head_complete_ = true;
+    }
+
+    size_t body = head_.content_length.value_or(0);
+    if (pending.size() - head_.length < body)
+        return result::eIncomplete;
+
+    parser<http_request>{}.build(connection, head_, pending.subspan(head_.length, body), req);
+    begin_ += head_.length + body;
+    if (begin_ == end_)
+        begin_ = end_ = 0;
+
+    head_.parsed = 0;
+    head_complete_ = false;
+    return result::eComplete;
+}
@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+#include "http/scan.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define RITE_SCAN_X86 1
+#endif
+
+namespace {
+
+using rite::http::scan::level;
+
+// tchar as of RFC 9110, 5.6.2
+constexpr std::array<bool, 256> TOKEN = []() {
+    std::array<bool, 256> table{};
+    for (int c = '0'; c <= '9'; ++c)
+        table[c] = true;
+    for (int c = 'a'; c <= 'z'; ++c)
+        table[c] = table[c - 'a' + 'A'] = true;
+    for (char c : std::string_view("!#$%&'*+-.^_`|~"))
+        table[(unsigned char)c] = true;
+    return table;
+}();
+
+// field-vchar / obs-text, SP & HTAB
+constexpr bool
+field_value_char(unsigned char c) {
+    return c == '\t' || (c >= 0x20 && c != 0x7f);
+}
+
+const char *
+token_scalar(const char *p, const char *end) {
+    while (p < end && TOKEN[(unsigned char)*p])
+        ++p;
+    return p;
+}
+
+const char *
+field_value_scalar(const char *p, const char *end) {
+    while (p < end && field_value_char(*p))
+        ++p;
+    return p;
+}
+
+#ifdef RITE_SCAN_X86
+// PCMPESTRI can only hold 8 ranges, '~' is left out and handled by the
+// scalar loop we fall back to on every mismatch.
+alignas(16) const char TOKEN_RANGES[16] = { '!', '!', '#', '\'', '*', '+', '-', '.', '0', '9', 'A', 'Z', '^', 'z', '|', '|' };
+alignas(16) const char FIELD_VALUE_INVALID[16] = { 0x00, 0x08, 0x0a, 0x1f, 0x7f, 0x7f };
+
+__attribute__((target("sse4.2"))) const char *
+token_sse42(const char *p, const char *end) {
+    const __m128i ranges = _mm_load_si128(reinterpret_cast<const __m128i *>(TOKEN_RANGES));
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        int     index = _mm_cmpestri(ranges, 16, chunk, 16, _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_MASKED_NEGATIVE_POLARITY | _SIDD_LEAST_SIGNIFICANT);
+        if (index < 16) {
+            p += index;
+            if (!TOKEN[(unsigned char)*p])
+                return p;
+            ++p;
+            continue;
+        }
+        p += 16;
+    }
+    return token_scalar(p, end);
+}
+
+__attribute__((target("sse4.2"))) const char *
+field_value_sse42(const char *p, const char *end) {
+    const __m128i ranges = _mm_load_si128(reinterpret_cast<const __m128i *>(FIELD_VALUE_INVALID));
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        int     index = _mm_cmpestri(ranges, 6, chunk, 16, _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_LEAST_SIGNIFICANT);
+        if (index < 16)
+            return p + index;
+        p += 16;
+    }
+    return field_value_scalar(p, end);
+}
+
+// Set membership via two nibble lookups: LOW[c & 0xf] has bit h set
+// if (h << 4 | c & 0xf) is a tchar, HIGH[c >> 4] is (1 << (c >> 4))
+// for ASCII and 0 otherwise.
+constexpr std::array<uint8_t, 16> TOKEN_LOW = []() {
+    std::array<uint8_t, 16> table{};
+    for (int c = 0; c < 128; ++c) {
+        if (TOKEN[c])
+            table[c & 0xf] |= 1 << (c >> 4);
+    }
+    return table;
+}();
+alignas(16) constexpr uint8_t TOKEN_HIGH[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+__attribute__((target("avx2"))) const char *
+token_avx2(const char *p, const char *end) {
+    const __m256i low = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(TOKEN_LOW.data())));
+    const __m256i high = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i *>(TOKEN_HIGH)));
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    while (end - p >= 32) {
+        __m256i  chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        __m256i  lo = _mm256_shuffle_epi8(low, _mm256_and_si256(chunk, nibble));
+        __m256i  hi = _mm256_shuffle_epi8(high, _mm256_and_si256(_mm256_srli_epi16(chunk, 4), nibble));
+        __m256i  valid = _mm256_and_si256(lo, hi);
+        uint32_t invalid = _mm256_movemask_epi8(_mm256_cmpeq_epi8(valid, _mm256_setzero_si256()));
+        if (invalid)
+            return p + __builtin_ctz(invalid);
+        p += 32;
+    }
+    return token_scalar(p, end);
+}
+
+__attribute__((target("avx2"))) const char *
+field_value_avx2(const char *p, const char *end) {
+    const __m256i control = _mm256_set1_epi8(0x1f);
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i del = _mm256_set1_epi8(0x7f);
+    while (end - p >= 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        // c <= 0x1f (unsigned) && c != HTAB, or c == DEL
+        __m256i  below = _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, control), chunk);
+        __m256i  bad = _mm256_or_si256(_mm256_andnot_si256(_mm256_cmpeq_epi8(chunk, tab), below), _mm256_cmpeq_epi8(chunk, del));
+        uint32_t mask = _mm256_movemask_epi8(bad);
+        if (mask)
+            return p + __builtin_ctz(mask);
+        p += 32;
+    }
+    return field_value_scalar(p, end);
+}
+#endif
+
+struct kernels {
+    level which;
+    const char *(*token)(const char *, const char *);
+    const char *(*field_value)(const char *, const char *);
+};
+
+level
+supported() {
+#ifdef RITE_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return level::eAVX2;
+    if (__builtin_cpu_supports("sse4.2"))
+        return level::eSSE42;
+#endif
+    return level::eScalar;
+}
+
+kernels
+make(level wanted) {
+    wanted = std::min(wanted, supported());
+    switch (wanted) {
+#ifdef RITE_SCAN_X86
+    case level::eAVX2:
+        return kernels{ level::eAVX2, token_avx2, field_value_avx2 };
+    case level::eSSE42:
+        return kernels{ level::eSSE42, token_sse42, field_value_sse42 };
+#endif
+    default:
+        return kernels{ level::eScalar, token_scalar, field_value_scalar };
+    }
+}
+
+kernels &
+active() {
+    static kernels k = make(level::eAVX2);
+    return k;
+}
+
+};
+
+const char *
+rite::http::scan::token(const char *p, const char *end) {
+    return active().token(p, end);
+}
+
+const char *
+rite::http::scan::field_value(const char *p, const char *end) {
+    return active().field_value(p, end);
+}
+
+rite::http::scan::level
+rite::http::scan::current() {
+    return active().which;
+}
+
+rite::http::scan::level
+rite::http::scan::select(level wanted) {
+    active() = make(wanted);
+    return active().which;
+}
@@ -1,45 +1,66 @@
+#include <charconv>
 #include <cstdint>
 #include <cstring>
-#include <sstream>
+#include <string_view>
 #include <vector>
 
+#include "http/date.hpp"
 #include "http/request.hpp"
 #include "http/response.hpp"
 #include "http/serializer.hpp"
+#include "http/status_line.hpp"
 
 std::vector<std::byte>
 serializer<http_response>::operator()(const http_response &response) const {
-    std::vector<std::byte> serialized_data;
+    std::vector<std::byte> serialized_data(512);
+    size_t                 length = (*this)(response, serialized_data);
+    if (length > serialized_data.size()) {
+        serialized_data.resize(length);
+        (*this)(response, serialized_data);
+    }
+    serialized_data.resize(length);
+    return serialized_data;
+}
 
-    // Write the HTTP version
-    const char *http_version = "HTTP/1.1 ";
-    serialized_data.insert(serialized_data.end(), reinterpret_cast<const std::byte *>(http_version), reinterpret_cast<const std::byte *>(http_version) + strlen(http_version));
+size_t
+serializer<http_response>::operator()(const http_response &response, std::span<std::byte> out) const {
+    size_t length = 0;
+    auto   append = [&](std::string_view text) {
+        if (length + text.size() <= out.size())
+            std::memcpy(out.data() + length, text.data(), text.size());
+        length += text.size();
+    };
 
-    // Serialize the status code as a string
-    int                status_code = static_cast<int>(response.status_code());
-    std::ostringstream status_stream;
-    status_stream << status_code << "\r\n";
-    std::string status_code_str = status_stream.str();
-    serialized_data.insert(serialized_data.end(), reinterpret_cast<const std::byte *>(status_code_str.data()), reinterpret_cast<const std::byte *>(status_code_str.data()) + status_code_str.size());
+    std::string_view status = rite::http::status_line(response.status_code());
+    if (!status.empty()) {
+        append(status);
+    } else {
+        // Codes we have no reason phrase for
+        char code[16];
+        auto end = std::to_chars(code, code + sizeof(code), static_cast<int>(response.status_code())).ptr;
+        append("HTTP/1.1 ");
+        append(std::string_view(code, end - code));
+        append(" \r\n");
+    }
 
-    // Serialize the headers
     const header_map &headers = response.headers();
-    for (const auto &[key, value] : headers) {
-        std::string header_line = key + ": " + value + "\r\n";
-        serialized_data.insert(serialized_data.end(), reinterpret_cast<const std::byte *>(header_line.data()), reinterpret_cast<const std::byte *>(header_line.data()) + header_line.size());
+    if (!headers.contains("Date")) {
+        rite::http::date_string date = rite::http::current_date();
+        append("Date: ");
+        append(std::string_view(date.data(), date.size()));
+        append("\r\n");
     }
 
-    // Add a blank line to separate headers from the body
-    serialized_data.push_back(static_cast<std::byte>('\r'));
-    serialized_data.push_back(static_cast<std::byte>('\n'));
-
-    if (serialize_body) {
-        // Serialize the body
-        // const std::vector<std::byte>& body = response.body();
-        // serialized_data.insert(serialized_data.end(), body.begin(), body.end());
+    for (const auto &[key, value] : headers) {
+        append(key);
+        append(": ");
+        append(value);
+        append("\r\n");
     }
 
-    return serialized_data;
+    // Blank line separates the headers from the body
+    append("\r\n");
+    return length;
 }
 
 std::string_view
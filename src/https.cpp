@@ -1,60 +1,90 @@
+#include <array>
 #include <iostream>
 #include <cassert>
 
 #include <openssl/err.h>
+#include <openssl/core_names.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
 #include <openssl/ssl.h>
 #include <protocols/h2.hpp>
 #include <protocols/h2/connection.hpp>
 #include <protocols/https.hpp>
 
+#include <fcntl.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <cstring>
 #include <string>
+#include <tuple>
+#include <vector>
 
 connection<void> *
 rite::server<https>::on_accept(connection<void>::native_handle socket, struct sockaddr_storage addr, socklen_t len) {
-    std::cout << "HTTPS: Got new client" << std::endl;
-    try {
-        ::connection<tls> *connection = new ::connection<tls>(ctx_, socket, addr, len);
-        const uint8_t     *alpn;
-        uint32_t           alpn_len;
-        SSL_get0_alpn_selected(connection->ssl(), &alpn, &alpn_len);
-
-        // If alpn[0..2] == "h2", we move the TLS connection into
-        // connection<h2>
-        if (alpn_len >= 2 && memcmp(alpn, "h2", 2) == 0) {
-            // Upgrade the connection to HTTP2
-            auto *http2 = new ::connection<h2::protocol>(std::move(*connection));
-            delete connection;
-            return http2;
-        } else {
-            // Return a plain HTTP connection
-        }
-        return connection;
-    } catch (std::exception &e) {
-        std::cerr << "TLS handshake failed: " << e.what() << std::endl;
-        return nullptr;
+    // The handshake is driven by readiness events on the reactor, a slow
+    // client must not block it.
+    fcntl(socket, F_SETFL, fcntl(socket, F_GETFL) | O_NONBLOCK);
+    return new ::connection<tls>(ctx_, socket, addr, len);
+}
+
+connection<void> *
+rite::server<https>::on_handshake(connection<void> *socket) {
+    auto          *connection = static_cast<::connection<tls> *>(socket);
+    const uint8_t *alpn;
+    uint32_t       alpn_len;
+    SSL_get0_alpn_selected(connection->ssl(), &alpn, &alpn_len);
+
+    // If alpn[0..2] == "h2", we move the TLS connection into
+    // connection<h2>
+    if (alpn_len >= 2 && memcmp(alpn, "h2", 2) == 0) {
+        // Upgrade the connection to HTTP2
+        h2::settings local;
+        local.max_concurrent_streams = config_.max_concurrent_streams_;
+        local.max_header_list_size = config_.max_header_list_size_;
+        auto *http2 = new ::connection<h2::protocol>(std::move(*connection), local);
+        http2->parameters_->max_body_size = config_.max_body_size_;
+        http2->expect_preface(config_.header_timeout_);
+        delete connection;
+        return http2;
     }
+
+    // http/1.1 or no ALPN at all
+    auto *http11 = new ::connection<http1<tls>>(std::move(*connection));
+    http11->reader.max_body_size(config_.max_body_size_);
+    http11->head_timeout = config_.header_timeout_;
+    delete connection;
+    return http11;
 }
 
 void
 rite::server<https>::on_read(connection<void> *socket) {
+    if (auto *http11 = dynamic_cast<connection<http1<tls>> *>(socket)) {
+        rite::http::serve(http11, *config_.behaviour_);
+        return;
+    }
+
     static thread_local std::unique_ptr<std::byte[]> buffer = std::make_unique<std::byte[]>(65535);
     while(true) {
         ssize_t bytes = 0;
         {
             auto lock_ = socket->lock();
             bytes = socket->read(std::span<std::byte>(buffer.get(), 65535), 0);
-            if (bytes == 0) {
-                // EOF
-                socket->release();
+        }
+        if (bytes == 0) {
+            // EOF
+            // Close before releasing our reference, the reactor may reclaim
+            // the connection as soon as it is unreferenced.  Terminating h2
+            // also wakes up writers waiting for flow control credit.
+            if (auto *h2_sock = dynamic_cast<connection<h2::protocol> *>(socket))
+                h2_sock->terminate();
+            else
                 socket->close();
-                return;
-            }else if(bytes < 0) {
-                // TODO: Check for actual errors (i.e. EAGAIN | EWOULDBLOCK)
-                socket->release();
-                return;
-            }
+            socket->release();
+            return;
+        }else if(bytes < 0) {
+            // TODO: Check for actual errors (i.e. EAGAIN | EWOULDBLOCK)
+            socket->release();
+            return;
         }
 
         connection<h2::protocol> *h2_sock = dynamic_cast<connection<h2::protocol> *>(socket);
@@ -74,68 +104,10 @@ rite::server<https>::on_read(connection<void> *socket) {
 
                         // Take up a new reference for the handler
                         socket->take();
-                        config_.behaviour_->handle(request, [this, &request, h2_sock, stream_id](http_response &&response) {
-                            std::vector<h2::hpack::header> headers_;
-                            headers_.push_back(h2::hpack::header{ ":status", std::to_string(static_cast<int>(response.status_code())) });
-                            for (auto const &[k, v] : response.headers()) {
-                                headers_.push_back(h2::hpack::header{ k, v });
-                            }
-                            h2_sock->parameters_->hpack.tx.serialize(headers_);
-                            auto preload = h2_sock->parameters_->hpack.tx.finish(stream_id);
-
-                            {
-                                auto lock_ = h2_sock->lock();
-                                h2_sock->write(preload);
-                            }
-                            rite::buffer                            buf;
-                            std::shared_ptr<jt::mpsc<rite::buffer>> channel = response.channel;
-                            jt::mpsc<rite::buffer>::consumer       &rx = channel->rx();
-                            do {
-                                response.trigger(http_response::event::chunk);
-                                buf = rx.wait();
-
-                                // Further slice up the user's chunks
-                                // to satisfy the HTTP/2 streams max size.
-                                // TODO: Get actual max size from HTTP/2 stream
-                                ssize_t total_length = buf.len;
-                                ssize_t offset = 0;
-
-                                while (offset < total_length) {
-                                    // Calculate the size of the current slice
-                                    ssize_t slice_size = std::min(static_cast<ssize_t>(16384), total_length - offset);
-
-                                    // Create a frame for the current slice
-                                    h2::frame frame;
-                                    frame.stream_identifier = stream_id;
-                                    frame.type = h2::frame::DATA;
-                                    // Set END_STREAM when we're on the last buffer and reached the last slice.
-                                    frame.flags = (offset + slice_size >= total_length && buf.last) ? h2::frame::characteristics<h2::frame::DATA>::END_STREAM : 0;
-                                    frame.length = slice_size;
-
-                                    // Copy the slice data into the frame
-                                    // TODO: Urgh. I'm not a fan of copying
-                                    // here. We could to some pointer
-                                    // gymnastics to be copy-free.
-                                    frame.data = std::vector<std::byte>(buf.data.get() + offset, buf.data.get() + offset + slice_size);
-
-                                    // Write the frame to the socket
-                                    auto lock_ = h2_sock->lock();
-                                    auto result = h2_sock->write(frame);
-                                    if (result < 0) {
-                                        // TODO: Handle properly.
-                                        SSL_get_error(h2_sock->ssl(), result);
-                                        response.trigger(http_response::event::finish);
-                                        throw std::runtime_error("failed to write data to sock");
-                                    }
-                                    // Update the offset for the next slice
-                                    offset += slice_size;
-                                }
-                            } while (!buf.last);
-                            response.trigger(http_response::event::finish);
-
+                        config_.behaviour_->handle(std::move(request), [h2_sock, stream_id](http_response &&response) {
+                            h2_sock->respond(stream_id, std::move(response));
                             // Release reference to allow the connection to drop
                             h2_sock->release();
-                            h2_sock->streams_[stream_id].state = h2::stream::closed;
                         });
                     }
                 }
@@ -147,10 +119,11 @@ rite::server<https>::on_read(connection<void> *socket) {
                 // Probably eNoEndpoint (404)
             }
         } else {
-            std::print("HTTPS socket that is not HTTP/2. Not supported\n");
-            std::exit(1);
+            // Every handshaken connection is either h2 or http/1.1
+            socket->close();
+            socket->release();
+            return;
         }
-        socket->release();
     }
 }
 
@@ -172,7 +145,103 @@ rite::server<https>::server(const config &server_config)
         SSL_CTX_free(ctx_);
         throw std::runtime_error("Failed to read TLS private key");
     }
+    if (config_.ktls_) {
+#ifdef SSL_OP_ENABLE_KTLS
+        SSL_CTX_set_options(ctx_, SSL_OP_ENABLE_KTLS);
+#else
+        std::print("HTTPS: kTLS requested but not supported by this OpenSSL, encrypting in userspace\n");
+#endif
+    }
+    // Session resumption: stateful sessions live in our sharded cache
+    // (OpenSSL's internal one is a single locked list), tickets are
+    // encrypted with our rotating keys.
+    SSL_CTX_set_app_data(ctx_, this);
+    sessions_ = std::make_unique<rite::session_cache>(config_.session_cache_size_, config_.session_ttl_);
+    SSL_CTX_set_session_cache_mode(ctx_, SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL);
+    SSL_CTX_set_timeout(ctx_, config_.session_ttl_.count());
+    SSL_CTX_set_session_id_context(ctx_, reinterpret_cast<const unsigned char *>("rite"), 4);
+    SSL_CTX_sess_set_new_cb(ctx_, &server<https>::new_session);
+    SSL_CTX_sess_set_get_cb(ctx_, &server<https>::get_session);
+    SSL_CTX_sess_set_remove_cb(ctx_, &server<https>::remove_session);
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    tickets_ = std::make_unique<rite::ticket_keys>(config_.ticket_rotation_);
+    SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx_, &server<https>::ticket_key);
+#endif
+
+    // Sockets are non-blocking, SSL_write may write partially and be
+    // retried from a different buffer.
+    SSL_CTX_set_mode(ctx_, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
     const unsigned char alpn[] = "\x02\x68\x32"; // H2 (HTTP/2) ALPN identifier
     SSL_CTX_set_alpn_protos(ctx_, alpn, sizeof(alpn) - 1);
     SSL_CTX_set_alpn_select_cb(ctx_, &alpn_select_cb, NULL);
 }
+
+int
+rite::server<https>::new_session(SSL *ssl, SSL_SESSION *session) {
+    auto        *self = static_cast<server<https> *>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+    unsigned int length;
+    const auto  *id = SSL_SESSION_get_id(session, &length);
+
+    int size = i2d_SSL_SESSION(session, nullptr);
+    if (size <= 0)
+        return 0;
+    std::vector<uint8_t> serialized(size);
+    unsigned char       *out = serialized.data();
+    i2d_SSL_SESSION(session, &out);
+    self->sessions_->insert(std::string_view(reinterpret_cast<const char *>(id), length), std::move(serialized));
+    // We hold no reference to `session`
+    return 0;
+}
+
+SSL_SESSION *
+rite::server<https>::get_session(SSL *ssl, const unsigned char *id, int length, int *copy) {
+    auto *self = static_cast<server<https> *>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+    *copy = 0;
+
+    auto serialized = self->sessions_->find(std::string_view(reinterpret_cast<const char *>(id), length));
+    if (!serialized)
+        return nullptr;
+    const unsigned char *in = serialized->data();
+    return d2i_SSL_SESSION(nullptr, &in, serialized->size());
+}
+
+void
+rite::server<https>::remove_session(SSL_CTX *ctx, SSL_SESSION *session) {
+    auto        *self = static_cast<server<https> *>(SSL_CTX_get_app_data(ctx));
+    unsigned int length;
+    const auto  *id = SSL_SESSION_get_id(session, &length);
+    self->sessions_->erase(std::string_view(reinterpret_cast<const char *>(id), length));
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+int
+rite::server<https>::ticket_key(SSL *ssl, unsigned char *name, unsigned char *iv, EVP_CIPHER_CTX *cipher, EVP_MAC_CTX *mac, int encrypt) {
+    auto *self = static_cast<server<https> *>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+
+    rite::ticket_keys::key key;
+    bool                   current = true;
+    if (encrypt) {
+        key = self->tickets_->current();
+        std::memcpy(name, key.name.data(), key.name.size());
+        if (RAND_bytes(iv, EVP_MAX_IV_LENGTH) != 1)
+            return -1;
+    } else {
+        auto found = self->tickets_->find(name);
+        // Unknown (or retired) key, fall back to a full handshake
+        if (!found)
+            return 0;
+        std::tie(key, current) = *found;
+    }
+
+    OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, key.hmac.data(), key.hmac.size()),
+        OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, const_cast<char *>("SHA256"), 0),
+        OSSL_PARAM_construct_end(),
+    };
+    if (EVP_CipherInit_ex(cipher, EVP_aes_256_cbc(), nullptr, key.aes.data(), iv, encrypt) != 1 || EVP_MAC_CTX_set_params(mac, params) != 1)
+        return -1;
+    // Tickets of the previous key are renewed
+    return current ? 1 : 2;
+}
+#endif
@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cstring>
 #include <mutex>
@@ -7,6 +8,7 @@
 #include <protocols/h2/connection.hpp>
 #include <stdexcept>
 #include <sys/socket.h>
+#include <unistd.h>
 
 #include <netdb.h>
 #include <netinet/in.h>
@@ -115,6 +117,12 @@ connection<h2::protocol>::process(std::span<const std::byte>::iterator &pos, std
                 terminate();
                 return result::eInvalid;
             }
+            if (!apply_settings(*settings)) {
+                terminate();
+                return result::eInvalid;
+            }
+            cancel_timeout(preface_timer_);
+            preface_timer_ = rite::timer_wheel::invalid;
 
             /*
               The server connection preface consists of a potentially empty
@@ -126,9 +134,11 @@ connection<h2::protocol>::process(std::span<const std::byte>::iterator &pos, std
               connection preface.
              */
 
-            // Send our preface (our settings)
-            h2::frame response{ .length = 0, .type = h2::frame::type::SETTINGS, .flags = 0, .stream_identifier = 0x0 };
-            write(response);
+            // Send our preface (our settings), then acknowledge theirs
+            auto      local = parameters_->local.pack();
+            h2::frame response{ .length = static_cast<uint32_t>(local.size()), .type = h2::frame::type::SETTINGS, .flags = 0, .stream_identifier = 0x0 };
+            write(response, local);
+            write(h2::frame{ .length = 0, .type = h2::frame::type::SETTINGS, .flags = h2::frame::characteristics<h2::frame::SETTINGS>::ACK, .stream_identifier = 0x0 });
 
             /*
               To avoid unnecessary latency, clients are permitted to send
@@ -149,7 +159,6 @@ connection<h2::protocol>::process(std::span<const std::byte>::iterator &pos, std
                 return result::eInvalid;
             }
 
-            streams_[frame->stream_identifier].stream_id = frame->stream_identifier;
             switch (frame->type) {
                 case h2::frame::type::SETTINGS: {
                     // Client likely acknowledged our settings.
@@ -157,6 +166,10 @@ connection<h2::protocol>::process(std::span<const std::byte>::iterator &pos, std
                     // thus we handle it as though optional.
                     if ((frame->flags & h2::frame::characteristics<h2::frame::SETTINGS>::ACK) == 1) {
                     } else {
+                        if (frame->length % 6 != 0 || !apply_settings(*frame)) {
+                            terminate();
+                            return result::eInvalid;
+                        }
                         // We have to re-send ACK
                         h2::frame response{ .length = 0, .type = h2::frame::type::SETTINGS, .flags = h2::frame::characteristics<h2::frame::SETTINGS>::ACK, .stream_identifier = 0x0 };
                         write(response);
@@ -175,15 +188,28 @@ connection<h2::protocol>::process(std::span<const std::byte>::iterator &pos, std
                     return result::eSettings;
                 }
                 case h2::frame::type::WINDOW_UPDATE: {
-                    // Flow control:
-                    // TODO: We do not support flow control /yet/. I may add this in the future
+                    if (frame->length != 4) {
+                        terminate();
+                        return result::eInvalid;
+                    }
+                    uint32_t increment = ((static_cast<uint32_t>(frame->data[0]) << 24) | (static_cast<uint32_t>(frame->data[1]) << 16) | (static_cast<uint32_t>(frame->data[2]) << 8) | static_cast<uint32_t>(frame->data[3])) & 0x7fffffff;
+                    // A zero increment is a PROTOCOL_ERROR, overflowing a
+                    // window a FLOW_CONTROL_ERROR.  We have no stream level
+                    // error handling, both end the connection.
+                    if (increment == 0 || !flow_.credit(frame->stream_identifier, increment)) {
+                        terminate();
+                        return result::eInvalid;
+                    }
+                    credit_.notify_all();
                     return result::eSettings;
                 }
                 case h2::frame::type::CONTINUATION:
                     __attribute__((fallthrough));
                 case h2::frame::type::HEADERS: {
                     // Automatically provisions the steam ID for us,
+                    streams_[frame->stream_identifier].stream_id = frame->stream_identifier;
                     streams_[frame->stream_identifier].state = h2::stream::open;
+                    last_stream_ = std::max(last_stream_, frame->stream_identifier);
 
                     auto result = parameters_->hpack.rx.parse(*frame);
                     switch (result) {
@@ -209,9 +235,25 @@ connection<h2::protocol>::process(std::span<const std::byte>::iterator &pos, std
                             auto &headers = streams_[frame->stream_identifier].headers;
                             headers = std::move(parameters_->hpack.rx.result());
 
+                            // Enforce the limits we announced.  The block had to be
+                            // decoded anyway, it updates the HPACK state.
+                            size_t list_size = 0;
+                            for (auto const &header : headers)
+                                list_size += header.key.size() + header.value.size() + 32;
+                            if (list_size > parameters_->local.max_header_list_size) {
+                                reset(frame->stream_identifier, h2::error_code::PROTOCOL_ERROR);
+                                return result::eMore;
+                            }
+                            if (!flow_.contains(frame->stream_identifier)) {
+                                if (flow_.size() >= parameters_->local.max_concurrent_streams) {
+                                    reset(frame->stream_identifier, h2::error_code::REFUSED_STREAM);
+                                    return result::eMore;
+                                }
+                                flow_.open(frame->stream_identifier);
+                            }
+
                             if ((frame->flags & h2::frame::characteristics<h2::frame::HEADERS>::END_STREAM) == 0) {
                                 // Remote will send a request body. We'll have to wait for that.
-                                std::print("H2[handle]: Missing END_STREAM, waiting for data...\n");
                                 return result::eMore;
                             }
                             // Otherwise transition stream to
@@ -227,17 +269,35 @@ connection<h2::protocol>::process(std::span<const std::byte>::iterator &pos, std
                 }
                 case h2::frame::type::DATA: {
                     // Requires an active stream that has headers.
-                    if (!streams_.contains(frame->stream_identifier)) {
+                    if (frame->stream_identifier == 0 || frame->stream_identifier > last_stream_) {
                         std::print("Terminating HTTP/2 connection. Client sent data on non-existant stream.\n");
                         terminate();
                         return result::eInvalid;
                     }
 
+                    // The whole frame counts against the windows, padding
+                    // included.
+                    if (!flow_.received(frame->stream_identifier, frame->length)) {
+                        go_away(h2::error_code::FLOW_CONTROL_ERROR);
+                        terminate();
+                        return result::eInvalid;
+                    }
+                    bool ended = (frame->flags & h2::frame::characteristics<h2::frame::DATA>::END_STREAM) != 0;
+                    update_windows(frame->stream_identifier, ended);
+
+                    // Still in flight for a stream that was reset (or
+                    // refused), only the connection window cares.
+                    if (!flow_.contains(frame->stream_identifier) || !streams_.contains(frame->stream_identifier))
+                        return result::eMore;
+
                     auto &stream = streams_[frame->stream_identifier];
+                    if (stream.data.size() + frame->data.size() > parameters_->max_body_size) {
+                        reset(frame->stream_identifier, h2::error_code::CANCEL);
+                        return result::eMore;
+                    }
                     stream.data.insert(stream.data.end(), frame->data.begin(), frame->data.end());
 
-                    if ((frame->flags & h2::frame::characteristics<h2::frame::DATA>::END_STREAM) != 0) {
-                        std::print("Stream {} was terminated with data\n", frame->stream_identifier);
+                    if (ended) {
                         // Handle the request, we parsed its body.
                         request = finish_stream(streams_[frame->stream_identifier]);
                         return result::eNewRequest;
@@ -245,7 +305,11 @@ connection<h2::protocol>::process(std::span<const std::byte>::iterator &pos, std
                     return result::eMore;
                 }
                 case h2::frame::type::RST_STREAM: {
-                    streams_[frame->stream_identifier].state = h2::stream::closed;
+                    if (auto stream = streams_.find(frame->stream_identifier); stream != streams_.end())
+                        stream->second.state = h2::stream::closed;
+                    // Wakes up writers of the stream, they give up
+                    flow_.close(frame->stream_identifier);
+                    credit_.notify_all();
                     return result::eMore;
                 }
                 default: {
@@ -265,12 +329,202 @@ connection<h2::protocol>::process(std::span<const std::byte>::iterator &pos, std
 
 int
 connection<h2::protocol>::write(const h2::frame &frame) {
+    return write(frame, frame.data);
+}
+
+int
+connection<h2::protocol>::write(const h2::frame &frame, std::span<const std::byte> payload) {
+    std::unique_lock<std::mutex> writing(writing_);
+    return write(writing, frame, payload);
+}
+
+int
+connection<h2::protocol>::write(std::unique_lock<std::mutex> &, const h2::frame &frame, std::span<const std::byte> payload) {
     std::array<std::byte, HTTP2_FRAME_SIZE> data_;
     frame.pack(data_);
 
-    int total = write(data_, MSG_MORE);
-    total += write(frame.data, 0);
-    return total;
+    // Header and payload go out as one record
+    struct iovec buffers[2] = {
+        { .iov_base = data_.data(), .iov_len = data_.size() },
+        { .iov_base = const_cast<std::byte *>(payload.data()), .iov_len = payload.size() },
+    };
+    return write_all(buffers, 0);
+}
+
+size_t
+connection<h2::protocol>::reserve(std::unique_lock<std::mutex> &lock, h2::stream_id stream, size_t wanted) {
+    size_t granted = 0;
+    credit_.wait_for(lock, keep_alive_, [&]() { return is_closed() || !flow_.contains(stream) || (granted = flow_.sendable(stream, wanted)) > 0; });
+    if (is_closed())
+        return 0;
+    flow_.sent(stream, granted);
+    return granted;
+}
+
+bool
+connection<h2::protocol>::apply_settings(const h2::frame &settings) {
+    auto &peer = parameters_->peer;
+    if (peer.apply(settings.data) != h2::settings::error::eNone)
+        return false;
+
+    // Stream windows follow SETTINGS_INITIAL_WINDOW_SIZE, parked writers
+    // may be able to continue.
+    if (!flow_.initial_window_size(peer.initial_window_size))
+        return false;
+    credit_.notify_all();
+    parameters_->hpack.tx.max_table_size(peer.header_table_size);
+    return true;
+}
+
+void
+connection<h2::protocol>::update_windows(h2::stream_id stream, bool ended) {
+    auto [connection, stream_increment] = flow_.updates(stream, ended);
+    if (connection == 0 && stream_increment == 0)
+        return;
+
+    // Both updates go out in a single write
+    std::array<std::byte, 2 * (HTTP2_FRAME_SIZE + 4)> data_;
+    size_t                                            length = 0;
+    auto                                              update = [&](h2::stream_id id, uint32_t increment) {
+        h2::frame frame{ .length = 4, .type = h2::frame::WINDOW_UPDATE, .flags = 0, .stream_identifier = id };
+        frame.pack(std::span<std::byte>(data_).subspan(length, HTTP2_FRAME_SIZE));
+        length += HTTP2_FRAME_SIZE;
+        for (int shift = 24; shift >= 0; shift -= 8)
+            data_[length++] = static_cast<std::byte>((increment >> shift) & 0xFF);
+    };
+    if (connection > 0)
+        update(0, connection);
+    if (stream_increment > 0)
+        update(stream, stream_increment);
+    std::lock_guard<std::mutex> writing(writing_);
+    write_all(std::span<const std::byte>(data_.data(), length), 0);
+}
+
+void
+connection<h2::protocol>::respond(h2::stream_id stream, http_response &&response) {
+    std::vector<h2::hpack::header> headers;
+    headers.push_back(h2::hpack::header{ ":status", std::to_string(static_cast<int>(response.status_code())) });
+    for (auto const &[k, v] : response.headers())
+        headers.push_back(h2::hpack::header{ k, v });
+    {
+        // The encoder's dynamic table changes with every block, blocks
+        // go out in the order they are encoded: the write lock is taken
+        // before the connection lock is let go.
+        auto guard_ = unique_lock();
+        parameters_->hpack.tx.serialize(headers);
+        h2::frame                    block = parameters_->hpack.tx.finish(stream);
+        std::unique_lock<std::mutex> writing(writing_);
+        guard_.unlock();
+        write(writing, block, block.data);
+    }
+
+    // Cleared once the stream was reset, the connection closed or the
+    // peer kept the window shut, nothing more is sent.
+    bool open = true;
+    auto data = [&](std::span<const std::byte> payload, bool last) {
+        if (!open || (payload.empty() && !last))
+            return;
+        do {
+            auto   lock_ = unique_lock();
+            size_t slice = 0;
+            if (!payload.empty()) {
+                slice = reserve(lock_, stream, std::min<size_t>(parameters_->peer.max_frame_size, payload.size()));
+                if (slice == 0) {
+                    // Still open if the window just never opened, let the
+                    // peer know we gave up.
+                    if (!is_closed() && flow_.contains(stream))
+                        reset(stream, h2::error_code::CANCEL);
+                    open = false;
+                    return;
+                }
+            }
+            h2::frame frame;
+            frame.stream_identifier = stream;
+            frame.type = h2::frame::DATA;
+            // Set END_STREAM on the last slice of the last buffer.
+            frame.flags = (slice == payload.size() && last) ? h2::frame::characteristics<h2::frame::DATA>::END_STREAM : 0;
+            frame.length = slice;
+
+            // The credit is ours, reading goes on while the frame is out
+            lock_.unlock();
+            if (write(frame, payload.first(slice)) < 0) {
+                // The connection broke
+                std::print("H2: writing DATA of stream {} failed\n", stream);
+                terminate();
+                open = false;
+                return;
+            }
+            payload = payload.subspan(slice);
+        } while (!payload.empty());
+    };
+
+    if (const auto &file = response.file()) {
+        // Bounded windows of the file whatever frame size the peer takes,
+        // on the stack for small files.
+        constexpr size_t             WINDOW = 64 * 1024;
+        std::array<std::byte, 16384> stack;
+        std::unique_ptr<std::byte[]> heap;
+        std::span<std::byte>         window(stack);
+        off_t                        offset = file->offset();
+        size_t                       left = file->length();
+        if (left > stack.size()) {
+            heap = std::make_unique_for_overwrite<std::byte[]>(std::min(WINDOW, left));
+            window = std::span<std::byte>(heap.get(), std::min(WINDOW, left));
+        }
+        do {
+            ssize_t bytes = pread(file->fd(), window.data(), std::min(left, window.size()), offset);
+            if (bytes < 0 || (bytes == 0 && left > 0)) {
+                // The body can't be completed, only this stream ends.
+                std::print("H2: reading file body of stream {} failed\n", stream);
+                auto guard_ = lock();
+                reset(stream, h2::error_code::INTERNAL_ERROR);
+                break;
+            }
+            offset += bytes;
+            left -= bytes;
+            data(std::span<const std::byte>(window.data(), bytes), left == 0);
+        } while (left > 0 && open);
+    } else {
+        rite::buffer                            buf;
+        std::shared_ptr<jt::mpsc<rite::buffer>> channel = response.channel;
+        jt::mpsc<rite::buffer>::consumer       &rx = channel->rx();
+        do {
+            response.trigger(http_response::event::chunk);
+            buf = rx.wait();
+            data(std::span<const std::byte>(buf.data.get(), buf.len), buf.last);
+        } while (!buf.last && open);
+    }
+    response.trigger(http_response::event::finish);
+
+    auto guard_ = lock();
+    streams_.erase(stream);
+    flow_.close(stream);
+}
+
+void
+connection<h2::protocol>::reset(h2::stream_id stream, h2::error_code error) {
+    std::vector<std::byte> code(4);
+    for (int i = 0; i < 4; ++i)
+        code[i] = static_cast<std::byte>((static_cast<uint32_t>(error) >> (24 - 8 * i)) & 0xFF);
+    write(h2::frame{ .length = 4, .type = h2::frame::RST_STREAM, .flags = 0, .stream_identifier = stream, .data = std::move(code) });
+    streams_.erase(stream);
+    flow_.close(stream);
+}
+
+void
+connection<h2::protocol>::go_away(h2::error_code error) {
+    std::vector<std::byte> data(8);
+    for (int i = 0; i < 4; ++i) {
+        data[i] = static_cast<std::byte>(((last_stream_ & 0x7FFFFFFF) >> (24 - 8 * i)) & 0xFF);
+        data[4 + i] = static_cast<std::byte>((static_cast<uint32_t>(error) >> (24 - 8 * i)) & 0xFF);
+    }
+    write(h2::frame{ .length = 8, .type = h2::frame::GOAWAY, .flags = 0, .stream_identifier = 0, .data = std::move(data) });
+}
+
+void
+connection<h2::protocol>::expect_preface(microseconds after) {
+    auto guard_ = lock();
+    preface_timer_ = timeout(after, [](connection<void> *slow) { slow->close(); });
 }
 
 void
@@ -282,6 +536,8 @@ connection<h2::protocol>::terminate() {
       preface indicates that the peer is not using HTTP/2.
     */
     close();
+    // Parked writers give up
+    credit_.notify_all();
 }
 
 #include <cctype>
@@ -368,8 +624,7 @@ connection<h2::protocol>::finish_stream(h2::stream &stream) {
     }
 
     for (auto const &header : stream.headers) {
-        // TODO: Headers are not unique.
-        rval.headers_[header.key] = header.value;
+        rval.headers_.add(header.key, header.value);
     }
 
     rval.version_ = http_version::HTTP_2_0;
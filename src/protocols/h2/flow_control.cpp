@@ -0,0 +1,71 @@
+#include <algorithm>
+#include <protocols/h2/flow_control.hpp>
+
+void
+h2::flow_control::open(stream_id stream) {
+    streams_.try_emplace(stream, windows{ .send = { .available = initial_window_ }, .receive = {} });
+}
+
+void
+h2::flow_control::close(stream_id stream) {
+    streams_.erase(stream);
+}
+
+size_t
+h2::flow_control::sendable(stream_id stream, size_t wanted) const {
+    auto it = streams_.find(stream);
+    if (it == streams_.end())
+        return 0;
+    int64_t window = std::min(send_.available, it->second.send.available);
+    if (window <= 0)
+        return 0;
+    return std::min<size_t>(wanted, window);
+}
+
+void
+h2::flow_control::sent(stream_id stream, size_t bytes) {
+    send_.available -= bytes;
+    if (auto it = streams_.find(stream); it != streams_.end())
+        it->second.send.available -= bytes;
+}
+
+bool
+h2::flow_control::credit(stream_id stream, uint32_t increment) {
+    if (stream == 0)
+        return send_.credit(increment);
+    auto it = streams_.find(stream);
+    return it == streams_.end() || it->second.send.credit(increment);
+}
+
+bool
+h2::flow_control::initial_window_size(uint32_t size) {
+    if (size > MAX_WINDOW_SIZE)
+        return false;
+    // Only stream windows follow the setting, the connection window
+    // changes through WINDOW_UPDATE alone.
+    int64_t delta = static_cast<int64_t>(size) - initial_window_;
+    initial_window_ = size;
+    for (auto &[id, stream] : streams_) {
+        stream.send.available += delta;
+        if (stream.send.available > MAX_WINDOW_SIZE)
+            return false;
+    }
+    return true;
+}
+
+bool
+h2::flow_control::received(stream_id stream, uint32_t bytes) {
+    if (!receive_.receive(bytes))
+        return false;
+    auto it = streams_.find(stream);
+    return it == streams_.end() || it->second.receive.receive(bytes);
+}
+
+std::pair<uint32_t, uint32_t>
+h2::flow_control::updates(stream_id stream, bool ended) {
+    uint32_t connection = receive_.update();
+    auto     it = streams_.find(stream);
+    if (ended || it == streams_.end())
+        return { connection, 0 };
+    return { connection, it->second.receive.update() };
+}
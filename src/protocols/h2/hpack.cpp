@@ -1,6 +1,7 @@
 #include "protocols/h2/hpack.hpp"
 #include "protocols/h2/headers.hpp"
 #include <algorithm>
+#include <array>
 #include <cstdint>
 
 #include <iostream>
@@ -13,6 +14,75 @@ to_lower(std::string data) {
     return data;
 }
 
+namespace {
+// Append `value` as a string literal, Huffman coded unless that is not
+// shorter (RFC 7541 5.2).  The length is known up front, the codec
+// writes straight into `payload`.
+void
+append_string(std::vector<std::byte> &payload, std::string_view value) {
+    size_t coded = h2::hpack::codec.encoded_length(value);
+    bool   huffman = coded < value.size();
+    auto   prefix = h2::variable_integer<7>::encode(huffman ? coded : value.size());
+    if (huffman)
+        prefix[0] |= static_cast<std::byte>(0b1000'0000);
+    payload.insert(payload.end(), prefix.begin(), prefix.end());
+
+    if (huffman) {
+        payload.resize(payload.size() + coded);
+        h2::hpack::codec.encode_into(value, std::span<std::byte>(payload).last(coded));
+    } else {
+        auto raw = reinterpret_cast<const std::byte *>(value.data());
+        payload.insert(payload.end(), raw, raw + value.size());
+    }
+}
+
+// Dynamic Table Size Update (RFC 7541 6.3)
+void
+append_size_update(std::vector<std::byte> &payload, size_t size) {
+    auto wire = h2::variable_integer<5>::encode(size);
+    wire[0] |= static_cast<std::byte>(0b0010'0000);
+    payload.insert(payload.end(), wire.begin(), wire.end());
+}
+
+// Values that hardly ever repeat across responses
+constexpr std::array<std::string_view, 5> VOLATILE_NAMES = { "content-length", "content-range", "etag", "last-modified", "age" };
+
+bool
+indexable(std::string_view key, std::string_view value, size_t max_size) {
+    // An entry taking up most of the table would flush it every time
+    if (key.size() + value.size() + h2::hpack::ENTRY_OVERHEAD > max_size * 3 / 4)
+        return false;
+    return std::find(VOLATILE_NAMES.begin(), VOLATILE_NAMES.end(), key) == VOLATILE_NAMES.end();
+}
+};
+
+void
+h2::dynamic_table::insert(std::string key, std::string value) {
+    size_t size = key.size() + value.size() + h2::hpack::ENTRY_OVERHEAD;
+    if (size > max_size_) {
+        evict(0);
+        return;
+    }
+    evict(max_size_ - size);
+    size_ += size;
+    entries_.push_front(h2::hpack::header{ std::move(key), std::move(value) });
+}
+
+void
+h2::dynamic_table::resize(size_t max_size) {
+    max_size_ = max_size;
+    evict(max_size_);
+}
+
+void
+h2::dynamic_table::evict(size_t limit) {
+    while (size_ > limit) {
+        auto const &oldest = entries_.back();
+        size_ -= oldest.key.size() + oldest.value.size() + h2::hpack::ENTRY_OVERHEAD;
+        entries_.pop_back();
+    }
+}
+
 h2::hpack::error
 parser<h2::hpack>::parse(const h2::frame &frame) {
     h2::payload<h2::frame::HEADERS> headers(frame);
@@ -33,7 +103,7 @@ parser<h2::hpack>::parse(const h2::frame &frame) {
                 auto index = h2::variable_integer<7>::decode(std::span<const std::byte>(pos, payload.cend()), len);
                 pos += len;
                 auto header = header_by_index(index);
-                decoded_.push_back(*header);
+                decoded_.push_back(h2::hpack::header{ std::string(header.key), std::string(header.value) });
                 goto next;
             }
 
@@ -46,12 +116,12 @@ parser<h2::hpack>::parse(const h2::frame &frame) {
                 if (index == 0) {
                     key = parse_string(pos, payload);
                 } else {
-                    key = header_by_index(index)->key;
+                    key = header_by_index(index).key;
                 }
                 value = parse_string(pos, payload);
 
                 decoded_.push_back(h2::hpack::header{ key, value });
-                header_map_.push_front(h2::hpack::header{ key, value });
+                header_map_.insert(std::move(key), std::move(value));
                 goto next;
             }
 
@@ -62,15 +132,11 @@ parser<h2::hpack>::parse(const h2::frame &frame) {
 
                 std::print("Asked for header table update to: {}\n", size);
 
-                if (size < header_map_.size()) {
-                    while (size < header_map_.size()) {
-                        // Remove oldest entry
-                        header_map_.pop_back();
-                    }
-                } // TODO: I don't think that we have to handle the `else`
-                // in our case.  but read up on RFC 7541 Section 4.2.
-                // Maximum Table Size to be sure.
-                // return h2::hpack::error::eSizeUpdate;
+                // It may not exceed our SETTINGS_HEADER_TABLE_SIZE
+                // (RFC 7541 4.2).
+                if (size > h2::DEFAULT_HEADER_TABLE_SIZE)
+                    throw h2::hpack::error::eInvalid;
+                header_map_.resize(size);
                 goto next;
             }
 
@@ -84,7 +150,7 @@ parser<h2::hpack>::parse(const h2::frame &frame) {
                 if (index == 0) {
                     key = parse_string(pos, payload);
                 } else {
-                    key = header_by_index(index)->key;
+                    key = header_by_index(index).key;
                 }
                 value = parse_string(pos, payload);
                 decoded_.emplace_back(h2::hpack::header { key, value });
@@ -120,32 +186,35 @@ parser<h2::hpack>::parse_string(std::span<std::byte>::const_iterator &pos, std::
         throw h2::hpack::error::eInvalid;
 
     // Read `length` bytes as the string starting from `pos`
-    std::string raw((const char *)&(*pos), length);
+    std::span<const std::byte> raw(std::to_address(pos), length);
     pos += length;
     if (is_huffman) {
-        auto decoder = h2::hpack::decoder();
-        return decoder.decode(raw);
+        std::string decoded;
+        if (!h2::hpack::codec.decode(raw, decoded))
+            throw h2::hpack::error::eInvalid;
+        return decoded;
     }
-    return raw;
+    return std::string(reinterpret_cast<const char *>(raw.data()), raw.size());
 }
 
 parser<h2::hpack>::parser() {}
 
-const h2::hpack::header *
+h2::hpack::header_view
 parser<h2::hpack>::header_by_index(uint32_t index) {
-    if (index < h2::hpack::STATIC_HEADER_TABLE.size())
-        return &h2::hpack::STATIC_HEADER_TABLE[index];
+    // Index 0 is not used
+    if (index == 0)
+        throw h2::hpack::error::eUnknownHeader;
+    if (index < h2::detail::STATIC_TABLE.size())
+        return h2::detail::STATIC_TABLE[index];
 
     /*
       Indices strictly greater than the length of the static table refer to
       elements in the dynamic table (see Section 2.3.2).  The length of the
       static table is subtracted to find the index into the dynamic table.
     */
-
-    index -= h2::hpack::STATIC_HEADER_TABLE.size();
-    index -= 1;
-    if (index < header_map_.size())
-        return &header_map_[index];
+    index -= h2::detail::STATIC_TABLE.size();
+    if (index < header_map_.entries())
+        return h2::hpack::header_view{ header_map_[index].key, header_map_[index].value };
     // Indices strictly greater than the sum of the lengths of both tables
     // MUST be treated as a decoding error.
     throw h2::hpack::error::eUnknownHeader;
@@ -158,20 +227,34 @@ parser<h2::hpack>::result() {
 
 std::variant<serializer<h2::hpack>::fully_indexed, serializer<h2::hpack>::key_indexed, serializer<h2::hpack>::literal>
 serializer<h2::hpack>::search_index(const h2::hpack::header &h) {
-    // Look through our static table
-    std::string key = to_lower(h.key);
-    ssize_t     best_index = -1;
-    for (auto const &[idx, header] : h2::hpack::STATIC_HEADER_TABLE) {
-        if (header.key == key && header.value == h.value) {
-            return fully_indexed{ idx };
-        } else if (header.key == key && header.value != h.value) {
-            best_index = idx;
-        }
+    // Perfect hashes over the static table, names match in any case
+    if (size_t index = h2::detail::find_static(h.key, h.value))
+        return fully_indexed{ static_cast<ssize_t>(index) };
+
+    // The dynamic table holds a few dozen entries at most, newest first
+    ssize_t named = 0;
+    for (size_t i = 0; i < header_map_.entries(); ++i) {
+        auto const &entry = header_map_[i];
+        if (!h2::detail::equals_lower(entry.key, h.key))
+            continue;
+        auto index = static_cast<ssize_t>(h2::detail::STATIC_TABLE.size() + i);
+        if (entry.value == h.value)
+            return fully_indexed{ index };
+        if (named == 0)
+            named = index;
     }
-    if (best_index != -1)
-        return key_indexed{ best_index };
-    else
-        return literal{};
+
+    if (size_t index = h2::detail::find_static(h.key))
+        return key_indexed{ static_cast<ssize_t>(index) };
+    if (named != 0)
+        return key_indexed{ named };
+    return literal{};
+}
+
+void
+serializer<h2::hpack>::max_table_size(size_t size) {
+    limit_ = std::min<size_t>(size, h2::DEFAULT_HEADER_TABLE_SIZE);
+    lowest_ = std::min(lowest_, limit_);
 }
 
 // Serializer
@@ -179,76 +262,52 @@ void
 serializer<h2::hpack>::serialize(std::span<const h2::hpack::header> list) {
     using fully_indexed = serializer<h2::hpack>::fully_indexed;
     using key_indexed = serializer<h2::hpack>::key_indexed;
-    using literal = serializer<h2::hpack>::literal;
-
-    for (auto const &header : list) {
-        auto where = search_index(header);
-        if (std::holds_alternative<fully_indexed>(where)) {
-            // Emit 1 byte header
-            fully_indexed &index = std::get<fully_indexed>(where);
 
-            // Convert index to wire format
-            auto wire = h2::variable_integer<7>::encode(index.index);
-            wire[0] |= static_cast<std::byte>(0b1000'0000);
-            payload.insert(payload.end(), wire.begin(), wire.end());
+    // A new table size is announced before the first header of a block,
+    // preceded by the smallest size if it shrank in between (RFC 7541
+    // 4.2).
+    if (payload.empty()) {
+        if (lowest_ < header_map_.max_size()) {
+            append_size_update(payload, lowest_);
+            header_map_.resize(lowest_);
         }
-
-        if (std::holds_alternative<key_indexed>(where)) {
-            // Emit 1 byte header
-            key_indexed &index = std::get<key_indexed>(where);
-
-            // Convert index to wire format
-            auto wire = h2::variable_integer<6>::encode(index.index);
-            wire[0] = (wire[0] & static_cast<std::byte>(0b0011'1111)) | static_cast<std::byte>(0b0100'0000);
-            payload.insert(payload.end(), wire.begin(), wire.end());
-
-            // Use the encoder to encode the header value
-            auto huffman = h2::hpack::decoder().encode(header.value); // Corrected to encoder
-
-            // Insert value length
-            wire = h2::variable_integer<7>::encode(huffman.size());
-
-            // Ensure the size of wire is at least 1 before modifying
-            if (!wire.empty()) {
-                // Huffman encoding bitflag
-                wire[0] |= static_cast<std::byte>(0b1000'0000);
-            } else {
-                // Handle the case where wire is empty if necessary
-                std::cerr << "Error: wire is empty after encoding value length." << std::endl;
-            }
-
-            payload.insert(payload.end(), wire.begin(), wire.end());
-            // Encode value
-            payload.insert(payload.end(), huffman.begin(), huffman.end());
+        if (limit_ != header_map_.max_size()) {
+            append_size_update(payload, limit_);
+            header_map_.resize(limit_);
         }
+        lowest_ = limit_;
+    }
 
-        if (std::holds_alternative<literal>(where)) {
+    for (auto const &header : list) {
+        auto where = search_index(header);
+        if (auto *index = std::get_if<fully_indexed>(&where)) {
             // Emit 1 byte header
-            std::vector<std::byte> wire = { static_cast<std::byte>(0b0000'0000) };
-            payload.insert(payload.end(), wire.begin(), wire.end());
-
-            // Encode key
-            auto huffman = h2::hpack::decoder().encode(header.key);
-
-            // Insert key length
-            wire = h2::variable_integer<7>::encode(huffman.size());
-            // Huffman encoding bitflag
+            auto wire = h2::variable_integer<7>::encode(index->index);
             wire[0] |= static_cast<std::byte>(0b1000'0000);
             payload.insert(payload.end(), wire.begin(), wire.end());
-
-            // Encode value
-            payload.insert(payload.end(), huffman.begin(), huffman.end());
-
-            huffman = h2::hpack::decoder().encode(header.value);
-            // Insert value length
-            wire = h2::variable_integer<7>::encode(huffman.size());
-            // Huffman encoding bitflag
-            wire[0] |= static_cast<std::byte>(0b1000'0000);
-            payload.insert(payload.end(), wire.begin(), wire.end());
-
-            // Encode value
-            payload.insert(payload.end(), huffman.begin(), huffman.end());
+            continue;
         }
+
+        // Field names are sent and indexed in lowercase (RFC 9113 8.2.1)
+        std::string lowered;
+        if (std::any_of(header.key.begin(), header.key.end(), [](unsigned char c) { return std::isupper(c); }))
+            lowered = to_lower(header.key);
+        std::string_view key = lowered.empty() ? std::string_view(header.key) : std::string_view(lowered);
+
+        // Literal with incremental indexing, or without indexing, naming
+        // a table entry if there is one.
+        ssize_t name = std::holds_alternative<key_indexed>(where) ? std::get<key_indexed>(where).index : 0;
+        bool    index = indexable(key, header.value, header_map_.max_size());
+        auto    wire = index ? h2::variable_integer<6>::encode(name) : h2::variable_integer<4>::encode(name);
+        if (index)
+            wire[0] |= static_cast<std::byte>(0b0100'0000);
+        payload.insert(payload.end(), wire.begin(), wire.end());
+
+        if (name == 0)
+            append_string(payload, key);
+        append_string(payload, header.value);
+        if (index)
+            header_map_.insert(std::string(key), header.value);
     }
 }
 
@@ -263,70 +322,3 @@ serializer<h2::hpack>::finish(uint32_t stream_id) {
     };
     // clang-format on
 }
-
-// clang-format off
-std::unordered_map<ssize_t, h2::hpack::header>
-h2::hpack::STATIC_HEADER_TABLE = {
-    {1,  h2::hpack::header{ ":authority", "" }},
-    {2,  h2::hpack::header{ ":method", "GET" }},
-    {3,  h2::hpack::header{ ":method", "POST" }},
-    {4,  h2::hpack::header{ ":path", "/" }},
-    {5,  h2::hpack::header{ ":path", "/index.html" }},
-    {6,  h2::hpack::header{ ":scheme", "http" }},
-    {7,  h2::hpack::header{ ":scheme", "https" }},
-    {8,  h2::hpack::header{ ":status", "200" }},
-    {9,  h2::hpack::header{ ":status", "204" }},
-    {10, h2::hpack::header{ ":status", "206" }},
-    {11, h2::hpack::header{ ":status", "304" }},
-    {12, h2::hpack::header{ ":status", "400" }},
-    {13, h2::hpack::header{ ":status", "404" }},
-    {14, h2::hpack::header{ ":status", "500" }},
-    {15, h2::hpack::header{ "accept-charset", "" }},
-    {16, h2::hpack::header{ "accept-encoding", "gzip, deflate" }},
-    {17, h2::hpack::header{ "accept-language", "" }},
-    {18, h2::hpack::header{ "accept-ranges", "" }},
-    {19, h2::hpack::header{ "accept", "" }},
-    {20, h2::hpack::header{ "access-control-allow-origin", "" }},
-    {21, h2::hpack::header{ "age", "" }},
-    {22, h2::hpack::header{ "allow", "" }},
-    {23, h2::hpack::header{ "authorization", "" }},
-    {24, h2::hpack::header{ "cache-control", "" }},
-    {25, h2::hpack::header{ "content-disposition", "" }},
-    {26, h2::hpack::header{ "content-encoding", "" }},
-    {27, h2::hpack::header{ "content-language", "" }},
-    {28, h2::hpack::header{ "content-length", "" }},
-    {29, h2::hpack::header{ "content-location", "" }},
-    {30, h2::hpack::header{ "content-range", "" }},
-    {31, h2::hpack::header{ "content-type", "" }},
-    {32, h2::hpack::header{ "cookie", "" }},
-    {33, h2::hpack::header{ "date", "" }},
-    {34, h2::hpack::header{ "etag", "" }},
-    {35, h2::hpack::header{ "expect", "" }},
-    {36, h2::hpack::header{ "expires", "" }},
-    {37, h2::hpack::header{ "from", "" }},
-    {38, h2::hpack::header{ "host", "" }},
-    {39, h2::hpack::header{ "if-match", "" }},
-    {40, h2::hpack::header{ "if-modified-since", "" }},
-    {41, h2::hpack::header{ "if-none-match", "" }},
-    {42, h2::hpack::header{ "if-range", "" }},
-    {43, h2::hpack::header{ "if-unmodified-since", "" }},
-    {44, h2::hpack::header{ "last-modified", "" }},
-    {45, h2::hpack::header{ "link", "" }},
-    {46, h2::hpack::header{ "location", "" }},
-    {47, h2::hpack::header{ "max-forwards", "" }},
-    {48, h2::hpack::header{ "proxy-authenticate", "" }},
-    {49, h2::hpack::header{ "proxy-authorization", "" }},
-    {50, h2::hpack::header{ "range", "" }},
-    {51, h2::hpack::header{ "referer", "" }},
-    {52, h2::hpack::header{ "refresh", "" }},
-    {53, h2::hpack::header{ "retry-after", "" }},
-    {54, h2::hpack::header{ "server", "" }},
-    {55, h2::hpack::header{ "set-cookie", "" }},
-    {56, h2::hpack::header{ "strict-transport-security", "" }},
-    {57, h2::hpack::header{ "transfer-encoding", "" }},
-    {58, h2::hpack::header{ "user-agent", "" }},
-    {59, h2::hpack::header{ "vary", "" }},
-    {60, h2::hpack::header{ "via", "" }},
-    {61, h2::hpack::header{ "www-authenticate", "" }},
-};
-// clang-format on
@@ -0,0 +1,65 @@
+#include <protocols/h2/settings.hpp>
+
+h2::settings::error
+h2::settings::apply(std::span<const std::byte> payload) {
+    for (size_t i = 0; i + 6 <= payload.size(); i += 6) {
+        auto     id = static_cast<h2::setting>((static_cast<uint16_t>(payload[i]) << 8) | static_cast<uint16_t>(payload[i + 1]));
+        uint32_t value = (static_cast<uint32_t>(payload[i + 2]) << 24) | (static_cast<uint32_t>(payload[i + 3]) << 16) | (static_cast<uint32_t>(payload[i + 4]) << 8) | static_cast<uint32_t>(payload[i + 5]);
+        switch (id) {
+            case h2::setting::HEADER_TABLE_SIZE:
+                header_table_size = value;
+                break;
+            case h2::setting::ENABLE_PUSH:
+                if (value > 1)
+                    return error::eProtocol;
+                enable_push = value == 1;
+                break;
+            case h2::setting::MAX_CONCURRENT_STREAMS:
+                max_concurrent_streams = value;
+                break;
+            case h2::setting::INITIAL_WINDOW_SIZE:
+                if (value > MAX_WINDOW_SIZE)
+                    return error::eFlowControl;
+                initial_window_size = value;
+                break;
+            case h2::setting::MAX_FRAME_SIZE:
+                if (value < DEFAULT_MAX_FRAME_SIZE || value > MAX_MAX_FRAME_SIZE)
+                    return error::eProtocol;
+                max_frame_size = value;
+                break;
+            case h2::setting::MAX_HEADER_LIST_SIZE:
+                max_header_list_size = value;
+                break;
+            default:
+                // Unknown settings MUST be ignored
+                break;
+        }
+    }
+    return error::eNone;
+}
+
+std::vector<std::byte>
+h2::settings::pack() const {
+    const settings         initial{};
+    std::vector<std::byte> payload;
+    auto                   add = [&payload](h2::setting id, uint32_t value) {
+        payload.push_back(static_cast<std::byte>(static_cast<uint16_t>(id) >> 8));
+        payload.push_back(static_cast<std::byte>(static_cast<uint16_t>(id) & 0xFF));
+        for (int shift = 24; shift >= 0; shift -= 8)
+            payload.push_back(static_cast<std::byte>((value >> shift) & 0xFF));
+    };
+
+    if (header_table_size != initial.header_table_size)
+        add(h2::setting::HEADER_TABLE_SIZE, header_table_size);
+    if (enable_push != initial.enable_push)
+        add(h2::setting::ENABLE_PUSH, enable_push);
+    if (max_concurrent_streams != initial.max_concurrent_streams)
+        add(h2::setting::MAX_CONCURRENT_STREAMS, max_concurrent_streams);
+    if (initial_window_size != initial.initial_window_size)
+        add(h2::setting::INITIAL_WINDOW_SIZE, initial_window_size);
+    if (max_frame_size != initial.max_frame_size)
+        add(h2::setting::MAX_FRAME_SIZE, max_frame_size);
+    if (max_header_list_size != initial.max_header_list_size)
+        add(h2::setting::MAX_HEADER_LIST_SIZE, max_header_list_size);
+    return payload;
+}
@@ -1,20 +1,21 @@
 #include <iostream>
+#include <random>
 #include <runtime.hpp>
 
+namespace {
+// The worker the current thread runs as, if any.
+thread_local const rite::runtime *current_runtime = nullptr;
+thread_local size_t               current_worker = 0;
+};
+
 void
 rite::runtime::start() {
     if (num_workers_ == 0) {
         std::cerr << "Runtime: starting with 0 threads configured, are you sure this is intended?" << std::endl;
     }
 
-    auto &consumer = thread_pool_.rx();
     for (size_t i = 0; i < num_workers_; ++i) {
-        threads_.push_back(std::thread([&consumer]() {
-            for (;;) {
-                auto task = consumer.wait();
-                task();
-            }
-        }));
+        threads_.push_back(std::thread([this, i]() { work(i); }));
     }
     for (auto &thread : threads_) {
         thread.join();
@@ -28,9 +29,91 @@ void
 rite::runtime::worker_threads(size_t num) {
     threads_.reserve(num);
     num_workers_ = num;
+    workers_.clear();
+    for (size_t i = 0; i < num; ++i)
+        workers_.emplace_back(std::make_unique<worker>());
+}
+
+void
+rite::runtime::dispatch(rite::task &&work) {
+    if (current_runtime == this) {
+        worker &self = *workers_[current_worker];
+        std::lock_guard<std::mutex> guard(self.lock);
+        self.tasks.push_back(std::move(work));
+    } else {
+        std::lock_guard<std::mutex> guard(injection_lock_);
+        injection_.push_back(std::move(work));
+    }
+
+    // Pairs with the `sleeping_` increment in `work`: either the worker
+    // going to sleep sees the new task, or we see it sleeping and wake it.
+    pending_.fetch_add(1);
+    if (sleeping_.load() > 0) {
+        std::lock_guard<std::mutex> guard(sleep_lock_);
+        wake_.notify_one();
+    }
+}
+
+bool
+rite::runtime::next(size_t self, task &out) {
+    // Own deque, newest first
+    {
+        worker                     &local = *workers_[self];
+        std::lock_guard<std::mutex> guard(local.lock);
+        if (!local.tasks.empty()) {
+            out = std::move(local.tasks.back());
+            local.tasks.pop_back();
+            return true;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(injection_lock_);
+        if (!injection_.empty()) {
+            out = std::move(injection_.front());
+            injection_.pop_front();
+            return true;
+        }
+    }
+
+    // Steal the oldest task of a victim, starting at a random worker so
+    // that thieves spread out.
+    thread_local std::minstd_rand rng(std::random_device{}());
+    size_t                        count = workers_.size();
+    size_t                        start = rng() % count;
+    for (size_t i = 0; i < count; ++i) {
+        size_t victim = (start + i) % count;
+        if (victim == self)
+            continue;
+
+        worker                     &other = *workers_[victim];
+        std::lock_guard<std::mutex> guard(other.lock);
+        if (!other.tasks.empty()) {
+            out = std::move(other.tasks.front());
+            other.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
 }
 
 void
-rite::runtime::dispatch(std::function<void()> &&work) {
-    thread_pool_.tx()(std::move(work));
+rite::runtime::work(size_t self) {
+    current_runtime = this;
+    current_worker = self;
+
+    task job;
+    for (;;) {
+        if (next(self, job)) {
+            pending_.fetch_sub(1);
+            job();
+            job = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(sleep_lock_);
+        sleeping_.fetch_add(1);
+        wake_.wait(guard, [this]() { return pending_.load() > 0; });
+        sleeping_.fetch_sub(1);
+    }
 }
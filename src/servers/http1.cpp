@@ -0,0 +1,247 @@
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <type_traits>
+
+#include <http/behaviour.hpp>
+#include <http/serializer.hpp>
+#include <plain.hpp>
+#include <protocols/http1.hpp>
+#include <tls.hpp>
+
+namespace {
+
+// Whether the connection stays open after `req` (RFC 9112, 9.3)
+bool
+persistent(const http_request &req) {
+    auto has = [](std::string_view list, std::string_view token) {
+        while (!list.empty()) {
+            size_t           comma = list.find(',');
+            std::string_view item = list.substr(0, comma);
+            list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+
+            size_t first = item.find_first_not_of(" \t");
+            size_t last = item.find_last_not_of(" \t");
+            if (first == std::string_view::npos || last - first + 1 != token.size())
+                continue;
+
+            bool equal = true;
+            for (size_t i = 0; i < token.size() && equal; ++i)
+                equal = (item[first + i] | 0x20) == token[i];
+            if (equal)
+                return true;
+        }
+        return false;
+    };
+
+    auto connection = req.header("connection");
+    if (req.version() == http_version::HTTP_1_0)
+        return connection && has(*connection, "keep-alive");
+    return !(connection && has(*connection, "close"));
+}
+
+template<typename Transport>
+void
+write(connection<http1<Transport>> *socket, rite::http::response_queue::entry &entry) {
+    if (entry.response) {
+        http_response &response = *entry.response;
+        auto           ss = serializer<http_response>{ .serialize_body = false };
+
+        // Heads almost always fit the stack buffer, larger ones fall
+        // back to the heap.
+        std::array<std::byte, 4096> stack;
+        std::vector<std::byte>      heap;
+        std::span<std::byte>        head = stack;
+        size_t                      length = ss(response, head);
+        if (length > head.size()) {
+            heap.resize(length);
+            head = heap;
+            ss(response, head);
+        }
+        head = head.first(length);
+
+        if (const auto &file = response.file()) {
+            // Corked head, the file pages follow without being copied
+            // through user space.  A body cut short leaves nothing to
+            // keep alive.
+            bool sent = socket->write_all(head, entry.head_only ? 0 : MSG_MORE) >= 0 && (entry.head_only || socket->send_file_all(file->fd(), file->offset(), file->length()) >= 0);
+            entry.close = entry.close || !sent;
+            response.trigger(http_response::event::finish);
+            if (entry.close)
+                socket->close();
+            return;
+        }
+
+        // The head goes out together with the first body slice, a
+        // response with a single slice costs one syscall.  Chunk framing
+        // is sent in the same write as the data it frames.
+        auto        &body = response.channel->rx();
+        rite::buffer slice;
+        bool         sent = true;
+        if (entry.head_only) {
+            sent = socket->write_all(head, 0) >= 0;
+            head = {};
+        }
+        do {
+            response.trigger(http_response::event::chunk);
+            slice = body.wait();
+            // The producer is drained either way, HEAD never sends the
+            // body and after a failed write nothing else goes out.
+            if (entry.head_only || !sent)
+                continue;
+
+            size_t       data = static_cast<size_t>(slice.len);
+            char         size[20];
+            struct iovec buffers[5];
+            size_t       count = 0;
+            buffers[count++] = { .iov_base = head.data(), .iov_len = head.size() };
+            if (!entry.chunked) {
+                buffers[count++] = { .iov_base = slice.data.get(), .iov_len = data };
+            } else {
+                // Empty chunks would end the body early
+                if (data > 0) {
+                    int digits = std::snprintf(size, sizeof(size), "%zx\r\n", data);
+                    buffers[count++] = { .iov_base = size, .iov_len = static_cast<size_t>(digits) };
+                    buffers[count++] = { .iov_base = slice.data.get(), .iov_len = data };
+                }
+                // CRLF closing the data, on the last slice followed by the
+                // last-chunk and the empty trailer section.
+                std::string_view tail = slice.last ? "\r\n0\r\n\r\n" : "\r\n";
+                if (data == 0)
+                    tail.remove_prefix(2);
+                buffers[count++] = { .iov_base = const_cast<char *>(tail.data()), .iov_len = tail.size() };
+            }
+            sent = socket->write_all(std::span(buffers, count), slice.last == false ? MSG_MORE : 0) >= 0;
+            head = {};
+        } while (slice.last == false);
+        entry.close = entry.close || !sent;
+        response.trigger(http_response::event::finish);
+    }
+
+    if (entry.close)
+        socket->close();
+}
+
+template<typename Transport>
+void
+respond(connection<http1<Transport>> *socket, uint64_t ticket, std::optional<http_response> &&response, bool close, bool http10 = false, bool head_only = false) {
+    bool chunked = false;
+    if (response) {
+        // Without a length the body is chunked, HTTP/1.0 clients only
+        // understand bodies delimited by closing.  Bodiless statuses and
+        // answers to HEAD need neither.
+        int  status = static_cast<int>(response->status_code());
+        bool bodiless = head_only || status < 200 || status == 204 || status == 304;
+        if (!bodiless && !response->headers().contains("Content-Length")) {
+            if (http10) {
+                close = true;
+            } else {
+                chunked = true;
+                response->set_header("Transfer-Encoding", "chunked");
+            }
+        }
+        if (close)
+            response->set_header("Connection", "close");
+        else if (http10)
+            response->set_header("Connection", "keep-alive");
+    }
+    socket->responses.complete(ticket, rite::http::response_queue::entry{ .response = std::move(response), .close = close, .chunked = chunked, .head_only = head_only }, [socket](auto &entry) { write(socket, entry); });
+}
+
+};
+
+template<typename Transport>
+void
+rite::http::serve(connection<http1<Transport>> *con, rite::http::layer &behaviour) {
+    connection<void> *socket = con;
+    bool              eof = false;
+    bool              progressed = false;
+
+    {
+        std::lock_guard<std::mutex> guard(con->read_lock);
+        for (;;) {
+            std::span<std::byte> space = con->reader.prepare();
+            ssize_t              bytes = socket->read(space, 0);
+            if (bytes < 0 && errno == EINTR)
+                continue;
+            if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                break;
+            if (bytes < 1) {
+                // Peer is done sending (or the socket broke), still answer
+                // whatever it pipelined before.
+                eof = true;
+                break;
+            }
+            con->reader.commit(bytes);
+            // A short read drained the socket, TLS reads return at most
+            // one record and always have to go on until EAGAIN.
+            if (std::is_same_v<Transport, plain> && static_cast<size_t>(bytes) < space.size())
+                break;
+        }
+    }
+
+    // Handle every complete request in the buffer.  Requests are parsed
+    // one at a time so that concurrent readiness events can interleave,
+    // tickets keep their responses in order.
+    for (;;) {
+        http_request               req;
+        rite::http::reader::result result;
+        uint64_t                   ticket;
+        bool                       keep_alive = false;
+        {
+            std::lock_guard<std::mutex> guard(con->read_lock);
+            if (con->closing)
+                break;
+
+            result = con->reader.next(socket, req);
+            if (result == rite::http::reader::result::eIncomplete && !eof)
+                break;
+
+            ticket = con->responses.ticket();
+            keep_alive = result == rite::http::reader::result::eComplete && persistent(req);
+            con->closing = !keep_alive;
+            progressed = true;
+        }
+
+        if (result == rite::http::reader::result::eIncomplete) {
+            // Close once everything before is out
+            respond(con, ticket, std::nullopt, true);
+            break;
+        }
+
+        if (result == rite::http::reader::result::eInvalid) {
+            // The stream can't be resynchronized after garbage
+            respond(con, ticket, http_response(http_status_code::eBadRequest, ""), true);
+            break;
+        }
+
+        bool http10 = req.version() == http_version::HTTP_1_0;
+        bool head_only = req.method() == HEAD;
+        socket->take();
+        behaviour.handle(std::move(req), [con, ticket, keep_alive, http10, head_only](http_response &&response) {
+            respond(con, ticket, std::move(response), !keep_alive, http10, head_only);
+            con->release();
+        });
+    }
+
+    {
+        // A head trickling in is cut off after `head_timeout`, the
+        // keep-alive alone would let a slow client hold the connection
+        // indefinitely.  Every completed head starts the clock anew.
+        std::lock_guard<std::mutex> guard(con->read_lock);
+        bool                        partial = !con->closing && !eof && con->reader.in_head();
+        if (con->head_timer != rite::timer_wheel::invalid && (!partial || progressed)) {
+            con->cancel_timeout(con->head_timer);
+            con->head_timer = rite::timer_wheel::invalid;
+        }
+        if (partial && con->head_timer == rite::timer_wheel::invalid)
+            con->head_timer = con->timeout(con->head_timeout, [](connection<void> *slow) { slow->close(); });
+    }
+
+    socket->release();
+}
+
+template void rite::http::serve(connection<http1<plain>> *, rite::http::layer &);
+template void rite::http::serve(connection<http1<tls>> *, rite::http::layer &);
@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <openssl/rand.h>
+#include <stdexcept>
+
+#include "session_cache.hpp"
+
+rite::session_cache::session_cache(size_t capacity, std::chrono::seconds ttl)
+  : per_shard_(std::max<size_t>(1, (capacity + SHARDS - 1) / SHARDS))
+  , ttl_(ttl) {}
+
+rite::session_cache::shard &
+rite::session_cache::shard_of(std::string_view id) {
+    return shards_[std::hash<std::string_view>{}(id) % SHARDS];
+}
+
+void
+rite::session_cache::insert(std::string_view id, std::vector<uint8_t> &&session, clock::time_point now) {
+    shard                      &s = shard_of(id);
+    std::lock_guard<std::mutex> guard(s.lock);
+
+    if (auto it = s.index.find(id); it != s.index.end()) {
+        s.lru.erase(it->second);
+        s.index.erase(it);
+    }
+    if (s.lru.size() >= per_shard_) {
+        s.index.erase(s.lru.back().id);
+        s.lru.pop_back();
+    }
+
+    s.lru.push_front(entry{ .id = std::string(id), .session = std::move(session), .expires = now + ttl_ });
+    // Keys view the id owned by the list entry
+    s.index.emplace(s.lru.front().id, s.lru.begin());
+}
+
+std::optional<std::vector<uint8_t>>
+rite::session_cache::find(std::string_view id, clock::time_point now) {
+    shard                      &s = shard_of(id);
+    std::lock_guard<std::mutex> guard(s.lock);
+
+    auto it = s.index.find(id);
+    if (it == s.index.end())
+        return std::nullopt;
+    if (it->second->expires <= now) {
+        s.lru.erase(it->second);
+        s.index.erase(it);
+        return std::nullopt;
+    }
+    s.lru.splice(s.lru.begin(), s.lru, it->second);
+    return s.lru.front().session;
+}
+
+void
+rite::session_cache::erase(std::string_view id) {
+    shard                      &s = shard_of(id);
+    std::lock_guard<std::mutex> guard(s.lock);
+
+    if (auto it = s.index.find(id); it != s.index.end()) {
+        s.lru.erase(it->second);
+        s.index.erase(it);
+    }
+}
+
+size_t
+rite::session_cache::size() const {
+    size_t total = 0;
+    for (const shard &s : shards_) {
+        std::lock_guard<std::mutex> guard(s.lock);
+        total += s.lru.size();
+    }
+    return total;
+}
+
+rite::ticket_keys::ticket_keys(std::chrono::seconds interval)
+  : interval_(interval) {
+    rotate(clock::now());
+}
+
+void
+rite::ticket_keys::rotate(clock::time_point now) {
+    key next;
+    if (RAND_bytes(next.name.data(), next.name.size()) != 1 || RAND_bytes(next.aes.data(), next.aes.size()) != 1 || RAND_bytes(next.hmac.data(), next.hmac.size()) != 1)
+        throw std::runtime_error("failed to generate session ticket key");
+    // After a rotation was skipped (no handshakes for a whole interval),
+    // the old current key has outlived its grace period as well.
+    if (rotated_ != clock::time_point{} && now - rotated_ < 2 * interval_)
+        previous_ = current_;
+    else
+        previous_.reset();
+    current_ = next;
+    rotated_ = now;
+}
+
+rite::ticket_keys::key
+rite::ticket_keys::current(clock::time_point now) {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (now - rotated_ >= interval_)
+        rotate(now);
+    return current_;
+}
+
+std::optional<std::pair<rite::ticket_keys::key, bool>>
+rite::ticket_keys::find(const uint8_t *name, clock::time_point now) {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (now - rotated_ >= interval_)
+        rotate(now);
+    if (std::memcmp(name, current_.name.data(), current_.name.size()) == 0)
+        return std::pair{ current_, true };
+    if (previous_ && std::memcmp(name, previous_->name.data(), previous_->name.size()) == 0)
+        return std::pair{ *previous_, false };
+    return std::nullopt;
+}
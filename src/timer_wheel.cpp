@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <timer_wheel.hpp>
+
+rite::timer_wheel::timer_wheel(std::chrono::milliseconds resolution)
+  : resolution_(std::max(resolution, std::chrono::milliseconds(1)))
+  , epoch_(clock::now())
+  , current_(0)
+  , pending_(0)
+  , free_(npos) {
+    for (auto &level : slots_)
+        level.fill(npos);
+}
+
+uint64_t
+rite::timer_wheel::ticks(clock::time_point at) const {
+    if (at <= epoch_)
+        return 0;
+    return std::chrono::duration_cast<std::chrono::milliseconds>(at - epoch_).count() / resolution_.count();
+}
+
+rite::timer_wheel::id
+rite::timer_wheel::schedule(clock::time_point deadline, callback &&cb) {
+    std::lock_guard<std::mutex> guard(lock_);
+
+    uint32_t index;
+    if (free_ != npos) {
+        index = free_;
+        free_ = nodes_[index].next;
+    } else {
+        index = nodes_.size();
+        nodes_.push_back(node{ .cb = nullptr, .deadline = 0, .generation = 0, .prev = npos, .next = npos, .level = 0, .slot = 0, .active = false });
+    }
+
+    // Round up so that timers never fire early, never fire within the
+    // current tick and clamp to what the highest level can represent.
+    constexpr uint64_t horizon = (uint64_t)1 << (SLOT_BITS * LEVELS);
+    uint64_t           due = std::clamp(ticks(deadline + resolution_ - clock::duration(1)), current_ + 1, current_ + horizon - 1);
+
+    node &n = nodes_[index];
+    n.cb = std::move(cb);
+    n.deadline = due;
+    n.active = true;
+    place(index);
+    pending_++;
+    return ((uint64_t)n.generation << 32) | index;
+}
+
+bool
+rite::timer_wheel::cancel(id timer) {
+    std::lock_guard<std::mutex> guard(lock_);
+    uint32_t                    index = timer & 0xFFFFFFFF;
+    uint32_t                    generation = timer >> 32;
+    if (timer == invalid || index >= nodes_.size())
+        return false;
+
+    node &n = nodes_[index];
+    if (!n.active || n.generation != generation)
+        return false;
+
+    unlink(index);
+    n.active = false;
+    n.cb = nullptr;
+    n.generation++;
+    n.next = free_;
+    free_ = index;
+    pending_--;
+    return true;
+}
+
+size_t
+rite::timer_wheel::advance(clock::time_point now) {
+    std::vector<callback> expired;
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        uint64_t                    target = ticks(now);
+        if (pending_ == 0) {
+            // Nothing to cascade, skip ahead.
+            current_ = std::max(current_, target);
+            return 0;
+        }
+
+        while (current_ < target) {
+            current_++;
+            // Cascade from the highest level that wrapped around down to
+            // level 1, so that timers land in their final slot before
+            // level 0 is expired.
+            for (size_t level = LEVELS - 1; level > 0; --level) {
+                if ((current_ & (((uint64_t)1 << (SLOT_BITS * level)) - 1)) == 0)
+                    cascade(level);
+            }
+
+            uint32_t &head = slots_[0][current_ & (SLOTS - 1)];
+            while (head != npos) {
+                uint32_t index = head;
+                node    &n = nodes_[index];
+                unlink(index);
+                expired.emplace_back(std::move(n.cb));
+                n.cb = nullptr;
+                n.active = false;
+                n.generation++;
+                n.next = free_;
+                free_ = index;
+                pending_--;
+            }
+        }
+    }
+
+    for (auto &cb : expired)
+        cb();
+    return expired.size();
+}
+
+int
+rite::timer_wheel::next_timeout(clock::time_point now) const {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (pending_ == 0)
+        return -1;
+
+    auto next_tick = epoch_ + resolution_ * (ticks(now) + 1);
+    return std::max<int>(0, std::chrono::ceil<std::chrono::milliseconds>(next_tick - now).count());
+}
+
+size_t
+rite::timer_wheel::size() const {
+    std::lock_guard<std::mutex> guard(lock_);
+    return pending_;
+}
+
+void
+rite::timer_wheel::place(uint32_t index) {
+    node    &n = nodes_[index];
+    uint64_t delta = n.deadline > current_ ? n.deadline - current_ : 0;
+
+    size_t level = 0;
+    while (level < LEVELS - 1 && delta >= ((uint64_t)1 << (SLOT_BITS * (level + 1))))
+        level++;
+
+    n.level = level;
+    n.slot = (std::max(n.deadline, current_) >> (SLOT_BITS * level)) & (SLOTS - 1);
+
+    uint32_t &head = slots_[n.level][n.slot];
+    n.prev = npos;
+    n.next = head;
+    if (head != npos)
+        nodes_[head].prev = index;
+    head = index;
+}
+
+void
+rite::timer_wheel::unlink(uint32_t index) {
+    node &n = nodes_[index];
+    if (n.prev != npos)
+        nodes_[n.prev].next = n.next;
+    else
+        slots_[n.level][n.slot] = n.next;
+
+    if (n.next != npos)
+        nodes_[n.next].prev = n.prev;
+    n.prev = n.next = npos;
+}
+
+void
+rite::timer_wheel::cascade(size_t level) {
+    uint32_t &head = slots_[level][(current_ >> (SLOT_BITS * level)) & (SLOTS - 1)];
+    uint32_t  index = head;
+    head = npos;
+    while (index != npos) {
+        uint32_t next = nodes_[index].next;
+        place(index);
+        index = next;
+    }
+}
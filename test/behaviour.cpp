@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <optional>
+#include <thread>
+
+#include <http/behaviour.hpp>
+
+namespace {
+http_request
+get(std::string path) {
+    http_request req;
+    req.method_ = GET;
+    req.path_ = std::move(path);
+    return req;
+}
+
+rite::http::endpoint
+recording(std::optional<std::thread::id> &ran_on) {
+    return rite::http::endpoint{ .method = GET, .path = rite::http::path("/"), .handler = [&ran_on](http_request &, rite::http::path::result) {
+                                    ran_on = std::this_thread::get_id();
+                                    return http_response(http_status_code::eOk, "");
+                                } };
+}
+};
+
+TEST(Behaviour, SynchronousEndpointsRunInPlace) {
+    rite::http::layer              layer;
+    std::optional<std::thread::id> ran_on;
+    layer.add_endpoint(recording(ran_on));
+
+    std::optional<http_status_code> status;
+    layer.handle(get("/"), [&status](http_response &&response) { status = response.status_code(); });
+    EXPECT_EQ(ran_on, std::this_thread::get_id());
+    EXPECT_EQ(status, http_status_code::eOk);
+}
+
+TEST(Behaviour, ThreadPoolsOfFunctionsAreAccepted) {
+    // Pools written against std::function keep working
+    jt::mpsc<std::function<void()>> pool;
+    rite::http::layer               layer;
+    std::optional<std::thread::id>  ran_on;
+    auto                            endpoint = recording(ran_on);
+    endpoint.thread_pool = pool.tx();
+    layer.add_endpoint(std::move(endpoint));
+
+    std::optional<http_status_code> status;
+    layer.handle(get("/"), [&status](http_response &&response) { status = response.status_code(); });
+    EXPECT_FALSE(status.has_value());
+
+    std::thread worker([&pool]() { pool.rx().wait()(); });
+    auto        id = worker.get_id();
+    worker.join();
+    EXPECT_EQ(ran_on, id);
+    EXPECT_EQ(status, http_status_code::eOk);
+}
+
+TEST(Behaviour, AsynchronousThreadsAreCapped) {
+    rite::http::layer              layer;
+    std::optional<std::thread::id> ran_on;
+    auto                           endpoint = recording(ran_on);
+    endpoint.asynchronous = true;
+    layer.add_endpoint(std::move(endpoint));
+
+    // Past the cap the handler runs on the calling worker
+    layer.max_async_threads(0);
+    std::optional<http_status_code> status;
+    layer.handle(get("/"), [&status](http_response &&response) { status = response.status_code(); });
+    EXPECT_EQ(ran_on, std::this_thread::get_id());
+    EXPECT_EQ(status, http_status_code::eOk);
+}
@@ -0,0 +1,199 @@
+// HPACK header blocks of the Firefox and Chromium fixtures in
+// test/hpack.cpp: full header block decoding, and Huffman coding of the
+// strings they contain with the previous codec (bit at a time over hash
+// maps, copied per string) vs. the shared table driven one.
+//
+// Build with -DRITE_BUILD_BENCHMARKS=ON, run `bench-hpack`.
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <print>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <protocols/h2/headers.hpp>
+#include <protocols/h2/hpack.hpp>
+
+namespace {
+
+// clang-format off
+constexpr char FIREFOX_START[] =
+                                 "\x82\x04\x81\x63\x41\x8a\xa0\xe4\x1d\x13\x9d\x09\xb8\x20\x01\x9f\x87\x7a\xb5\xd0\x7f\x66\xa2\x81\xb0\xda\xe0\x53\xfa\xfc\x08\x7e\xd4\xce\x6a\xad\xf2\xa7\x97\x9c\x89\xc6\xbe\xd4\xb3\xbd\xc0\xb2"
+                                 "\xca\xe0\xfe\xd4\xc4\x52\x75\x3b\x02\x00\x40\x00\x80\x2a\x61\x35\x85\x94\xfe\x58\x0b\x2c\xae\x0f\x53\xb0\x49\x7c\xa5\x89\xd3\x4d\x1f\x43\xae\xba\x0c\x41\xa4\xc7\xa9\x8f\x33\xa6\x9a\x3f\xdf\x9a"
+                                 "\x68\xfa\x1d\x75\xd0\x62\x0d\x26\x3d\x4c\x79\xa6\x8f\xbe\xd0\x01\x77\xfe\xbe\x58\xf9\xfb\xed\x00\x17\x7b\x51\x93\x90\xbf\x45\xa9\x6e\x1b\xbe\xfb\x40\x05\xdd\xfa\x2d\x5f\x7d\xa0\x02\xec\xff\x50"
+                                 "\x92\x9b\xd9\xab\xfa\x52\x42\xcb\x40\xd2\x5f\xa5\x23\xb3\xe9\x4f\x68\x4c\x9f\x40\x83\x92\xa4\xff\x81\x0f\x40\x92\xb6\xb9\xac\x1c\x85\x58\xd5\x20\xa4\xb6\xc2\xad\x61\x7b\x5a\x54\x25\x1f\x81\x0f"
+                                 "\x40\x8a\x41\x48\xb4\xa5\x49\x27\x5a\x42\xa1\x3f\x86\x90\xe4\xb6\x92\xd4\x9f\x40\x8a\x41\x48\xb4\xa5\x49\x27\x5a\x93\xc8\x5f\x86\xa8\x7d\xcd\x30\xd2\x5f\x40\x8a\x41\x48\xb4\xa5\x49\x27\x59\x06"
+                                 "\x49\x7f\x83\xa8\xf5\x17\x40\x8a\x41\x48\xb4\xa5\x49\x27\x5a\xd4\x16\xcf\x82\xff\x03\x40\x86\xae\xc3\x1e\xc3\x27\xd7\x85\xb6\x00\x7d\x28\x6f\x40\x82\x49\x7f\x86\x4d\x83\x35\x05\xb1\x1f";
+constexpr char FIREFOX_SUBSEQUENT[] =
+                                 "\x82\x04\x81\x63\xca\x87\xc9\xc8\xc7\xc6\xc5\xc4\xc3\xc2\xc1\xc0\xbf\xbe";
+constexpr char CHROMIUM_START[] =
+                                 "\x82\x41\x8a\xa0\xe4\x1d\x13\x9d\x09\xb8\x20\x01\x9f\x87\x84\x58\x87\xa4\x7e\x56\x1c\xc5\x80\x1f\x40\x87\x41\x48\xb1\x27\x5a\xd1\xff\xa3\xfe\x6f\x4f\x61\xe9\x35\xb4\xff\x3f\x7d\xe0\xfe\x42\xc8\x7f\x9f\xa5\x3f\x9d\x27\x4c\x50\xa9\x76\xc1\xd5\x27\xf3\xf7\xde\x0f\xe4\x4d\x7f\x3f\x40\x8b\x41\x48\xb1\x27\x5a\xd1\xad\x49\xe3\x35\x05\x02\x3f\x30\x40\x8d\x41\x48\xb1\x27\x5a\xd1\xad\x5d\x03\x4c\xa7\xb2\x9f\x07\x22\x4c\x69\x6e\x75\x78\x22\x40\x92\xb6\xb9\xac\x1c\x85\x58\xd5\x20\xa4\xb6\xc2\xad\x61\x7b\x5a\x54\x25\x1f\x01\x31\x7a\xce\xd0\x7f\x66\xa2\x81\xb0\xda\xe0\x53\xfa\xfc\x08\x7e\xd4\xce\x6a\xad\xf2\xa7\x97\x9c\x89\xc6\xbf\xb5\x21\xae\xba\x0b\xc8\xb1\xe6\x32\x58\x6d\x97\x57\x65\xc5\x3f\xac\xd8\xf7\xe8\xcf\xf4\xa5\x06\xea\x55\x31\x14\x9d\x4f\xfd\xa9\x7a\x7b\x0f\x49\x58\x0b\x21\x5c\x0b\x81\x70\x29\xb8\x72\x8e\xc3\x30\xdb\x2e\xae\xcb\x9f\x53\xe5\x49\x7c\xa5\x89\xd3\x4d\x1f\x43\xae\xba\x0c\x41\xa4\xc7\xa9\x8f\x33\xa6\x9a\x3f\xdf\x9a\x68\xfa\x1d\x75\xd0\x62\x0d\x26\x3d\x4c\x79\xa6\x8f\xbe\xd0\x01\x77\xfe\x8d\x48\xe6\x2b\x03\xee\x69\x7e\x8d\x48\xe6\x2b\x1e\x0b\x1d\x7f\x46\xa4\x73\x15\x81\xd7\x54\xdf\x5f\x2c\x7c\xfd\xf6\x80\x0b\xbd\xf4\x3a\xeb\xa0\xc4\x1a\x4c\x7a\x98\x41\xa6\xa8\xb2\x2c\x5f\x24\x9c\x75\x4c\x5f\xbe\xf0\x46\xcf\xdf\x68\x00\xbb\xbf\x40\x8a\x41\x48\xb4\xa5\x49\x27\x59\x06\x49\x7f\x87\x25\x87\x42\x16\x41\x92\x5f\x40\x8a\x41\x48\xb4\xa5\x49\x27\x5a\x93\xc8\x5f\x86\xa8\x7d\xcd\x30\xd2\x5f\x40\x8a\x41\x48\xb4\xa5\x49\x27\x5a\xd4\x16\xcf\x02\x3f\x31\x40\x8a\x41\x48\xb4\xa5\x49\x27\x5a\x42\xa1\x3f\x86\x90\xe4\xb6\x92\xd4\x9f\x50\x92\x9b\xd9\xab\xfa\x52\x42\xcb\x40\xd2\x5f\xa5\x23\xb3\xe9\x4f\x68\x4c\x9f\x51\x9c\x90\xab\x5f\xc1\xf5\x21\x7e\xfb\x40\x05\xdf\xfa\x2d\x4b\x70\xdd\xf7\xda\x00\x2e\xf7\xd1\x6a\xfb\xed\x00\x17\x77\x40\x86\xae\xc3\x1e\xc3\x27\xd7\x85\xb6\x00\x7d\x28\x6f";
+constexpr char CHROMIUM_SUBSEQUENT[] =
+                                 "\x82\xcc\x87\x04\x89\x62\x51\xf7\x31\x0f\x52\xe6\x21\xff\xc8\xc6\xca\xc9\x53\xb1\x35\x23\x98\xac\x0f\xb9\xa5\xfa\x35\x23\x98\xac\x78\x2c\x75\xfd\x1a\x91\xcc\x56\x07\x5d\x53\x7d\x1a\x91\xcc\x56\x11\xde\x6f\xf7\xe6\x9a\x3e\x8d\x48\xe6\x2b\x1f\x3f\x5f\x2c\x7c\xfd\xf6\x80\x0b\xbd\x7f\x06\x88\x40\xe9\x2a\xc7\xb0\xd3\x1a\xaf\x7f\x06\x85\xa8\xeb\x10\xf6\x23\x7f\x05\x84\x35\x23\x98\xbf\x73\x90\x9d\x29\xad\x17\x18\x62\x83\x90\x74\x4e\x74\x26\xe0\x80\x06\x58\xc5\xc4\x7f\x04\x85\xb6\x00\xfd\x28\x6f";
+// clang-format on
+
+// The codec as it was before
+class legacy_huffman {
+    public:
+    legacy_huffman() {
+        for (size_t symbol = 0; symbol < 256; ++symbol) {
+            auto [code, length] = h2::detail::HUFFMAN_CODES[symbol];
+            encodings_[static_cast<char>(symbol)] = { code, length };
+            reverse_map_[code] = static_cast<char>(symbol);
+            code_lengths_[code] = length;
+        }
+    }
+
+    std::string decode(const std::string_view &data) {
+        std::string output;
+        size_t      min_bit_size = std::numeric_limits<size_t>::max();
+        for (auto &[_, size] : code_lengths_)
+            min_bit_size = std::min<size_t>(min_bit_size, size);
+
+        uint32_t code = 0;
+        size_t   bits_checked = 0;
+        for (char c : data) {
+            uint8_t byte = static_cast<uint8_t>(c);
+            for (int i = 7; i >= 0; --i) {
+                code = (code << 1) | ((byte >> i) & 1);
+                bits_checked++;
+                if (code_lengths_.contains(code) && bits_checked >= min_bit_size && static_cast<size_t>(code_lengths_[code]) == bits_checked) {
+                    output += reverse_map_[code];
+                    code = 0;
+                    bits_checked = 0;
+                }
+                if (bits_checked >= 32) {
+                    code = 0;
+                    bits_checked = 0;
+                }
+            }
+        }
+        return output;
+    }
+
+    std::vector<std::byte> encode(const std::string &input) {
+        std::vector<std::byte> output;
+        size_t                 bit_position = 0;
+        uint8_t                byte = 0;
+        for (const char codepoint : input) {
+            auto code = encodings_[codepoint].first;
+            auto length = code_lengths_[code];
+            for (int i = 0; i < length; ++i) {
+                byte = (byte << 1) | ((code >> (length - 1 - i)) & 1);
+                if (++bit_position == 8) {
+                    output.push_back(static_cast<std::byte>(byte));
+                    byte = 0;
+                    bit_position = 0;
+                }
+            }
+        }
+        if (bit_position > 0)
+            output.push_back(static_cast<std::byte>((byte << (8 - bit_position)) | ((1 << (8 - bit_position)) - 1)));
+        return output;
+    }
+
+    private:
+    std::unordered_map<char, std::pair<uint32_t, int>> encodings_;
+    std::unordered_map<uint32_t, char>                 reverse_map_;
+    std::unordered_map<uint32_t, int>                  code_lengths_;
+};
+
+h2::frame
+frame(std::string_view block) {
+    h2::frame frame;
+    frame.length = block.size();
+    frame.type = h2::frame::HEADERS;
+    frame.flags = h2::frame::characteristics<h2::frame::HEADERS>::END_HEADERS;
+    frame.stream_identifier = 1;
+    frame.data = std::vector<std::byte>(reinterpret_cast<const std::byte *>(block.data()), reinterpret_cast<const std::byte *>(block.data() + block.size()));
+    return frame;
+}
+
+template<typename F>
+double
+measure(size_t iterations, F &&f) {
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+        f();
+    return double(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count()) / iterations;
+}
+
+};
+
+int
+main() {
+    constexpr size_t ITERATIONS = 20000;
+    // Copying the hash maps per string makes the legacy codec slow
+    constexpr size_t LEGACY_ITERATIONS = 200;
+    const std::pair<std::string_view, std::pair<std::string_view, std::string_view>> connections[] = {
+        { "firefox", { std::string_view(FIREFOX_START, sizeof(FIREFOX_START) - 1), std::string_view(FIREFOX_SUBSEQUENT, sizeof(FIREFOX_SUBSEQUENT) - 1) } },
+        { "chromium", { std::string_view(CHROMIUM_START, sizeof(CHROMIUM_START) - 1), std::string_view(CHROMIUM_SUBSEQUENT, sizeof(CHROMIUM_SUBSEQUENT) - 1) } },
+    };
+
+    for (auto const &[name, blocks] : connections) {
+        h2::frame first = frame(blocks.first), second = frame(blocks.second);
+
+        // Both requests of a connection, the second one mostly indexed
+        std::vector<std::string> strings;
+        double                   blocks_ns = measure(ITERATIONS, [&]() {
+            parser<h2::hpack> hpack;
+            hpack.parse(first);
+            auto headers = hpack.result();
+            hpack.parse(second);
+            headers = hpack.result();
+            asm volatile("" ::"r"(headers.data()) : "memory");
+        });
+
+        // Every string of the first request, as the client could have
+        // Huffman coded it
+        parser<h2::hpack> hpack;
+        hpack.parse(first);
+        for (auto const &header : hpack.result()) {
+            strings.push_back(header.key);
+            strings.push_back(header.value);
+        }
+        std::vector<std::string> coded;
+        for (auto const &s : strings) {
+            std::vector<std::byte> out;
+            h2::hpack::codec.encode_into(s, out);
+            coded.emplace_back(reinterpret_cast<const char *>(out.data()), out.size());
+        }
+
+        legacy_huffman legacy;
+        double         legacy_decode = measure(LEGACY_ITERATIONS, [&]() {
+            for (auto const &s : coded) {
+                auto copy = legacy;
+                auto out = copy.decode(s);
+                asm volatile("" ::"r"(out.data()) : "memory");
+            }
+        });
+        double table_decode = measure(ITERATIONS, [&]() {
+            std::string out;
+            for (auto const &s : coded) {
+                out.clear();
+                h2::hpack::codec.decode(std::span<const std::byte>(reinterpret_cast<const std::byte *>(s.data()), s.size()), out);
+                asm volatile("" ::"r"(out.data()) : "memory");
+            }
+        });
+        double legacy_encode = measure(LEGACY_ITERATIONS, [&]() {
+            for (auto const &s : strings) {
+                auto copy = legacy;
+                auto out = copy.encode(s);
+                asm volatile("" ::"r"(out.data()) : "memory");
+            }
+        });
+        double table_encode = measure(ITERATIONS, [&]() {
+            std::vector<std::byte> out;
+            for (auto const &s : strings) {
+                out.clear();
+                h2::hpack::codec.encode_into(s, out);
+                asm volatile("" ::"r"(out.data()) : "memory");
+            }
+        });
+
+        std::print("{:>8}: header blocks {:>8.1f} ns, {} strings: decode {:>9.1f} -> {:>7.1f} ns, encode {:>9.1f} -> {:>7.1f} ns\n", name, blocks_ns, strings.size(), legacy_decode, table_decode, legacy_encode, table_encode);
+    }
+}
@@ -0,0 +1,154 @@
+// HTTP/1.1 request parsing: the previous istringstream based parser vs.
+// the single-pass parser<http_request>, on browser-like requests with
+// 10, 20 and 30 header fields (including large cookies).
+//
+// Build with -DRITE_BUILD_BENCHMARKS=ON, run `bench-parser`.
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <print>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <http/parser.hpp>
+
+namespace {
+
+// The parser as it was before, minus query parameters (the fixtures
+// have none).
+struct legacy_request {
+    std::string                        path;
+    http_method                        method;
+    http_version                       version;
+    std::map<std::string, std::string> headers;
+    std::vector<std::byte>             body;
+};
+
+bool
+legacy_parse(std::span<const std::byte> data, legacy_request &req) {
+    std::string        request_string(reinterpret_cast<const char *>(data.data()), data.size());
+    std::istringstream request_stream(request_string);
+    std::string        line;
+
+    if (!std::getline(request_stream, line))
+        return false;
+
+    std::istringstream request_line(line);
+    std::string        method_str, path, version;
+    if (!(request_line >> method_str >> path >> version))
+        return false;
+
+    if (version == "HTTP/1.1")
+        req.version = http_version::HTTP_1_1;
+    else if (version == "HTTP/1.0")
+        req.version = http_version::HTTP_1_0;
+    else
+        return false;
+
+    if (method_str == "GET")
+        req.method = http_method::GET;
+    else if (method_str == "POST")
+        req.method = http_method::POST;
+    else
+        return false;
+    req.path = path;
+
+    while (std::getline(request_stream, line) && (!line.empty() && line != "\r")) {
+        auto colon_pos = line.find(':');
+        if (colon_pos != std::string::npos) {
+            std::string key = line.substr(0, colon_pos);
+            std::string value = line.substr(colon_pos + 1);
+            key.erase(key.find_last_not_of(" \n\r\t") + 1);
+            value.erase(0, value.find_first_not_of(" \n\r\t"));
+            req.headers[key] = value;
+        }
+    }
+
+    if (req.method == http_method::POST) {
+        std::string body_string((std::istreambuf_iterator<char>(request_stream)), std::istreambuf_iterator<char>());
+        req.body.resize(body_string.size());
+        std::transform(body_string.begin(), body_string.end(), req.body.begin(), [](char c) { return static_cast<std::byte>(c); });
+    }
+    return true;
+}
+
+std::string
+request(size_t fields) {
+    static const std::vector<std::string> pool = {
+        "Host: www.example.com",
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:131.0) Gecko/20100101 Firefox/131.0",
+        "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8",
+        "Accept-Language: en-US,en;q=0.5",
+        "Accept-Encoding: gzip, deflate, br, zstd",
+        "Connection: keep-alive",
+        "Cookie: _ga=GA1.1.1385730921.1728043712; _ga_XXXXXXXXXX=GS1.1.1728043712.1.1.1728043790.0.0.0; session=eyJhbGciOiJIUzI1NiIsInR5cCI6IkpXVCJ9.eyJzdWIiOiIxMjM0NTY3ODkwIiwibmFtZSI6IkpvaG4gRG9lIiwiaWF0IjoxNTE2MjM5MDIyfQ; theme=dark",
+        "Upgrade-Insecure-Requests: 1",
+        "Sec-Fetch-Dest: document",
+        "Sec-Fetch-Mode: navigate",
+        "Sec-Fetch-Site: same-origin",
+        "Sec-Fetch-User: ?1",
+        "Priority: u=0, i",
+        "Referer: https://www.example.com/articles/2024/10/some-long-article-title?utm_source=newsletter",
+        "Cache-Control: max-age=0",
+        "DNT: 1",
+        "Sec-CH-UA: \"Chromium\";v=\"130\", \"Google Chrome\";v=\"130\", \"Not?A_Brand\";v=\"99\"",
+        "Sec-CH-UA-Mobile: ?0",
+        "Sec-CH-UA-Platform: \"Linux\"",
+        "If-None-Match: W/\"5e15153d-120f\"",
+        "If-Modified-Since: Tue, 08 Oct 2024 12:45:26 GMT",
+        "X-Forwarded-For: 203.0.113.195, 70.41.3.18, 150.172.238.178",
+        "X-Forwarded-Proto: https",
+        "X-Request-ID: 9c4b1d6e-3b0a-4f8e-9d7c-2a1f5e6b8c90",
+        "X-Real-IP: 203.0.113.195",
+        "Forwarded: for=203.0.113.195;proto=https;by=10.0.0.1",
+        "Via: 1.1 lb-eu-west-1a",
+        "Origin: https://www.example.com",
+        "Pragma: no-cache",
+        "Cookie: consent=eyJuZWNlc3NhcnkiOnRydWUsImFuYWx5dGljcyI6ZmFsc2UsIm1hcmtldGluZyI6ZmFsc2V9; lang=en",
+    };
+
+    std::string out = "GET /articles/2024/10/some-long-article-title HTTP/1.1\r\n";
+    for (size_t i = 0; i < fields; ++i)
+        out += pool[i % pool.size()] + "\r\n";
+    return out + "\r\n";
+}
+
+template<typename F>
+double
+measure(size_t iterations, F &&f) {
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+        f();
+    return double(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count()) / iterations;
+}
+
+};
+
+int
+main() {
+    constexpr size_t ITERATIONS = 100000;
+    for (size_t fields : { 10, 20, 30 }) {
+        std::string                request_string = request(fields);
+        std::span<const std::byte> data(reinterpret_cast<const std::byte *>(request_string.data()), request_string.size());
+
+        double legacy = measure(ITERATIONS, [&]() {
+            legacy_request req;
+            legacy_parse(data, req);
+            asm volatile("" ::"r"(&req) : "memory");
+        });
+        double current = measure(ITERATIONS, [&]() {
+            http_request req;
+            parser<http_request>{}.parse(nullptr, data, req);
+            asm volatile("" ::"r"(&req) : "memory");
+        });
+        double head = measure(ITERATIONS, [&]() {
+            parser<http_request>::head parsed;
+            parser<http_request>{}.parse_head(data, parsed);
+            asm volatile("" ::"r"(&parsed) : "memory");
+        });
+
+        std::print("{:>2} fields ({:>4} B): istringstream {:>8.1f} ns, parse {:>7.1f} ns, parse_head {:>7.1f} ns\n", fields, request_string.size(), legacy, current, head);
+    }
+}
@@ -0,0 +1,75 @@
+// parser<http_request>::parse_head with the scalar, SSE4.2 and AVX2
+// scanning kernels on header blocks from 200 B to 16 KiB.  The large
+// blocks are dominated by cookies, like our real traffic.
+//
+// Build with -DRITE_BUILD_BENCHMARKS=ON, run `bench-scan`.
+
+#include <chrono>
+#include <format>
+#include <print>
+#include <string>
+
+#include <http/parser.hpp>
+#include <http/scan.hpp>
+
+namespace {
+
+std::string
+request(size_t size) {
+    std::string out = "GET /api/v1/items HTTP/1.1\r\n"
+                      "Host: www.example.com\r\n"
+                      "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:131.0) Gecko/20100101 Firefox/131.0\r\n"
+                      "Accept: */*\r\n";
+    // Fill up with cookies of up to 512 bytes each
+    for (size_t i = 0; out.size() + 4 < size; ++i) {
+        std::string line = std::format("Cookie: c{}=", i);
+        size_t      room = std::min<size_t>(512, size - out.size() - 4);
+        if (room < line.size() + 1)
+            break;
+        line.append(room - line.size(), 'a' + (i % 26));
+        out += line + "\r\n";
+    }
+    return out + "\r\n";
+}
+
+const char *
+name(rite::http::scan::level level) {
+    switch (level) {
+    case rite::http::scan::level::eAVX2:
+        return "avx2";
+    case rite::http::scan::level::eSSE42:
+        return "sse4.2";
+    default:
+        return "scalar";
+    }
+}
+
+};
+
+int
+main() {
+    using rite::http::scan::level;
+    for (size_t size : { 200, 512, 1024, 2048, 4096, 8192, 16384 }) {
+        std::string                request_string = request(size);
+        std::span<const std::byte> data(reinterpret_cast<const std::byte *>(request_string.data()), request_string.size());
+        size_t                     iterations = 20'000'000 / size;
+
+        std::print("{:>5} B:", request_string.size());
+        for (level wanted : { level::eScalar, level::eSSE42, level::eAVX2 }) {
+            level used = rite::http::scan::select(wanted);
+            if (used != wanted)
+                continue;
+
+            parser<http_request>::head parsed;
+            auto                       begin = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < iterations; ++i) {
+                if (parser<http_request>{}.parse_head(data, parsed) != parser<http_request>::result::eComplete)
+                    std::print("parse failed\n");
+                asm volatile("" ::"r"(&parsed) : "memory");
+            }
+            double ns = double(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count()) / iterations;
+            std::print("  {} {:>8.1f} ns ({:.2f} GB/s)", name(used), ns, request_string.size() / ns);
+        }
+        std::print("\n");
+    }
+}
@@ -0,0 +1,103 @@
+// Response head serialization: the previous ostringstream based
+// serializer vs. serializer<http_response> writing into a caller
+// provided buffer, on responses with 2, 8 and 16 header fields.
+//
+// Build with -DRITE_BUILD_BENCHMARKS=ON, run `bench-serializer`.
+
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <print>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <http/serializer.hpp>
+
+namespace {
+
+// The serializer as it was before (no reason phrase, no Date).
+std::vector<std::byte>
+legacy_serialize(const http_response &response) {
+    std::vector<std::byte> serialized_data;
+
+    const char *http_version = "HTTP/1.1 ";
+    serialized_data.insert(serialized_data.end(), reinterpret_cast<const std::byte *>(http_version), reinterpret_cast<const std::byte *>(http_version) + strlen(http_version));
+
+    int                status_code = static_cast<int>(response.status_code());
+    std::ostringstream status_stream;
+    status_stream << status_code << "\r\n";
+    std::string status_code_str = status_stream.str();
+    serialized_data.insert(serialized_data.end(), reinterpret_cast<const std::byte *>(status_code_str.data()), reinterpret_cast<const std::byte *>(status_code_str.data()) + status_code_str.size());
+
+    for (const auto &[key, value] : response.headers()) {
+        std::string header_line = key + ": " + value + "\r\n";
+        serialized_data.insert(serialized_data.end(), reinterpret_cast<const std::byte *>(header_line.data()), reinterpret_cast<const std::byte *>(header_line.data()) + header_line.size());
+    }
+
+    serialized_data.push_back(static_cast<std::byte>('\r'));
+    serialized_data.push_back(static_cast<std::byte>('\n'));
+    return serialized_data;
+}
+
+http_response
+response(size_t fields) {
+    static const std::vector<std::pair<std::string, std::string>> pool = {
+        { "Cache-Control", "public, max-age=3600" },
+        { "ETag", "W/\"5e15153d-120f\"" },
+        { "Last-Modified", "Tue, 08 Oct 2024 12:45:26 GMT" },
+        { "Vary", "Accept-Encoding" },
+        { "X-Request-ID", "9c4b1d6e-3b0a-4f8e-9d7c-2a1f5e6b8c90" },
+        { "Strict-Transport-Security", "max-age=63072000; includeSubDomains; preload" },
+        { "X-Content-Type-Options", "nosniff" },
+        { "Server", "rite" },
+        { "Set-Cookie", "session=eyJhbGciOiJIUzI1NiIsInR5cCI6IkpXVCJ9; Path=/; HttpOnly; Secure" },
+        { "Content-Security-Policy", "default-src 'self'; img-src *; script-src 'self' https://cdn.example.com" },
+        { "Referrer-Policy", "strict-origin-when-cross-origin" },
+        { "Access-Control-Allow-Origin", "https://www.example.com" },
+        { "X-Frame-Options", "DENY" },
+        { "Permissions-Policy", "geolocation=(), microphone=()" },
+    };
+
+    // Content-Type and Content-Length come with the body
+    http_response out(http_status_code::eOk, "text/html; charset=utf-8", "<!doctype html><p>hello</p>");
+    for (size_t i = 2; i < fields; ++i)
+        out.set_header(pool[i - 2].first, pool[i - 2].second);
+    return out;
+}
+
+template<typename F>
+double
+measure(size_t iterations, F &&f) {
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+        f();
+    return double(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count()) / iterations;
+}
+
+};
+
+int
+main() {
+    constexpr size_t ITERATIONS = 200000;
+    auto             ss = serializer<http_response>{ .serialize_body = false };
+    for (size_t fields : { 2, 8, 16 }) {
+        http_response subject = response(fields);
+
+        double legacy = measure(ITERATIONS, [&]() {
+            auto head = legacy_serialize(subject);
+            asm volatile("" ::"r"(head.data()) : "memory");
+        });
+        double vector = measure(ITERATIONS, [&]() {
+            auto head = ss(subject);
+            asm volatile("" ::"r"(head.data()) : "memory");
+        });
+        double buffer = measure(ITERATIONS, [&]() {
+            std::array<std::byte, 4096> head;
+            size_t                      length = ss(subject, head);
+            asm volatile("" ::"r"(head.data()), "r"(length) : "memory");
+        });
+
+        std::print("{:>2} fields: ostringstream {:>7.1f} ns, vector {:>7.1f} ns, caller buffer {:>7.1f} ns\n", fields, legacy, vector, buffer);
+    }
+}
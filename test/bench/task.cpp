@@ -0,0 +1,137 @@
+// Allocations per request of the closures the framework creates for
+// every request: std::function + std::bind/std::async (before) vs.
+// rite::task for offloaded and in place endpoints.
+//
+// Build with -DRITE_BUILD_BENCHMARKS=ON, run `bench-task`.
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <future>
+#include <new>
+#include <print>
+
+#include <http/endpoint.hpp>
+#include <http/request.hpp>
+#include <task.hpp>
+
+static std::atomic_size_t allocations = 0;
+
+void *
+operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void
+operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void
+operator delete(void *p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+struct fake_server {
+    void on_read(connection<void> *client) { asm volatile("" ::"r"(client)); }
+};
+
+struct reactor {};
+
+constexpr size_t REQUESTS = 200000;
+
+http_request
+make_request() {
+    http_request req;
+    req.path_ = "/index.html";
+    req.headers_.add("host", "localhost:8080");
+    req.headers_.add("user-agent", "Mozilla/5.0 (X11; Linux x86_64; rv:131.0) Gecko/20100101 Firefox/131.0");
+    req.headers_.add("accept", "text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8");
+    req.headers_.add("accept-language", "en-US,en;q=0.5");
+    return req;
+}
+
+// Every request starts out with its own parsed request & path mapping,
+// the harness copies them for each call.  `copy` is what that costs by
+// itself, every other row includes it.
+void
+copy(fake_server &, connection<void> *, http_request &&req, rite::http::path::result &&mapping) {
+    asm volatile("" ::"r"(&req), "r"(&mapping));
+}
+
+// What a request used to cost: a bound readiness event, the
+// finish callback, the std::async wrapper copying the request & the
+// keep-alive timer callback.  Every endpoint went through std::async.
+void
+before(fake_server &server, connection<void> *client, http_request &&req, rite::http::path::result &&mapping) {
+    reactor                  r;
+    uint64_t                 h = 1;
+    std::function<void()>    event = std::bind(&fake_server::on_read, &server, client);
+    std::function<void()>    timer = [&server, &r, h]() { asm volatile("" ::"r"(&server), "r"(&r), "r"(h)); };
+    std::function<void(int)> finish = [client](int status) { asm volatile("" ::"r"(client), "r"(status)); };
+    event();
+    std::future<void> handler = std::async(std::launch::deferred, [finish, mapping, req]() mutable { finish(static_cast<int>(req.path_.size() + mapping.parameters.size())); });
+    handler.get();
+    timer();
+}
+
+// Offloaded endpoints (thread pool, asynchronous) move the request &
+// mapping into their task.
+void
+offloaded(fake_server &server, connection<void> *client, http_request &&req, rite::http::path::result &&mapping) {
+    reactor                     r;
+    uint64_t                    h = 1;
+    rite::task                  event = [&server, client]() { server.on_read(client); };
+    rite::task                  timer = [&server, &r, h]() { asm volatile("" ::"r"(&server), "r"(&r), "r"(h)); };
+    rite::basic_task<void(int)> finish = [client](int status) { asm volatile("" ::"r"(client), "r"(status)); };
+    event();
+    rite::task job = [finish = std::move(finish), mapping = std::move(mapping), req = std::move(req)]() mutable { finish(static_cast<int>(req.path_.size() + mapping.parameters.size())); };
+    job();
+    timer();
+}
+
+// Synchronous endpoints run in place and use the request where it is.
+void
+in_place(fake_server &server, connection<void> *client, http_request &&req, rite::http::path::result &&mapping) {
+    reactor                     r;
+    uint64_t                    h = 1;
+    rite::task                  event = [&server, client]() { server.on_read(client); };
+    rite::task                  timer = [&server, &r, h]() { asm volatile("" ::"r"(&server), "r"(&r), "r"(h)); };
+    rite::basic_task<void(int)> finish = [client](int status) { asm volatile("" ::"r"(client), "r"(status)); };
+    event();
+    finish(static_cast<int>(req.path_.size() + mapping.parameters.size()));
+    timer();
+}
+
+template<typename F>
+void
+run(const char *name, F &&f) {
+    fake_server              server;
+    http_request             req = make_request();
+    rite::http::path::result mapping;
+    mapping.parameters["file"] = "index.html";
+
+    size_t start = allocations.load();
+    auto   begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < REQUESTS; ++i)
+        f(server, nullptr, http_request(req), rite::http::path::result(mapping));
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin);
+
+    std::print("{:<10} {:>6.2f} allocations/request {:>8.1f} ns/request\n", name, double(allocations.load() - start) / REQUESTS, double(elapsed.count()) / REQUESTS);
+}
+
+};
+
+int
+main() {
+    run("copy", copy);
+    run("before", before);
+    run("offloaded", offloaded);
+    run("in place", in_place);
+}
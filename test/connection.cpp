@@ -0,0 +1,207 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <fcntl.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include <plain.hpp>
+
+namespace {
+std::string
+drain(int fd, size_t expected) {
+    std::string received;
+    char        chunk[4096];
+    while (received.size() < expected) {
+        ssize_t bytes = ::read(fd, chunk, sizeof(chunk));
+        if (bytes < 1)
+            break;
+        received.append(chunk, bytes);
+    }
+    return received;
+}
+};
+
+TEST(Connection, GatherWriteSendsAllBuffers) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    connection<plain> con(fds[0], {}, 0);
+
+    std::string  head = "HTTP/1.1 200\r\nContent-Length: 5\r\n\r\n", body = "hello";
+    struct iovec buffers[3] = {
+        { .iov_base = head.data(), .iov_len = head.size() },
+        { .iov_base = nullptr, .iov_len = 0 },
+        { .iov_base = body.data(), .iov_len = body.size() },
+    };
+    EXPECT_EQ(con.write_all(buffers, 0), static_cast<ssize_t>(head.size() + body.size()));
+    EXPECT_EQ(drain(fds[1], head.size() + body.size()), head + body);
+    ::close(fds[1]);
+}
+
+TEST(Connection, GatherWriteResumesAfterPartialWrites) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    int small = 4096;
+    setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    connection<plain> con(fds[0], {}, 0);
+
+    // Far more than the socket buffer holds, so writes come back short
+    // and in the middle of a buffer.
+    std::vector<std::string>  parts;
+    std::vector<struct iovec> buffers;
+    std::string               expected;
+    for (int i = 0; i < 16; ++i)
+        parts.push_back(std::string(10007 + i, static_cast<char>('a' + i)));
+    for (auto &part : parts) {
+        buffers.push_back({ .iov_base = part.data(), .iov_len = part.size() });
+        expected += part;
+    }
+
+    std::string received;
+    std::thread reader([&]() { received = drain(fds[1], expected.size()); });
+    EXPECT_EQ(con.write_all(buffers, 0), static_cast<ssize_t>(expected.size()));
+    reader.join();
+    EXPECT_EQ(received, expected);
+    ::close(fds[1]);
+}
+
+TEST(Connection, SendFileSendsRange) {
+    char path[] = "/tmp/rite-send-file-XXXXXX";
+    int  file = mkstemp(path);
+    ASSERT_NE(file, -1);
+    ::unlink(path);
+    std::string contents;
+    for (int i = 0; i < 50000; ++i)
+        contents.push_back(static_cast<char>('a' + i % 26));
+    ASSERT_EQ(::write(file, contents.data(), contents.size()), static_cast<ssize_t>(contents.size()));
+
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    connection<plain> con(fds[0], {}, 0);
+
+    std::string received;
+    std::thread reader([&]() { received = drain(fds[1], 40000); });
+    EXPECT_EQ(con.send_file_all(file, 1234, 40000), 40000);
+    reader.join();
+    EXPECT_EQ(received, contents.substr(1234, 40000));
+    ::close(fds[1]);
+    ::close(file);
+}
+
+TEST(Connection, DeliveredBuffersAreLentUntilRead) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    rite::returned_buffers returns(8);
+    connection<plain>      con(fds[0], {}, 0);
+    ASSERT_TRUE(con.enable_delivery(&returns));
+
+    std::string first = "hello ", second = "world";
+    EXPECT_TRUE(con.deliver(std::as_bytes(std::span(first)), 3, false));
+    EXPECT_TRUE(con.deliver(std::as_bytes(std::span(second)), 5, false));
+
+    std::vector<uint16_t> back;
+    auto                  collect = [&back](uint16_t id) { back.push_back(id); };
+    char                  target[64];
+    ASSERT_EQ(con.read(std::as_writable_bytes(std::span(target, 4)), 0), 4);
+    EXPECT_EQ(std::string(target, 4), "hell");
+    EXPECT_EQ(returns.take(collect), 0);
+
+    // Peeking leaves everything in place
+    ASSERT_EQ(con.read(std::as_writable_bytes(std::span(target)), MSG_PEEK), 7);
+    EXPECT_EQ(returns.take(collect), 0);
+
+    ASSERT_EQ(con.read(std::as_writable_bytes(std::span(target)), 0), 7);
+    EXPECT_EQ(std::string(target, 7), "o world");
+    EXPECT_EQ(returns.take(collect), 2);
+    EXPECT_EQ(back, (std::vector<uint16_t>{ 5, 3 }));
+
+    EXPECT_EQ(con.read(std::as_writable_bytes(std::span(target)), 0), -1);
+    EXPECT_EQ(errno, EAGAIN);
+    EXPECT_FALSE(con.deliver({}, rite::returned_buffers::NONE, true));
+    EXPECT_EQ(con.read(std::as_writable_bytes(std::span(target)), 0), 0);
+    ::close(fds[1]);
+}
+
+TEST(Connection, DeliveryCopiesInOrderWhenFull) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    rite::returned_buffers returns(64);
+    connection<plain>      con(fds[0], {}, 0);
+    con.enable_delivery(&returns);
+
+    // Lent buffers run out, the rest is copied and must come after them
+    std::string letters = "abcdefghijklmnopqrstuvwxyz";
+    size_t      kept = 0;
+    for (size_t i = 0; i < letters.size(); ++i)
+        kept += con.deliver(std::as_bytes(std::span(letters).subspan(i, 1)), i, false);
+    EXPECT_LT(kept, letters.size());
+
+    std::string received;
+    char        target[5];
+    for (ssize_t bytes; (bytes = con.read(std::as_writable_bytes(std::span(target)), 0)) > 0;)
+        received.append(target, bytes);
+    EXPECT_EQ(received, letters);
+    EXPECT_EQ(returns.take([](uint16_t) {}), kept);
+
+    // Caught up, buffers are lent again
+    EXPECT_TRUE(con.deliver(std::as_bytes(std::span(letters).first(1)), 0, false));
+    ::close(fds[1]);
+}
+
+TEST(Connection, DeliveryAcrossThreads) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    rite::returned_buffers returns(32);
+    connection<plain>      con(fds[0], {}, 0);
+    con.enable_delivery(&returns);
+
+    // A reactor lending 32 buffers of 7 bytes, cycling through a
+    // counting byte sequence
+    constexpr size_t                         TOTAL = 200000;
+    std::array<std::array<std::byte, 7>, 32> pool;
+    std::thread                              reactor([&]() {
+        std::vector<uint16_t> free;
+        for (uint16_t id = 0; id < pool.size(); ++id)
+            free.push_back(id);
+        size_t sent = 0;
+        while (sent < TOTAL) {
+            returns.take([&free](uint16_t id) { free.push_back(id); });
+            if (free.empty()) {
+                std::this_thread::yield();
+                continue;
+            }
+            uint16_t id = free.back();
+            free.pop_back();
+            size_t length = std::min(pool[id].size(), TOTAL - sent);
+            for (size_t i = 0; i < length; ++i)
+                pool[id][i] = static_cast<std::byte>((sent + i) % 251);
+            if (!con.deliver(std::span<const std::byte>(pool[id].data(), length), id, false))
+                free.push_back(id);
+            sent += length;
+        }
+        con.deliver({}, rite::returned_buffers::NONE, true);
+    });
+
+    size_t received = 0;
+    bool   ordered = true;
+    char   target[13];
+    for (;;) {
+        ssize_t bytes = con.read(std::as_writable_bytes(std::span(target)), 0);
+        if (bytes == 0)
+            break;
+        if (bytes < 0)
+            continue;
+        for (ssize_t i = 0; i < bytes; ++i)
+            ordered = ordered && static_cast<unsigned char>(target[i]) == (received + i) % 251;
+        received += bytes;
+    }
+    reactor.join();
+    EXPECT_EQ(received, TOTAL);
+    EXPECT_TRUE(ordered);
+    ::close(fds[1]);
+}
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include <protocols/h2/flow_control.hpp>
+
+TEST(FlowControl, SendLimitedByBothWindows) {
+    h2::flow_control flow;
+    flow.open(1);
+    flow.open(3);
+    EXPECT_EQ(flow.sendable(1, 100000), h2::DEFAULT_WINDOW_SIZE);
+
+    flow.sent(1, 60000);
+    EXPECT_EQ(flow.sendable(1, 100000), h2::DEFAULT_WINDOW_SIZE - 60000);
+    // The connection window is shared between streams
+    EXPECT_EQ(flow.sendable(3, 100000), h2::DEFAULT_WINDOW_SIZE - 60000);
+
+    flow.sent(3, h2::DEFAULT_WINDOW_SIZE - 60000);
+    EXPECT_EQ(flow.sendable(3, 100000), 0);
+    EXPECT_TRUE(flow.credit(0, 10000));
+    EXPECT_EQ(flow.sendable(3, 100000), 10000);
+    EXPECT_EQ(flow.sendable(1, 100000), h2::DEFAULT_WINDOW_SIZE - 60000);
+}
+
+TEST(FlowControl, UnknownStreamsGetNoCredit) {
+    h2::flow_control flow;
+    EXPECT_EQ(flow.sendable(5, 100), 0);
+    // Late updates for finished streams are ignored
+    EXPECT_TRUE(flow.credit(5, 100));
+    EXPECT_FALSE(flow.contains(5));
+
+    flow.open(5);
+    flow.close(5);
+    EXPECT_EQ(flow.sendable(5, 100), 0);
+}
+
+TEST(FlowControl, CreditOverflow) {
+    h2::flow_control flow;
+    flow.open(1);
+    EXPECT_TRUE(flow.credit(0, h2::MAX_WINDOW_SIZE - h2::DEFAULT_WINDOW_SIZE));
+    EXPECT_FALSE(flow.credit(0, 1));
+    EXPECT_FALSE(flow.credit(1, h2::MAX_WINDOW_SIZE));
+}
+
+TEST(FlowControl, InitialWindowSizeAdjustsOpenStreams) {
+    h2::flow_control flow;
+    flow.open(1);
+    flow.sent(1, 1000);
+    EXPECT_TRUE(flow.credit(0, 100000));
+
+    // Lowering the setting may leave a stream with a negative window
+    EXPECT_TRUE(flow.initial_window_size(500));
+    EXPECT_EQ(flow.sendable(1, 100), 0);
+    EXPECT_TRUE(flow.credit(1, 600));
+    EXPECT_EQ(flow.sendable(1, 1000), 100);
+
+    // New streams start at the new size
+    flow.open(3);
+    EXPECT_EQ(flow.sendable(3, 1000), 500);
+
+    EXPECT_FALSE(flow.initial_window_size(h2::MAX_WINDOW_SIZE + 1u));
+}
+
+TEST(FlowControl, ReceiveUpdatesAreBatched) {
+    h2::flow_control flow;
+    flow.open(1);
+
+    EXPECT_TRUE(flow.received(1, 16384));
+    EXPECT_EQ(flow.updates(1, false), std::make_pair(0u, 0u));
+    EXPECT_TRUE(flow.received(1, 16384));
+    EXPECT_EQ(flow.updates(1, false), std::make_pair(32768u, 32768u));
+
+    // Nothing more is expected on an ended stream
+    EXPECT_TRUE(flow.received(1, 40000));
+    EXPECT_EQ(flow.updates(1, true), std::make_pair(40000u, 0u));
+}
+
+TEST(FlowControl, ReceiveOverrun) {
+    h2::flow_control flow;
+    flow.open(1);
+    EXPECT_TRUE(flow.received(1, h2::DEFAULT_WINDOW_SIZE));
+    EXPECT_FALSE(flow.received(1, 1));
+}
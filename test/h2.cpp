@@ -0,0 +1,237 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <protocols/h2/connection.hpp>
+
+#include "tls_pair.hpp"
+
+namespace {
+std::vector<std::byte>
+packed(const h2::frame &frame) {
+    std::vector<std::byte> bytes(9);
+    frame.pack(bytes);
+    bytes.insert(bytes.end(), frame.data.begin(), frame.data.end());
+    return bytes;
+}
+
+std::vector<std::byte>
+rst_stream(h2::stream_id stream, h2::error_code error) {
+    std::vector<std::byte> code(4);
+    for (int i = 0; i < 4; ++i)
+        code[i] = static_cast<std::byte>((static_cast<uint32_t>(error) >> (24 - 8 * i)) & 0xFF);
+    return packed(h2::frame{ .length = 4, .type = h2::frame::RST_STREAM, .flags = 0, .stream_identifier = stream, .data = std::move(code) });
+}
+
+std::vector<std::byte>
+window_update(h2::stream_id stream, uint32_t increment) {
+    std::vector<std::byte> data(4);
+    for (int i = 0; i < 4; ++i)
+        data[i] = static_cast<std::byte>((increment >> (24 - 8 * i)) & 0xFF);
+    return packed(h2::frame{ .length = 4, .type = h2::frame::WINDOW_UPDATE, .flags = 0, .stream_identifier = stream, .data = std::move(data) });
+}
+
+uint32_t
+error_of(const h2::frame &frame) {
+    uint32_t error = 0;
+    for (std::byte b : frame.data)
+        error = error << 8 | static_cast<uint32_t>(b);
+    return error;
+}
+
+// An HTTP/2 connection over TLS.  The test plays the client: frames it
+// sends are handed to `process` as if the server had read them, frames
+// the server writes are read back from the socket.
+struct h2_pair {
+    tls_pair                                  tls;
+    std::unique_ptr<connection<h2::protocol>> server;
+    serializer<h2::hpack>                     encoder;
+
+    // With `timers` the preface has to arrive within the timeout
+    h2_pair(const h2::settings &local, const h2::settings &client, rite::timer_wheel *timers = nullptr)
+      : tls(false)
+      , server(std::make_unique<connection<h2::protocol>>(std::move(*tls.server), local)) {
+        server->set_keep_alive(std::chrono::seconds(1));
+        if (timers != nullptr) {
+            server->set_timers(timers);
+            server->expect_preface(std::chrono::milliseconds(100));
+        }
+
+        std::string_view       preface = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+        std::vector<std::byte> bytes(reinterpret_cast<const std::byte *>(preface.data()), reinterpret_cast<const std::byte *>(preface.data()) + preface.size());
+        auto                   settings = client.pack();
+        auto                   frame = packed(h2::frame{ .length = static_cast<uint32_t>(settings.size()), .type = h2::frame::SETTINGS, .flags = 0, .stream_identifier = 0, .data = settings });
+        bytes.insert(bytes.end(), frame.begin(), frame.end());
+        send(bytes);
+
+        // Our preface and the acknowledgement of theirs
+        EXPECT_EQ(next().type, h2::frame::SETTINGS);
+        EXPECT_EQ(next().type, h2::frame::SETTINGS);
+    }
+
+    // Streams that became complete requests
+    std::vector<h2::stream_id> send(std::span<const std::byte> bytes) {
+        std::vector<h2::stream_id>       requests;
+        auto                             pos = bytes.begin();
+        connection<h2::protocol>::result result;
+        while ((result = server->process(pos, bytes.end())) != connection<h2::protocol>::result::eEof) {
+            if (result == connection<h2::protocol>::result::eNewRequest)
+                requests.push_back(server->request.context<h2::stream_id>().value());
+        }
+        return requests;
+    }
+
+    // Open `stream` with a GET request, `extra` follows the pseudo-headers
+    std::vector<h2::stream_id> request(h2::stream_id stream, bool end_stream = true, std::vector<h2::hpack::header> extra = {}) {
+        std::vector<h2::hpack::header> headers = { { ":method", "GET" }, { ":scheme", "https" }, { ":path", "/" }, { ":authority", "localhost" } };
+        headers.insert(headers.end(), extra.begin(), extra.end());
+        encoder.serialize(headers);
+        h2::frame frame = encoder.finish(stream);
+        if (end_stream)
+            frame.flags |= h2::frame::characteristics<h2::frame::DATA>::END_STREAM;
+        return send(packed(frame));
+    }
+
+    // Next frame the server wrote
+    h2::frame next() {
+        std::string head = tls.receive(9);
+        h2::frame   frame{};
+        EXPECT_EQ(head.size(), 9);
+        frame.unpack(std::span<const std::byte>(reinterpret_cast<const std::byte *>(head.data()), head.size()));
+        std::string payload = tls.receive(frame.length);
+        frame.data.assign(reinterpret_cast<const std::byte *>(payload.data()), reinterpret_cast<const std::byte *>(payload.data()) + payload.size());
+        return frame;
+    }
+};
+};
+
+TEST(H2, MissingPrefaceTimesOut) {
+    tls_pair                 tls(false);
+    rite::timer_wheel        wheel(std::chrono::milliseconds(10));
+    connection<h2::protocol> server(std::move(*tls.server));
+    server.set_timers(&wheel);
+    server.expect_preface(std::chrono::milliseconds(100));
+    EXPECT_EQ(server.use_count(), 1);
+
+    wheel.advance(rite::timer_wheel::clock::now() + std::chrono::seconds(1));
+    EXPECT_TRUE(server.is_closed());
+    EXPECT_EQ(server.use_count(), 0);
+}
+
+TEST(H2, PrefaceCancelsTheTimeout) {
+    rite::timer_wheel wheel(std::chrono::milliseconds(10));
+    h2_pair           pair({}, {}, &wheel);
+    EXPECT_EQ(pair.server->use_count(), 0);
+    wheel.advance(rite::timer_wheel::clock::now() + std::chrono::seconds(1));
+    EXPECT_FALSE(pair.server->is_closed());
+}
+
+TEST(H2, ResetWhileWriterIsParked) {
+    // Without any window the writer parks after the HEADERS
+    h2_pair pair({}, h2::settings{ .initial_window_size = 0 });
+    ASSERT_EQ(pair.request(1), std::vector<h2::stream_id>{ 1 });
+
+    bool        finished = false;
+    std::thread writer([&]() {
+        http_response response(http_status_code::eOk, "text/plain", "hello");
+        response.event(http_response::event::finish, [&finished](http_response &) { finished = true; });
+        pair.server->respond(1, std::move(response));
+    });
+    h2::frame headers = pair.next();
+    EXPECT_EQ(headers.type, h2::frame::HEADERS);
+    EXPECT_EQ(headers.stream_identifier, 1);
+
+    // Well before the keep-alive runs out
+    auto reset_at = std::chrono::steady_clock::now();
+    pair.send(rst_stream(1, h2::error_code::CANCEL));
+    writer.join();
+    EXPECT_LT(std::chrono::steady_clock::now() - reset_at, std::chrono::milliseconds(500));
+    EXPECT_TRUE(finished);
+    EXPECT_FALSE(pair.server->is_closed());
+    {
+        auto lock = pair.server->lock();
+        EXPECT_FALSE(pair.server->streams_.contains(1));
+        EXPECT_FALSE(pair.server->flow_.contains(1));
+    }
+
+    // Nothing was sent for the stream, the connection still answers
+    pair.send(packed(h2::frame{ .length = 8, .type = h2::frame::PING, .flags = 0, .stream_identifier = 0, .data = std::vector<std::byte>(8) }));
+    EXPECT_EQ(pair.next().type, h2::frame::PING);
+}
+
+TEST(H2, StreamIsResetWhenTheWindowNeverOpens) {
+    h2_pair pair({}, h2::settings{ .initial_window_size = 0 });
+    ASSERT_EQ(pair.request(1), std::vector<h2::stream_id>{ 1 });
+
+    // Gives up after the keep-alive and tells the peer
+    pair.server->respond(1, http_response(http_status_code::eOk, "text/plain", "hello"));
+    EXPECT_EQ(pair.next().type, h2::frame::HEADERS);
+    h2::frame reset = pair.next();
+    EXPECT_EQ(reset.type, h2::frame::RST_STREAM);
+    EXPECT_EQ(reset.stream_identifier, 1);
+    EXPECT_EQ(error_of(reset), static_cast<uint32_t>(h2::error_code::CANCEL));
+    EXPECT_FALSE(pair.server->is_closed());
+    auto lock = pair.server->lock();
+    EXPECT_FALSE(pair.server->streams_.contains(1));
+}
+
+TEST(H2, RefusesStreamsBeyondTheLimit) {
+    h2_pair pair(h2::settings{ .max_concurrent_streams = 1 }, {});
+    // Still sending its body, the stream stays open
+    EXPECT_TRUE(pair.request(1, false).empty());
+
+    EXPECT_TRUE(pair.request(3).empty());
+    h2::frame reset = pair.next();
+    EXPECT_EQ(reset.type, h2::frame::RST_STREAM);
+    EXPECT_EQ(reset.stream_identifier, 3);
+    EXPECT_EQ(error_of(reset), static_cast<uint32_t>(h2::error_code::REFUSED_STREAM));
+    EXPECT_FALSE(pair.server->is_closed());
+}
+
+TEST(H2, ResetsOversizedHeaderLists) {
+    h2_pair pair(h2::settings{ .max_header_list_size = 256 }, {});
+    EXPECT_TRUE(pair.request(1, true, { { "x-large", std::string(300, 'x') } }).empty());
+    h2::frame reset = pair.next();
+    EXPECT_EQ(reset.type, h2::frame::RST_STREAM);
+    EXPECT_EQ(reset.stream_identifier, 1);
+    EXPECT_EQ(error_of(reset), static_cast<uint32_t>(h2::error_code::PROTOCOL_ERROR));
+
+    // The block was still decoded, later requests go through
+    EXPECT_EQ(pair.request(3), std::vector<h2::stream_id>{ 3 });
+}
+
+TEST(H2, OverrunWindowIsAFlowControlError) {
+    h2_pair pair({}, {});
+    EXPECT_TRUE(pair.request(1, false).empty());
+
+    // One frame larger than the whole receive window
+    pair.send(packed(h2::frame{ .length = 70000, .type = h2::frame::DATA, .flags = 0, .stream_identifier = 1, .data = std::vector<std::byte>(70000) }));
+    h2::frame goaway = pair.next();
+    EXPECT_EQ(goaway.type, h2::frame::GOAWAY);
+    EXPECT_EQ(goaway.stream_identifier, 0);
+    ASSERT_EQ(goaway.data.size(), 8);
+    EXPECT_EQ(error_of(h2::frame{ .data = std::vector<std::byte>(goaway.data.begin(), goaway.data.begin() + 4) }), 1);
+    EXPECT_EQ(error_of(h2::frame{ .data = std::vector<std::byte>(goaway.data.begin() + 4, goaway.data.end()) }), static_cast<uint32_t>(h2::error_code::FLOW_CONTROL_ERROR));
+    EXPECT_TRUE(pair.server->is_closed());
+}
+
+TEST(H2, StalledWriterDoesNotBlockReading) {
+    constexpr uint32_t WINDOW = 1 << 30;
+    h2_pair            pair({}, h2::settings{ .initial_window_size = WINDOW });
+    ASSERT_EQ(pair.request(1), std::vector<h2::stream_id>{ 1 });
+    pair.send(window_update(0, WINDOW - h2::DEFAULT_WINDOW_SIZE));
+
+    // Far more than the socket buffers hold, the client never reads
+    std::thread writer([&]() { pair.server->respond(1, http_response(http_status_code::eOk, "text/plain", std::string(32 << 20, 'x'))); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    auto sent_at = std::chrono::steady_clock::now();
+    pair.send(window_update(1, 1));
+    EXPECT_LT(std::chrono::steady_clock::now() - sent_at, std::chrono::milliseconds(100));
+    // The writer gives up after the keep-alive
+    writer.join();
+}
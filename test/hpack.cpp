@@ -186,3 +186,141 @@ TEST(HPack, FailsOnGibberish) {
     // Test for eUnknownHeader, 0xFF counts as though an indexed header.
     EXPECT_EQ(hpack.parse(frame(PAYLOAD, true)), h2::hpack::error::eInvalid);
 }
+
+TEST(HPack, SerializerPicksShorterStringEncoding) {
+    serializer<h2::hpack> tx;
+    // "rite" takes 3 octets Huffman coded, "{}{}" would take 8
+    const h2::hpack::header headers[] = { { "server", "rite" }, { "server", "{}{}" } };
+    tx.serialize(headers);
+    auto block = tx.finish(1);
+
+    // Both reuse the name of static entry 54, with incremental indexing
+    ASSERT_EQ(block.data.size(), 1 + 1 + 3 + 1 + 1 + 4);
+    EXPECT_EQ(block.data[1], std::byte{ 0x83 });
+    EXPECT_EQ(block.data[6], std::byte{ 0x04 });
+    EXPECT_EQ(std::string(reinterpret_cast<const char *>(block.data.data() + 7), 4), "{}{}");
+
+    parser<h2::hpack> rx;
+    ASSERT_EQ(rx.parse(block), h2::hpack::error::eDone);
+    auto decoded = rx.result();
+    ASSERT_EQ(decoded.size(), 2);
+    EXPECT_EQ(decoded[0].value, "rite");
+    EXPECT_EQ(decoded[1].value, "{}{}");
+}
+
+TEST(HPack, StaticTableLookup) {
+    serializer<h2::hpack> tx;
+    auto                  full = tx.search_index({ ":status", "200" });
+    ASSERT_TRUE(std::holds_alternative<serializer<h2::hpack>::fully_indexed>(full));
+    EXPECT_EQ(std::get<serializer<h2::hpack>::fully_indexed>(full).index, 8);
+
+    // Names match in any case, the first entry of a name is used
+    auto name = tx.search_index({ "Content-Type", "text/html" });
+    ASSERT_TRUE(std::holds_alternative<serializer<h2::hpack>::key_indexed>(name));
+    EXPECT_EQ(std::get<serializer<h2::hpack>::key_indexed>(name).index, 31);
+    name = tx.search_index({ ":method", "PUT" });
+    ASSERT_TRUE(std::holds_alternative<serializer<h2::hpack>::key_indexed>(name));
+    EXPECT_EQ(std::get<serializer<h2::hpack>::key_indexed>(name).index, 2);
+
+    EXPECT_TRUE(std::holds_alternative<serializer<h2::hpack>::literal>(tx.search_index({ "x-request-id", "1" })));
+
+    // Every entry, the last one included, decodes from its index
+    parser<h2::hpack> rx;
+    const char        PAYLOAD_DATA[] = "\x81\xbd";
+    EXPECT_EQ(rx.parse(frame(std::string(PAYLOAD_DATA, 2), true)), h2::hpack::error::eDone);
+    auto headers = rx.result();
+    ASSERT_EQ(headers.size(), 2);
+    EXPECT_EQ(headers[0].key, ":authority");
+    EXPECT_EQ(headers[1].key, "www-authenticate");
+}
+
+TEST(HPack, SerializerLowercasesLiteralNames) {
+    serializer<h2::hpack>   tx;
+    const h2::hpack::header headers[] = { { "X-Request-ID", "abc" } };
+    tx.serialize(headers);
+
+    parser<h2::hpack> rx;
+    ASSERT_EQ(rx.parse(tx.finish(1)), h2::hpack::error::eDone);
+    auto decoded = rx.result();
+    ASSERT_EQ(decoded.size(), 1);
+    EXPECT_EQ(decoded[0].key, "x-request-id");
+    EXPECT_EQ(decoded[0].value, "abc");
+}
+
+TEST(HPack, DynamicTableEvictsBySize) {
+    // Every entry below takes 2 + 32 octets
+    h2::dynamic_table table(100);
+    table.insert("a", "1");
+    table.insert("b", "2");
+    table.insert("c", "3");
+    ASSERT_EQ(table.entries(), 2);
+    EXPECT_EQ(table.size(), 68);
+    EXPECT_EQ(table[0].key, "c");
+    EXPECT_EQ(table[1].key, "b");
+
+    table.resize(40);
+    ASSERT_EQ(table.entries(), 1);
+    EXPECT_EQ(table[0].key, "c");
+
+    // An entry larger than the table empties it
+    table.insert("d", std::string(10, 'x'));
+    EXPECT_EQ(table.entries(), 0);
+    EXPECT_EQ(table.size(), 0);
+}
+
+TEST(HPack, SerializerIndexesRepeatedHeaders) {
+    serializer<h2::hpack>   tx;
+    parser<h2::hpack>       rx;
+    const h2::hpack::header headers[] = { { ":status", "200" }, { "Content-Type", "text/html; charset=utf-8" }, { "server", "rite" }, { "set-cookie", "session=0123456789abcdef; Path=/; HttpOnly" }, { "content-length", "1234" } };
+
+    tx.serialize(headers);
+    auto first = tx.finish(1);
+    ASSERT_EQ(rx.parse(first), h2::hpack::error::eDone);
+    auto decoded = rx.result();
+    EXPECT_EQ(decoded.size(), 5);
+
+    // Everything but the content length is indexed now, one octet each
+    tx.serialize(headers);
+    auto second = tx.finish(3);
+    EXPECT_LE(second.data.size(), 4 + 2 + 4);
+    EXPECT_LT(second.data.size(), first.data.size() / 5);
+
+    ASSERT_EQ(rx.parse(second), h2::hpack::error::eDone);
+    decoded = rx.result();
+    ASSERT_EQ(decoded.size(), 5);
+    EXPECT_EQ(decoded[1].key, "content-type");
+    EXPECT_EQ(decoded[1].value, "text/html; charset=utf-8");
+    EXPECT_EQ(decoded[3].value, "session=0123456789abcdef; Path=/; HttpOnly");
+    EXPECT_EQ(decoded[4].value, "1234");
+
+    // Both ends agree on the table
+    EXPECT_EQ(rx.header_map_.entries(), 3);
+    EXPECT_EQ(rx.header_map_.size(), tx.header_map_.size());
+}
+
+TEST(HPack, SerializerAnnouncesTableSize) {
+    serializer<h2::hpack>   tx;
+    parser<h2::hpack>       rx;
+    const h2::hpack::header headers[] = { { "server", "rite" } };
+    tx.serialize(headers);
+    ASSERT_EQ(rx.parse(tx.finish(1)), h2::hpack::error::eDone);
+    EXPECT_EQ(h2::hpack::headers(rx.result()).size(), 1);
+    EXPECT_EQ(rx.header_map_.entries(), 1);
+
+    // The peer shrank the table and grew it again, both sizes are
+    // announced and the table is emptied on the way.
+    tx.max_table_size(0);
+    tx.max_table_size(1 << 16);
+    tx.serialize(headers);
+    auto block = tx.finish(3);
+    ASSERT_GE(block.data.size(), 4);
+    EXPECT_EQ(block.data[0], std::byte{ 0x20 });
+    EXPECT_EQ(block.data[1], std::byte{ 0x3f });
+
+    ASSERT_EQ(rx.parse(block), h2::hpack::error::eDone);
+    auto decoded = rx.result();
+    ASSERT_EQ(decoded.size(), 1);
+    EXPECT_EQ(decoded[0].value, "rite");
+    EXPECT_EQ(rx.header_map_.entries(), 1);
+    EXPECT_EQ(rx.header_map_.max_size(), h2::DEFAULT_HEADER_TABLE_SIZE);
+}
@@ -0,0 +1,240 @@
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <functional>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <timer_wheel.hpp>
+#include <unistd.h>
+
+#include <http/behaviour.hpp>
+#include <plain.hpp>
+#include <protocols/http1.hpp>
+#include <tls.hpp>
+
+#include "tls_pair.hpp"
+
+namespace {
+// Send `request` through a socketpair to a connection answering with
+// `respond`, returns everything written back.
+std::string
+exchange(std::string_view request, std::function<http_response()> respond) {
+    int fds[2];
+    EXPECT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+    EXPECT_EQ(::write(fds[1], request.data(), request.size()), static_cast<ssize_t>(request.size()));
+
+    rite::http::layer layer;
+    layer.add_endpoint(rite::http::endpoint{ .method = GET | HEAD, .path = rite::http::path("/"), .handler = [&respond](http_request &, rite::http::path::result) { return respond(); } });
+
+    connection<http1<plain>> con(fds[0], {}, 0);
+    con.take();
+    rite::http::serve(&con, layer);
+
+    std::string received;
+    char        chunk[4096];
+    ssize_t     bytes;
+    while ((bytes = ::read(fds[1], chunk, sizeof(chunk))) > 0)
+        received.append(chunk, bytes);
+    ::close(fds[1]);
+    return received;
+}
+
+// A response without a length, its body streamed in `slices`
+http_response
+streamed(std::vector<std::string> slices, bool empty_last = false) {
+    http_response response;
+    response.set_status_code(http_status_code::eOk);
+    for (size_t i = 0; i < slices.size(); ++i) {
+        if (i + 1 == slices.size() && !empty_last)
+            response.body(slices[i]);
+        else
+            response.stream(std::string_view(slices[i]));
+    }
+    if (empty_last)
+        response.stream(rite::buffer());
+    return response;
+}
+
+std::string
+body(const std::string &response) {
+    size_t end = response.find("\r\n\r\n");
+    return end == std::string::npos ? std::string() : response.substr(end + 4);
+}
+};
+
+TEST(Http1, StreamedBodiesAreChunked) {
+    std::string response = exchange("GET / HTTP/1.1\r\n\r\n", []() { return streamed({ "hello", "", " world" }); });
+    EXPECT_EQ(response.rfind("HTTP/1.1 200 OK\r\n", 0), 0);
+    EXPECT_NE(response.find("Transfer-Encoding: chunked\r\n"), std::string::npos);
+    // The empty slice must not end the body early
+    EXPECT_EQ(body(response), "5\r\nhello\r\n6\r\n world\r\n0\r\n\r\n");
+}
+
+TEST(Http1, EmptyLastSliceEndsTheBody) {
+    std::string response = exchange("GET / HTTP/1.1\r\n\r\n", []() { return streamed({ "abc" }, true); });
+    EXPECT_EQ(body(response), "3\r\nabc\r\n0\r\n\r\n");
+
+    response = exchange("GET / HTTP/1.1\r\n\r\n", []() { return streamed({}, true); });
+    EXPECT_EQ(body(response), "0\r\n\r\n");
+}
+
+TEST(Http1, ContentLengthIsMatchedCaseInsensitively) {
+    std::string response = exchange("GET / HTTP/1.1\r\n\r\n", []() {
+        http_response response = streamed({ "hello" });
+        response.set_header("content-length", "5");
+        return response;
+    });
+    EXPECT_EQ(response.find("Transfer-Encoding"), std::string::npos);
+    EXPECT_EQ(response.find("Connection: close"), std::string::npos);
+    EXPECT_EQ(body(response), "hello");
+}
+
+TEST(Http1, Http10BodiesAreDelimitedByClosing) {
+    std::string response = exchange("GET / HTTP/1.0\r\nConnection: keep-alive\r\n\r\n", []() { return streamed({ "hello", " world" }); });
+    EXPECT_EQ(response.rfind("HTTP/1.1 200 OK\r\n", 0), 0);
+    EXPECT_EQ(response.find("Transfer-Encoding"), std::string::npos);
+    EXPECT_NE(response.find("Connection: close\r\n"), std::string::npos);
+    EXPECT_EQ(body(response), "hello world");
+}
+
+TEST(Http1, HeadRequestsGetOnlyTheHead) {
+    std::string response = exchange("HEAD / HTTP/1.1\r\n\r\nGET / HTTP/1.1\r\n\r\n", []() { return streamed({ "hello" }); });
+    // The connection stays usable, the GET is answered right after
+    std::string head = "HTTP/1.1 200 OK\r\n";
+    ASSERT_EQ(response.rfind(head, 0), 0);
+    size_t next = response.find(head, 1);
+    ASSERT_NE(next, std::string::npos);
+    std::string first = response.substr(0, next);
+    EXPECT_EQ(first.find("Transfer-Encoding"), std::string::npos);
+    EXPECT_EQ(first.find("Connection: close"), std::string::npos);
+    EXPECT_EQ(body(first), "");
+    EXPECT_EQ(body(response.substr(next)), "5\r\nhello\r\n0\r\n\r\n");
+}
+
+TEST(Http1, FailedWritesCloseTheConnection) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    std::string_view requests = "GET / HTTP/1.1\r\n\r\nGET / HTTP/1.1\r\n\r\n";
+    ASSERT_EQ(::write(fds[1], requests.data(), requests.size()), static_cast<ssize_t>(requests.size()));
+    // Every write of the server fails from here on
+    ::shutdown(fds[1], SHUT_RD);
+
+    int               chunks = 0, finished = 0;
+    rite::http::layer layer;
+    layer.add_endpoint(rite::http::endpoint{ .method = GET, .path = rite::http::path("/"), .handler = [&](http_request &, rite::http::path::result) {
+        http_response response = streamed({ "a", "b", "c" });
+        response.event(http_response::event::chunk, [&chunks](http_response &) { chunks++; });
+        response.event(http_response::event::finish, [&finished](http_response &) { finished++; });
+        return response;
+    } });
+
+    connection<http1<plain>> con(fds[0], {}, 0);
+    con.take();
+    rite::http::serve(&con, layer);
+    ::close(fds[1]);
+
+    // The body is still drained, the response behind is dropped
+    EXPECT_EQ(chunks, 3);
+    EXPECT_EQ(finished, 1);
+    EXPECT_TRUE(con.is_closed());
+}
+
+TEST(Http1, SlowHeadsAreCutOff) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    std::string_view partial = "GET / HTTP/1.1\r\nHost: localhost\r\n";
+    ASSERT_EQ(::write(fds[1], partial.data(), partial.size()), static_cast<ssize_t>(partial.size()));
+
+    rite::timer_wheel        wheel(std::chrono::milliseconds(10));
+    rite::http::layer        layer;
+    connection<http1<plain>> con(fds[0], {}, 0);
+    con.set_timers(&wheel);
+    con.head_timeout = std::chrono::milliseconds(100);
+    con.take();
+    rite::http::serve(&con, layer);
+
+    // The armed timeout keeps the connection referenced
+    auto armed_at = rite::timer_wheel::clock::now();
+    EXPECT_EQ(con.use_count(), 1);
+    wheel.advance(armed_at + std::chrono::milliseconds(50));
+    EXPECT_FALSE(con.is_closed());
+    wheel.advance(armed_at + std::chrono::seconds(1));
+    EXPECT_TRUE(con.is_closed());
+    EXPECT_EQ(con.use_count(), 0);
+    ::close(fds[1]);
+}
+
+TEST(Http1, CompleteHeadsCancelTheTimeout) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+
+    rite::timer_wheel wheel(std::chrono::milliseconds(10));
+    rite::http::layer layer;
+    layer.add_endpoint(rite::http::endpoint{ .method = GET, .path = rite::http::path("/"), .handler = [](http_request &, rite::http::path::result) { return http_response(http_status_code::eOk, "text/plain", "hello"); } });
+    connection<http1<plain>> con(fds[0], {}, 0);
+    con.set_timers(&wheel);
+    con.head_timeout = std::chrono::milliseconds(100);
+
+    for (std::string_view part : { "GET / HTTP/1.1\r\nHost: local", "host\r\n\r\n" }) {
+        ASSERT_EQ(::write(fds[1], part.data(), part.size()), static_cast<ssize_t>(part.size()));
+        con.take();
+        rite::http::serve(&con, layer);
+    }
+    EXPECT_EQ(con.use_count(), 0);
+    wheel.advance(rite::timer_wheel::clock::now() + std::chrono::seconds(1));
+    EXPECT_FALSE(con.is_closed());
+    ::close(fds[1]);
+}
+
+TEST(Http1, PipelinedRequestsOverTls) {
+    // Asynchronous handlers write their responses from other threads
+    // while the next requests are still being read.
+    tls_pair pair(false);
+    ASSERT_TRUE(pair.handshaken());
+    connection<http1<tls>> con(std::move(*pair.server));
+
+    // Handler threads still touch the layer after releasing the
+    // connection, it outlives them.
+    static rite::http::layer layer;
+    rite::http::endpoint     endpoint{ .method = GET, .path = rite::http::path("/"), .handler = [](http_request &, rite::http::path::result) { return http_response(http_status_code::eOk, "text/plain", "hello"); } };
+    endpoint.asynchronous = true;
+    layer.add_endpoint(std::move(endpoint));
+
+    constexpr int ROUNDS = 20, PIPELINED = 5;
+    std::string   requests;
+    for (int i = 0; i < PIPELINED; ++i)
+        requests += "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    for (int round = 0; round < ROUNDS; ++round) {
+        ASSERT_EQ(SSL_write(pair.client, requests.data(), requests.size()), static_cast<int>(requests.size()));
+        struct pollfd readable = { .fd = con.socket(), .events = POLLIN, .revents = 0 };
+        ASSERT_EQ(::poll(&readable, 1, 5000), 1);
+        con.take();
+        rite::http::serve(&con, layer);
+    }
+
+    std::string response = "HTTP/1.1 200 OK\r\n";
+    std::string received;
+    size_t      responses = 0;
+    char        chunk[4096];
+    while (responses < ROUNDS * PIPELINED) {
+        int bytes = SSL_read(pair.client, chunk, sizeof(chunk));
+        ASSERT_GT(bytes, 0);
+        received.append(chunk, bytes);
+        responses = 0;
+        for (size_t at = received.find(response); at != std::string::npos; at = received.find(response, at + 1))
+            responses += received.find("\r\n\r\nhello", at) != std::string::npos;
+    }
+    EXPECT_EQ(responses, ROUNDS * PIPELINED);
+
+    // Handlers release their reference after writing
+    for (int i = 0; i < 5000 && con.use_count() > 0; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    EXPECT_EQ(con.use_count(), 0);
+}
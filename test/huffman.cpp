@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <protocols/h2/hpack.hpp>
+#include <protocols/h2/huffman.hpp>
+
+namespace {
+std::optional<std::string>
+decode(std::initializer_list<uint8_t> list) {
+    std::vector<std::byte> data;
+    for (uint8_t byte : list)
+        data.push_back(static_cast<std::byte>(byte));
+    std::string out;
+    if (!h2::hpack::codec.decode(data, out))
+        return std::nullopt;
+    return out;
+}
+};
+
+// RFC 7541 Appendix C.4
+TEST(Huffman, DecodesRfcExamples) {
+    EXPECT_EQ(decode({ 0xf1, 0xe3, 0xc2, 0xe5, 0xf2, 0x3a, 0x6b, 0xa0, 0xab, 0x90, 0xf4, 0xff }), "www.example.com");
+    EXPECT_EQ(decode({ 0xa8, 0xeb, 0x10, 0x64, 0x9c, 0xbf }), "no-cache");
+    EXPECT_EQ(decode({ 0x25, 0xa8, 0x49, 0xe9, 0x5b, 0xa9, 0x7d, 0x7f }), "custom-key");
+    EXPECT_EQ(decode({ 0x25, 0xa8, 0x49, 0xe9, 0x5b, 0xb8, 0xe8, 0xb4, 0xbf }), "custom-value");
+    EXPECT_EQ(decode({}), "");
+}
+
+TEST(Huffman, EncodesRfcExamples) {
+    std::vector<std::byte> out;
+    EXPECT_EQ(h2::hpack::codec.encode_into("no-cache", out), 6);
+    EXPECT_EQ(out, (std::vector<std::byte>{ std::byte{ 0xa8 }, std::byte{ 0xeb }, std::byte{ 0x10 }, std::byte{ 0x64 }, std::byte{ 0x9c }, std::byte{ 0xbf } }));
+
+    // Appends to what is there
+    EXPECT_EQ(h2::hpack::codec.encode_into("", out), 0);
+    EXPECT_EQ(h2::hpack::codec.encode_into("www.example.com", out), 12);
+    EXPECT_EQ(out.size(), 18);
+}
+
+TEST(Huffman, EncodedLength) {
+    EXPECT_EQ(h2::hpack::codec.encoded_length(""), 0);
+    EXPECT_EQ(h2::hpack::codec.encoded_length("www.example.com"), 12);
+    EXPECT_EQ(h2::hpack::codec.encoded_length("custom-value"), 9);
+    // Rare octets have codes longer than 8 bits
+    EXPECT_EQ(h2::hpack::codec.encoded_length("{}"), 4);
+    static_assert(h2::hpack::codec.encoded_length("no-cache") == 6);
+}
+
+TEST(Huffman, RoundTripsEveryOctet) {
+    std::string input;
+    for (int i = 0; i < 256; ++i)
+        input.push_back(static_cast<char>(i));
+    for (size_t length = 1; length <= input.size(); length += 37) {
+        std::vector<std::byte> encoded;
+        std::string            decoded;
+        EXPECT_EQ(h2::hpack::codec.encode_into(std::string_view(input).substr(0, length), encoded), h2::hpack::codec.encoded_length(std::string_view(input).substr(0, length)));
+        EXPECT_TRUE(h2::hpack::codec.decode(encoded, decoded));
+        EXPECT_EQ(decoded, input.substr(0, length));
+    }
+}
+
+TEST(Huffman, RejectsInvalidPadding) {
+    // 'a' (00011) padded with ones
+    EXPECT_EQ(decode({ 0x1f }), "a");
+    // Padding that is not a prefix of EOS
+    EXPECT_FALSE(decode({ 0x18 }).has_value());
+    // Padding longer than 7 bits
+    EXPECT_FALSE(decode({ 0x1f, 0xff }).has_value());
+    // EOS itself
+    EXPECT_FALSE(decode({ 0xff, 0xff, 0xff, 0xff }).has_value());
+}
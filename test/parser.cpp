@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include <span>
+#include <string>
+#include <string_view>
+
+#include <http/parser.hpp>
+
+namespace {
+std::span<const std::byte>
+bytes(std::string_view s) {
+    return std::span<const std::byte>(reinterpret_cast<const std::byte *>(s.data()), s.size());
+}
+
+parser<http_request>::result
+parse_head(std::string_view s) {
+    parser<http_request>::head head;
+    return parser<http_request>{}.parse_head(bytes(s), head);
+}
+};
+
+TEST(HttpParser, ParsesRequest) {
+    std::string request = "POST /upload/a%20b?x=1&y=two HTTP/1.1\r\n"
+                          "Host: localhost:8080\r\n"
+                          "Content-Type:text/plain  \r\n"
+                          "Cookie: session=abc; theme=dark\r\n"
+                          "Content-Length: 5\r\n"
+                          "\r\n"
+                          "hello";
+
+    http_request req;
+    ASSERT_TRUE(parser<http_request>{}.parse(nullptr, bytes(request), req));
+    EXPECT_EQ(req.method(), http_method::POST);
+    EXPECT_EQ(req.path(), "/upload/a b");
+    EXPECT_EQ(req.query().get<std::string>("y").value(), "two");
+    EXPECT_EQ(req.headers().size(), 4);
+    EXPECT_EQ(req.header("host").value(), "localhost:8080");
+    // Lookups are case insensitive, values are trimmed
+    EXPECT_EQ(req.header("CONTENT-TYPE").value(), "text/plain");
+    EXPECT_EQ((*req.headers().begin()).first, "host");
+    EXPECT_EQ(req.cookies().get<std::string>("theme").value(), "dark");
+    EXPECT_EQ(std::string(reinterpret_cast<const char *>(req.body().data()), req.body().size()), "hello");
+}
+
+TEST(HttpParser, DecodesEveryMethod) {
+    for (std::string_view method : { "GET", "HEAD", "POST", "PUT", "DELETE", "CONNECT", "OPTIONS", "TRACE", "PATCH" }) {
+        EXPECT_TRUE(parser<http_request>::decode_method(method).has_value());
+    }
+    EXPECT_FALSE(parser<http_request>::decode_method("GETS").has_value());
+    EXPECT_FALSE(parser<http_request>::decode_method("get").has_value());
+}
+
+TEST(HttpParser, IncompleteHeads) {
+    using result = parser<http_request>::result;
+    std::string_view request = "GET / HTTP/1.1\r\nHost: a\r\n\r\n";
+    for (size_t i = 0; i < request.size(); ++i) {
+        EXPECT_EQ(parse_head(request.substr(0, i)), result::eIncomplete);
+    }
+    EXPECT_EQ(parse_head(request), result::eComplete);
+}
+
+TEST(HttpParser, RejectsMalformedInputEarly) {
+    using result = parser<http_request>::result;
+    // Decided before the rest of the request arrived
+    EXPECT_EQ(parse_head("get "), result::eInvalid);
+    EXPECT_EQ(parse_head("\x16\x03\x01"), result::eInvalid);
+    EXPECT_EQ(parse_head("BREW / HTTP/1.1\r\n"), result::eInvalid);
+    EXPECT_EQ(parse_head("GET / HTTP/2"), result::eInvalid);
+    EXPECT_EQ(parse_head("GET / HTTP/1.1\n"), result::eInvalid);
+
+    EXPECT_EQ(parse_head("GET / HTTP/1.1\r\nHost : a\r\n\r\n"), result::eInvalid);
+    EXPECT_EQ(parse_head("GET / HTTP/1.1\r\nHost: a\r\n folded\r\n\r\n"), result::eInvalid);
+    EXPECT_EQ(parse_head("GET / HTTP/1.1\r\nHost: a\nb\r\n\r\n"), result::eInvalid);
+    EXPECT_EQ(parse_head("GET / HTTP/1.1\r\nContent-Length: 1x\r\n\r\n"), result::eInvalid);
+    EXPECT_EQ(parse_head("GET / HTTP/1.1\r\nContent-Length: 1\r\nContent-Length: 2\r\n\r\n"), result::eInvalid);
+    EXPECT_EQ(parse_head("GET / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"), result::eInvalid);
+}
+
+TEST(HttpParser, LimitsHeaderCount) {
+    std::string request = "GET / HTTP/1.0\r\n";
+    for (size_t i = 0; i <= parser<http_request>::MAX_HEADERS; ++i)
+        request += "X-Header-" + std::to_string(i) + ": value\r\n";
+    request += "\r\n";
+    EXPECT_EQ(parse_head(request), parser<http_request>::result::eInvalid);
+}
+
+TEST(HttpParser, ResumesAfterTheLastCompleteLine) {
+    using result = parser<http_request>::result;
+    std::string request = "GET /index.html HTTP/1.1\r\nHost: localhost\r\nAccept: */*\r\n\r\n";
+
+    // Feed byte by byte, like a slow client would
+    parser<http_request>::head head;
+    for (size_t i = 1; i < request.size(); ++i) {
+        ASSERT_EQ(parser<http_request>{}.parse_head(bytes(std::string_view(request).substr(0, i)), head), result::eIncomplete);
+    }
+
+    // Move the buffer, like a growing receive buffer would
+    std::string moved = request;
+    head.rebase(reinterpret_cast<const std::byte *>(request.data()), reinterpret_cast<const std::byte *>(moved.data()));
+    request.assign(request.size(), 'x');
+    ASSERT_EQ(parser<http_request>{}.parse_head(bytes(moved), head), result::eComplete);
+    EXPECT_EQ(head.target, "/index.html");
+    ASSERT_EQ(head.field_count, 2);
+    EXPECT_EQ(head.fields[1].first, "Accept");
+    EXPECT_EQ(head.fields[1].second, "*/*");
+    EXPECT_EQ(head.length, moved.size());
+}
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+
+#include <http/reader.hpp>
+
+namespace {
+// Hand `data` to `r` the way a socket read would
+void
+receive(rite::http::reader &r, std::string_view data) {
+    auto space = r.prepare(data.size());
+    std::copy_n(reinterpret_cast<const std::byte *>(data.data()), data.size(), space.begin());
+    r.commit(data.size());
+}
+
+std::string
+body(const http_request &req) {
+    return std::string(reinterpret_cast<const char *>(req.body().data()), req.body().size());
+}
+};
+
+TEST(HttpReader, RequestSplitAcrossReads) {
+    using result = rite::http::reader::result;
+    rite::http::reader r;
+    http_request       req;
+
+    receive(r, "POST /upload HTTP/1.1\r\nHo");
+    EXPECT_EQ(r.next(nullptr, req), result::eIncomplete);
+    receive(r, "st: localhost\r\nContent-Length: 11\r\n");
+    EXPECT_EQ(r.next(nullptr, req), result::eIncomplete);
+    receive(r, "\r\nhello ");
+    EXPECT_EQ(r.next(nullptr, req), result::eIncomplete);
+    receive(r, "world");
+    ASSERT_EQ(r.next(nullptr, req), result::eComplete);
+
+    EXPECT_EQ(req.path(), "/upload");
+    EXPECT_EQ(req.header("host").value(), "localhost");
+    EXPECT_EQ(body(req), "hello world");
+    EXPECT_EQ(r.buffered(), 0);
+}
+
+TEST(HttpReader, KeepsLeftoverBytes) {
+    using result = rite::http::reader::result;
+    rite::http::reader r;
+
+    receive(r, "GET /a HTTP/1.1\r\n\r\nGET /b HTTP/1.1\r\n\r\nGET /c HT");
+    http_request a, b, c;
+    ASSERT_EQ(r.next(nullptr, a), result::eComplete);
+    ASSERT_EQ(r.next(nullptr, b), result::eComplete);
+    EXPECT_EQ(r.next(nullptr, c), result::eIncomplete);
+    EXPECT_EQ(a.path(), "/a");
+    EXPECT_EQ(b.path(), "/b");
+
+    receive(r, "TP/1.1\r\n\r\n");
+    ASSERT_EQ(r.next(nullptr, c), result::eComplete);
+    EXPECT_EQ(c.path(), "/c");
+}
+
+TEST(HttpReader, LargeBodiesAndGrowingBuffers) {
+    using result = rite::http::reader::result;
+    rite::http::reader r;
+
+    // Many small reads of a head much larger than the initial buffer
+    std::string head = "PUT /big HTTP/1.1\r\n";
+    for (int i = 0; i < 40; ++i)
+        head += "X-Padding-" + std::to_string(i) + ": " + std::string(200, 'p') + "\r\n";
+    std::string payload(100000, 'b');
+    head += "Content-Length: " + std::to_string(payload.size()) + "\r\n\r\n";
+    std::string request = head + payload;
+
+    http_request req;
+    for (size_t offset = 0; offset < request.size(); offset += 1000) {
+        EXPECT_EQ(r.next(nullptr, req), result::eIncomplete);
+        receive(r, std::string_view(request).substr(offset, 1000));
+    }
+    ASSERT_EQ(r.next(nullptr, req), result::eComplete);
+    EXPECT_EQ(req.headers().size(), 41);
+    EXPECT_EQ(req.header("x-padding-39").value(), std::string(200, 'p'));
+    EXPECT_EQ(body(req), payload);
+}
+
+TEST(HttpReader, RejectsGarbage) {
+    rite::http::reader r;
+    http_request       req;
+    receive(r, "\x16\x03\x01\x02\x00\x01\x00\x01\xfc\x03\x03");
+    EXPECT_EQ(r.next(nullptr, req), rite::http::reader::result::eInvalid);
+}
+
+TEST(HttpReader, BodiesAreBufferedAsTheyArrive) {
+    using result = rite::http::reader::result;
+    rite::http::reader r;
+    r.max_body_size(size_t(1) << 30);
+    http_request req;
+
+    // Announcing a huge body doesn't make the buffer any larger
+    receive(r, "POST /upload HTTP/1.1\r\nContent-Length: 1073741823\r\n\r\n");
+    EXPECT_EQ(r.next(nullptr, req), result::eIncomplete);
+    EXPECT_LE(r.prepare().size(), rite::http::reader::MIN_READ * 2);
+
+    // Growing it again stays bounded by the step
+    std::string chunk(rite::http::reader::MAX_GROWTH, 'b');
+    for (int i = 0; i < 4; ++i)
+        receive(r, chunk);
+    EXPECT_EQ(r.next(nullptr, req), result::eIncomplete);
+    EXPECT_LE(r.prepare().size(), rite::http::reader::MAX_GROWTH + rite::http::reader::MIN_READ);
+}
+
+TEST(HttpReader, RejectsBodiesOverTheLimit) {
+    using result = rite::http::reader::result;
+    rite::http::reader r;
+    r.max_body_size(10);
+    http_request ok, large;
+
+    receive(r, "POST /a HTTP/1.1\r\nContent-Length: 10\r\n\r\n0123456789");
+    ASSERT_EQ(r.next(nullptr, ok), result::eComplete);
+    EXPECT_EQ(body(ok), "0123456789");
+
+    receive(r, "POST /b HTTP/1.1\r\nContent-Length: 11\r\n\r\n");
+    EXPECT_EQ(r.next(nullptr, large), result::eInvalid);
+}
@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <http/response_queue.hpp>
+
+namespace {
+rite::http::response_queue::entry
+numbered(int i, bool close = false) {
+    rite::http::response_queue::entry e;
+    e.response.emplace();
+    e.response->set_header("X-Index", std::to_string(i));
+    e.close = close;
+    return e;
+}
+
+int
+index(const rite::http::response_queue::entry &e) {
+    return std::stoi(e.response->headers().at("X-Index"));
+}
+};
+
+TEST(ResponseQueue, WritesInTicketOrder) {
+    rite::http::response_queue q;
+    std::vector<int>           written;
+    auto                       write = [&written](auto &e) { written.push_back(index(e)); };
+
+    uint64_t a = q.ticket(), b = q.ticket(), c = q.ticket();
+    q.complete(c, numbered(2), write);
+    q.complete(b, numbered(1), write);
+    EXPECT_TRUE(written.empty());
+
+    // Completing the head of the line flushes everything behind it
+    q.complete(a, numbered(0), write);
+    EXPECT_EQ(written, (std::vector<int>{ 0, 1, 2 }));
+}
+
+TEST(ResponseQueue, DropsResponsesAfterClose) {
+    rite::http::response_queue q;
+    std::vector<int>           written;
+    auto                       write = [&written](auto &e) { written.push_back(index(e)); };
+
+    uint64_t a = q.ticket(), b = q.ticket(), c = q.ticket();
+    q.complete(c, numbered(2), write);
+    q.complete(a, numbered(0), write);
+    q.complete(b, numbered(1, true), write);
+    EXPECT_EQ(written, (std::vector<int>{ 0, 1 }));
+}
+
+TEST(ResponseQueue, ConcurrentHandlers) {
+    constexpr int              COUNT = 32;
+    rite::http::response_queue q;
+    std::vector<int>           written;
+    std::vector<uint64_t>      tickets;
+    for (int i = 0; i < COUNT; ++i)
+        tickets.push_back(q.ticket());
+
+    std::vector<std::thread> handlers;
+    for (int i = COUNT - 1; i >= 0; --i) {
+        handlers.emplace_back([&, i]() {
+            std::this_thread::sleep_for(std::chrono::microseconds((i * 7919) % 500));
+            q.complete(tickets[i], numbered(i), [&written](auto &e) { written.push_back(index(e)); });
+        });
+    }
+    for (auto &t : handlers)
+        t.join();
+
+    ASSERT_EQ(written.size(), COUNT);
+    for (int i = 0; i < COUNT; ++i)
+        EXPECT_EQ(written[i], i);
+}
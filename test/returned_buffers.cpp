@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include <returned_buffers.hpp>
+
+TEST(ReturnedBuffers, TakesEverythingOnce) {
+    rite::returned_buffers returned(4);
+    EXPECT_EQ(returned.take([](uint16_t) {}), 0);
+
+    returned.push(2);
+    returned.push(0);
+    std::vector<uint16_t> ids;
+    EXPECT_EQ(returned.take([&ids](uint16_t id) { ids.push_back(id); }), 2);
+    EXPECT_EQ(ids, (std::vector<uint16_t>{ 0, 2 }));
+    EXPECT_EQ(returned.take([](uint16_t) {}), 0);
+
+    // Taken ids may be pushed again
+    returned.push(2);
+    EXPECT_EQ(returned.take([](uint16_t) {}), 1);
+}
+
+TEST(ReturnedBuffers, ConcurrentPushes) {
+    constexpr size_t       THREADS = 4, PER_THREAD = 1000;
+    rite::returned_buffers returned(THREADS * PER_THREAD);
+
+    std::vector<uint16_t>    ids;
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&returned, t]() {
+            for (size_t i = 0; i < PER_THREAD; ++i)
+                returned.push(t * PER_THREAD + i);
+        });
+    }
+    // The reactor takes while readers keep handing back
+    while (ids.size() < THREADS * PER_THREAD)
+        returned.take([&ids](uint16_t id) { ids.push_back(id); });
+    for (auto &thread : threads)
+        thread.join();
+
+    std::sort(ids.begin(), ids.end());
+    for (size_t i = 0; i < ids.size(); ++i)
+        EXPECT_EQ(ids[i], i);
+}
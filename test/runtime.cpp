@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <runtime.hpp>
+
+namespace {
+// A runtime never stops, its workers outlive the test
+rite::runtime &
+started(size_t workers) {
+    auto *runtime = new rite::runtime();
+    runtime->worker_threads(workers);
+    std::thread([runtime]() { runtime->start(); }).detach();
+    return *runtime;
+}
+
+// Wait up to five seconds for `done`
+template<typename F>
+bool
+eventually(F &&done) {
+    for (int i = 0; i < 5000 && !done(); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return done();
+}
+
+// Stands in for a server, runs on the thread `attach` starts
+struct attached {
+    static constexpr int TASKS = 1000;
+
+    rite::runtime     *runtime = nullptr;
+    rite::io_backend   backend_ = rite::io_backend::epoll;
+    std::atomic_bool   ran = false;
+    std::mutex         lock;
+    std::vector<int>   order;
+    std::atomic_size_t done = 0;
+
+    void operator()() {
+        ran = true;
+        for (int i = 0; i < TASKS; ++i) {
+            runtime->dispatch([this, i]() {
+                std::lock_guard<std::mutex> guard(lock);
+                order.push_back(i);
+                done++;
+            });
+        }
+    }
+};
+};
+
+TEST(Runtime, IdleWorkersSteal) {
+    rite::runtime &runtime = started(4);
+
+    // Everything is dispatched from one worker and lands in its own
+    // deque, the other workers only get to run them by stealing.
+    constexpr size_t          TASKS = 32;
+    std::mutex                lock;
+    std::set<std::thread::id> threads;
+    std::atomic_size_t        done = 0;
+    runtime.dispatch([&]() {
+        for (size_t i = 0; i < TASKS; ++i) {
+            runtime.dispatch([&]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                std::lock_guard<std::mutex> guard(lock);
+                threads.insert(std::this_thread::get_id());
+                done++;
+            });
+        }
+    });
+
+    ASSERT_TRUE(eventually([&]() { return done.load() == TASKS; }));
+    std::lock_guard<std::mutex> guard(lock);
+    EXPECT_GT(threads.size(), 1);
+}
+
+TEST(Runtime, LocalTasksRunNewestFirst) {
+    rite::runtime &runtime = started(1);
+
+    std::mutex         lock;
+    std::vector<int>   order;
+    std::atomic_size_t done = 0;
+    runtime.dispatch([&]() {
+        for (int i = 0; i < 5; ++i) {
+            runtime.dispatch([&, i]() {
+                std::lock_guard<std::mutex> guard(lock);
+                order.push_back(i);
+                done++;
+            });
+        }
+    });
+
+    ASSERT_TRUE(eventually([&]() { return done.load() == 5; }));
+    std::lock_guard<std::mutex> guard(lock);
+    EXPECT_EQ(order, (std::vector<int>{ 4, 3, 2, 1, 0 }));
+}
+
+TEST(Runtime, InjectedTasksKeepDispatchOrder) {
+    // A single worker takes injected tasks first in, first out, so every
+    // producer's tasks run in the order it dispatched them.
+    rite::runtime &runtime = started(1);
+
+    constexpr size_t                 PRODUCERS = 4, TASKS = 5000;
+    std::vector<std::vector<size_t>> order(PRODUCERS);
+    std::atomic_size_t               done = 0;
+    std::vector<std::thread>         producers;
+    for (size_t p = 0; p < PRODUCERS; ++p) {
+        producers.emplace_back([&, p]() {
+            for (size_t i = 0; i < TASKS; ++i) {
+                runtime.dispatch([&, p, i]() {
+                    order[p].push_back(i);
+                    done++;
+                });
+            }
+        });
+    }
+    for (auto &producer : producers)
+        producer.join();
+
+    ASSERT_TRUE(eventually([&]() { return done.load() == PRODUCERS * TASKS; }));
+    for (auto &sequence : order) {
+        ASSERT_EQ(sequence.size(), TASKS);
+        for (size_t i = 0; i < TASKS; ++i)
+            EXPECT_EQ(sequence[i], i);
+    }
+}
+
+TEST(Runtime, NoTaskIsLostUnderContention) {
+    // Workers keep going to sleep while producers race them, every
+    // dispatch has to wake someone up.
+    rite::runtime &runtime = started(4);
+
+    constexpr size_t         PRODUCERS = 4, TASKS = 20000;
+    std::atomic_size_t       done = 0;
+    std::vector<std::thread> producers;
+    for (size_t p = 0; p < PRODUCERS; ++p) {
+        producers.emplace_back([&]() {
+            for (size_t i = 0; i < TASKS; ++i) {
+                runtime.dispatch([&]() { done++; });
+                if (i % 1000 == 0)
+                    std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        });
+    }
+    for (auto &producer : producers)
+        producer.join();
+
+    EXPECT_TRUE(eventually([&]() { return done.load() == PRODUCERS * TASKS; }));
+}
+
+TEST(Runtime, AttachRunsOnItsOwnThread) {
+    rite::runtime &runtime = started(1);
+
+    // Outlives the detached thread attach starts
+    static attached server;
+    runtime.attach(server, rite::io_backend::io_uring);
+    EXPECT_EQ(server.runtime, &runtime);
+    EXPECT_EQ(server.backend_, rite::io_backend::io_uring);
+
+    ASSERT_TRUE(eventually([&]() { return server.done.load() == attached::TASKS; }));
+    EXPECT_TRUE(server.ran.load());
+    std::lock_guard<std::mutex> guard(server.lock);
+    for (int i = 0; i < attached::TASKS; ++i)
+        EXPECT_EQ(server.order[i], i);
+}
@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+
+#include <http/scan.hpp>
+
+using rite::http::scan::level;
+
+namespace {
+// Every level must stop at the same byte as the scalar kernel.
+void
+agree(const std::string &input) {
+    const char *begin = input.data(), *end = begin + input.size();
+    rite::http::scan::select(level::eScalar);
+    const char *token = rite::http::scan::token(begin, end);
+    const char *value = rite::http::scan::field_value(begin, end);
+
+    for (level l : { level::eSSE42, level::eAVX2 }) {
+        rite::http::scan::select(l);
+        EXPECT_EQ(rite::http::scan::token(begin, end) - begin, token - begin);
+        EXPECT_EQ(rite::http::scan::field_value(begin, end) - begin, value - begin);
+    }
+}
+};
+
+TEST(Scan, EveryByteAtEveryPosition) {
+    for (size_t length : { 1, 15, 16, 31, 32, 33, 70 }) {
+        for (size_t position = 0; position < length; ++position) {
+            for (int c = 0; c < 256; ++c) {
+                std::string input(length, 'a');
+                input[position] = static_cast<char>(c);
+                agree(input);
+                // Same within a field value
+                std::string value(length, ' ');
+                value[position] = static_cast<char>(c);
+                agree(value);
+            }
+        }
+    }
+    rite::http::scan::select(level::eAVX2);
+}
+
+TEST(Scan, RandomHeaderLines) {
+    std::mt19937 rng(7);
+    std::string  alphabet = "abcXYZ019-_.~!#$%&'*+^`|: \t\r\n\x7f\x80\xff;=\"/,{}";
+    for (int i = 0; i < 2000; ++i) {
+        std::string input(rng() % 100, ' ');
+        for (char &c : input)
+            c = alphabet[rng() % alphabet.size()];
+        agree(input);
+    }
+    rite::http::scan::select(level::eAVX2);
+}
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include <http/date.hpp>
+#include <http/serializer.hpp>
+#include <http/status_line.hpp>
+
+namespace {
+std::string
+head(const http_response &response) {
+    auto bytes = serializer<http_response>{ .serialize_body = false }(response);
+    return std::string(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+}
+};
+
+TEST(StatusLine, ReasonPhrases) {
+    EXPECT_EQ(rite::http::status_line(http_status_code::eOk), "HTTP/1.1 200 OK\r\n");
+    EXPECT_EQ(rite::http::status_line(http_status_code::eNoContent), "HTTP/1.1 204 No Content\r\n");
+    EXPECT_EQ(rite::http::status_line(http_status_code::eIMUsed), "HTTP/1.1 226 IM Used\r\n");
+    EXPECT_EQ(rite::http::status_line(http_status_code::eHTTPVersionNotSupported), "HTTP/1.1 505 HTTP Version Not Supported\r\n");
+    EXPECT_EQ(rite::http::status_line(http_status_code::eNonAuthorativeInformation), "HTTP/1.1 203 Non-Authoritative Information\r\n");
+    EXPECT_EQ(rite::http::status_line(http_status_code::eMultiStatus), "HTTP/1.1 207 Multi-Status\r\n");
+    EXPECT_EQ(rite::http::status_line(http_status_code::eRangeNotSatifiable), "HTTP/1.1 416 Range Not Satisfiable\r\n");
+    EXPECT_EQ(rite::http::status_line(http_status_code::eImATeapot), "HTTP/1.1 418 I'm a teapot\r\n");
+    EXPECT_TRUE(rite::http::status_line(static_cast<http_status_code>(299)).empty());
+    EXPECT_TRUE(rite::http::status_line(static_cast<http_status_code>(99)).empty());
+}
+
+TEST(Date, FormatsImfFixdate) {
+    auto date = rite::http::format_date(784111777);
+    EXPECT_EQ(std::string(date.data(), date.size()), "Sun, 06 Nov 1994 08:49:37 GMT");
+    date = rite::http::format_date(0);
+    EXPECT_EQ(std::string(date.data(), date.size()), "Thu, 01 Jan 1970 00:00:00 GMT");
+}
+
+TEST(Serializer, WritesStatusDateAndHeaders) {
+    http_response response(http_status_code::eNotFound, "text/plain", "nope");
+    std::string   serialized = head(response);
+    EXPECT_EQ(serialized.rfind("HTTP/1.1 404 Not Found\r\nDate: ", 0), 0);
+    EXPECT_NE(serialized.find(" GMT\r\n"), std::string::npos);
+    EXPECT_NE(serialized.find("Content-Length: 4\r\n"), std::string::npos);
+    EXPECT_NE(serialized.find("content-type: text/plain\r\n"), std::string::npos);
+    EXPECT_EQ(serialized.substr(serialized.size() - 4), "\r\n\r\n");
+}
+
+TEST(Serializer, KeepsExplicitDate) {
+    http_response response(http_status_code::eOk, "");
+    response.set_header("Date", "Sun, 06 Nov 1994 08:49:37 GMT");
+    std::string serialized = head(response);
+    EXPECT_EQ(serialized.find("Date: "), serialized.rfind("Date: "));
+    EXPECT_NE(serialized.find("Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n"), std::string::npos);
+}
+
+TEST(Serializer, UnknownCodeHasEmptyReason) {
+    http_response response(static_cast<http_status_code>(299), "");
+    EXPECT_EQ(head(response).rfind("HTTP/1.1 299 \r\n", 0), 0);
+}
+
+TEST(Serializer, ReportsLengthWhenBufferIsTooSmall) {
+    http_response response(http_status_code::eOk, "text/plain", "hello");
+    response.set_header("X-Large", std::string(1000, 'x'));
+
+    std::vector<std::byte> small(64);
+    size_t                 length = serializer<http_response>{ .serialize_body = false }(response, small);
+    EXPECT_GT(length, small.size());
+
+    std::vector<std::byte> exact(length);
+    EXPECT_EQ(serializer<http_response>{ .serialize_body = false }(response, exact), length);
+    EXPECT_EQ(std::string(reinterpret_cast<const char *>(exact.data()), exact.size()), head(response));
+}
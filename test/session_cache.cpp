@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <session_cache.hpp>
+
+using namespace std::chrono;
+
+namespace {
+std::vector<uint8_t>
+bytes(uint8_t value) {
+    return std::vector<uint8_t>(8, value);
+}
+};
+
+TEST(SessionCache, FindsInsertedSessions) {
+    rite::session_cache cache(1024, seconds(60));
+    cache.insert("a", bytes(1));
+    cache.insert("b", bytes(2));
+    EXPECT_EQ(cache.find("a"), bytes(1));
+    EXPECT_EQ(cache.find("b"), bytes(2));
+    EXPECT_FALSE(cache.find("c").has_value());
+
+    cache.erase("a");
+    EXPECT_FALSE(cache.find("a").has_value());
+    EXPECT_EQ(cache.size(), 1);
+}
+
+TEST(SessionCache, ExpiresAfterTtl) {
+    auto                now = steady_clock::now();
+    rite::session_cache cache(1024, seconds(60));
+    cache.insert("a", bytes(1), now);
+    EXPECT_TRUE(cache.find("a", now + seconds(59)).has_value());
+    EXPECT_FALSE(cache.find("a", now + seconds(60)).has_value());
+    EXPECT_EQ(cache.size(), 0);
+}
+
+TEST(SessionCache, EvictsLeastRecentlyUsed) {
+    // Two sessions per shard, three ids landing in the same shard (picked
+    // the way the cache shards them)
+    rite::session_cache      cache(2 * rite::session_cache::SHARDS, seconds(60));
+    std::vector<std::string> ids;
+    size_t                   shard = std::hash<std::string_view>{}("0") % rite::session_cache::SHARDS;
+    for (int i = 0; ids.size() < 3; ++i) {
+        std::string id = std::to_string(i);
+        if (std::hash<std::string_view>{}(id) % rite::session_cache::SHARDS == shard)
+            ids.push_back(id);
+    }
+
+    cache.insert(ids[0], bytes(0));
+    cache.insert(ids[1], bytes(1));
+    // Using the older session makes the other one least recently used
+    EXPECT_EQ(cache.find(ids[0]), bytes(0));
+    cache.insert(ids[2], bytes(2));
+
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_EQ(cache.find(ids[0]), bytes(0));
+    EXPECT_FALSE(cache.find(ids[1]).has_value());
+    EXPECT_EQ(cache.find(ids[2]), bytes(2));
+}
+
+TEST(SessionCache, ReplacesExistingIds) {
+    rite::session_cache cache(1024, seconds(60));
+    cache.insert("a", bytes(1));
+    cache.insert("a", bytes(2));
+    EXPECT_EQ(cache.find("a"), bytes(2));
+    EXPECT_EQ(cache.size(), 1);
+}
+
+TEST(TicketKeys, RotatesAndKeepsPreviousKey) {
+    auto              now = steady_clock::now();
+    rite::ticket_keys keys(seconds(60));
+    auto              first = keys.current(now);
+
+    auto found = keys.find(first.name.data(), now);
+    ASSERT_TRUE(found.has_value());
+    EXPECT_TRUE(found->second);
+
+    // Rotated, the old key still decrypts but asks for renewal
+    auto second = keys.current(now + seconds(61));
+    EXPECT_NE(first.name, second.name);
+    found = keys.find(first.name.data(), now + seconds(61));
+    ASSERT_TRUE(found.has_value());
+    EXPECT_FALSE(found->second);
+    EXPECT_EQ(found->first.aes, first.aes);
+
+    // One more rotation and it is gone
+    keys.current(now + seconds(122));
+    EXPECT_FALSE(keys.find(first.name.data(), now + seconds(122)).has_value());
+}
+
+TEST(TicketKeys, DropsStaleKeysAfterIdleIntervals) {
+    auto              now = steady_clock::now();
+    rite::ticket_keys keys(seconds(60));
+    auto              first = keys.current(now);
+    keys.current(now + seconds(300));
+    EXPECT_FALSE(keys.find(first.name.data(), now + seconds(300)).has_value());
+}
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include <protocols/h2/settings.hpp>
+
+namespace {
+std::vector<std::byte>
+payload(std::initializer_list<std::pair<uint16_t, uint32_t>> parameters) {
+    std::vector<std::byte> out;
+    for (auto [id, value] : parameters) {
+        out.push_back(static_cast<std::byte>(id >> 8));
+        out.push_back(static_cast<std::byte>(id & 0xFF));
+        for (int shift = 24; shift >= 0; shift -= 8)
+            out.push_back(static_cast<std::byte>((value >> shift) & 0xFF));
+    }
+    return out;
+}
+};
+
+TEST(Settings, Defaults) {
+    h2::settings s;
+    EXPECT_EQ(s.header_table_size, 4096);
+    EXPECT_EQ(s.max_frame_size, 16384);
+    EXPECT_EQ(s.initial_window_size, 65535);
+    EXPECT_TRUE(s.pack().empty());
+}
+
+TEST(Settings, ApplyInOrder) {
+    h2::settings s;
+    auto         p = payload({ { 0x1, 0 }, { 0x3, 100 }, { 0x4, 1 << 20 }, { 0x5, 1 << 20 }, { 0x6, 8192 }, { 0x4, 1 << 16 }, { 0xff, 7 } });
+    EXPECT_EQ(s.apply(p), h2::settings::error::eNone);
+    EXPECT_EQ(s.header_table_size, 0);
+    EXPECT_EQ(s.max_concurrent_streams, 100);
+    // The last occurrence wins, unknown parameters are ignored
+    EXPECT_EQ(s.initial_window_size, 1 << 16);
+    EXPECT_EQ(s.max_frame_size, 1 << 20);
+    EXPECT_EQ(s.max_header_list_size, 8192);
+}
+
+TEST(Settings, InvalidValues) {
+    h2::settings s;
+    EXPECT_EQ(s.apply(payload({ { 0x2, 2 } })), h2::settings::error::eProtocol);
+    EXPECT_EQ(s.apply(payload({ { 0x4, 0x80000000 } })), h2::settings::error::eFlowControl);
+    EXPECT_EQ(s.apply(payload({ { 0x5, 16383 } })), h2::settings::error::eProtocol);
+    EXPECT_EQ(s.apply(payload({ { 0x5, 1 << 24 } })), h2::settings::error::eProtocol);
+    EXPECT_EQ(s.max_frame_size, 16384);
+}
+
+TEST(Settings, PackRoundTrip) {
+    h2::settings local;
+    local.max_concurrent_streams = 128;
+    local.max_header_list_size = 65536;
+    auto packed = local.pack();
+    EXPECT_EQ(packed.size(), 12);
+
+    h2::settings peer;
+    EXPECT_EQ(peer.apply(packed), h2::settings::error::eNone);
+    EXPECT_EQ(peer.max_concurrent_streams, 128);
+    EXPECT_EQ(peer.max_header_list_size, 65536);
+}
@@ -0,0 +1,31 @@
+#include <gtest/gtest.h>
+
+#include <slot_table.hpp>
+
+TEST(SlotTable, RejectsStaleHandles) {
+    rite::slot_table<int> table(2);
+
+    auto a = table.acquire(1);
+    auto b = table.acquire(2);
+    EXPECT_TRUE(table.full());
+    EXPECT_EQ(table.acquire(3), rite::slot_table<int>::invalid);
+
+    EXPECT_TRUE(table.release(a));
+    EXPECT_FALSE(table.release(a));
+    EXPECT_EQ(table.get(a), nullptr);
+
+    // Same index, new generation
+    auto c = table.acquire(3);
+    EXPECT_EQ(c & 0xFFFFFFFF, a & 0xFFFFFFFF);
+    EXPECT_NE(c, a);
+    EXPECT_EQ(table.get(a), nullptr);
+    EXPECT_EQ(*table.get(c), 3);
+    EXPECT_EQ(*table.get(b), 2);
+    EXPECT_EQ(table.size(), 2);
+}
+
+TEST(SlotTable, InvalidHandleNeverResolves) {
+    rite::slot_table<int> table(4);
+    table.acquire(1);
+    EXPECT_EQ(table.get(rite::slot_table<int>::invalid), nullptr);
+}
@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <functional>
+#include <memory>
+
+#include <task.hpp>
+
+TEST(Task, SmallClosuresAreStoredInline) {
+    struct reactor;
+    auto readiness = [server = (void *)nullptr, client = (void *)nullptr]() {};
+    auto timer = [server = (void *)nullptr, r = (reactor *)nullptr, h = uint64_t(0)]() {};
+    EXPECT_TRUE(rite::task::fits<decltype(readiness)>);
+    EXPECT_TRUE(rite::task::fits<decltype(timer)>);
+    EXPECT_FALSE((rite::task::fits<std::array<std::byte, 256>>));
+}
+
+TEST(Task, MoveOnlyCallables) {
+    int        result = 0;
+    auto       value = std::make_unique<int>(42);
+    rite::task t = [value = std::move(value), &result]() { result = *value; };
+
+    rite::task moved = std::move(t);
+    EXPECT_FALSE(t);
+    ASSERT_TRUE(moved);
+    moved();
+    EXPECT_EQ(result, 42);
+}
+
+TEST(Task, LargeCallablesFallBackToTheHeap) {
+    std::array<int, 64> values;
+    values.fill(1);
+    int                               sum = 0;
+    rite::basic_task<void(int), 64> t = [values, &sum](int factor) {
+        for (int v : values)
+            sum += v * factor;
+    };
+
+    rite::basic_task<void(int), 64> moved;
+    moved = std::move(t);
+    moved(2);
+    EXPECT_EQ(sum, 128);
+}
+
+TEST(Task, EmptyCallables) {
+    std::function<void()> empty;
+    rite::task            t = empty;
+    EXPECT_FALSE(t);
+    EXPECT_THROW(t(), std::bad_function_call);
+
+    t = []() {};
+    EXPECT_TRUE(t);
+    t = nullptr;
+    EXPECT_FALSE(t);
+}
@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <vector>
+
+#include <timer_wheel.hpp>
+
+using namespace std::chrono;
+
+TEST(TimerWheel, FiresInDeadlineOrder) {
+    rite::timer_wheel w(milliseconds(10));
+    auto              start = rite::timer_wheel::clock::now();
+
+    std::vector<int> fired;
+    w.schedule(start + milliseconds(50), [&fired]() { fired.push_back(2); });
+    w.schedule(start + milliseconds(20), [&fired]() { fired.push_back(1); });
+    // Beyond level 0 (64 ticks), has to be cascaded down
+    w.schedule(start + seconds(5), [&fired]() { fired.push_back(3); });
+    EXPECT_EQ(w.size(), 3);
+
+    EXPECT_EQ(w.advance(start + milliseconds(10)), 0);
+    w.advance(start + milliseconds(100));
+    EXPECT_EQ(fired, (std::vector<int>{ 1, 2 }));
+
+    w.advance(start + milliseconds(4900));
+    EXPECT_EQ(fired.size(), 2);
+    w.advance(start + milliseconds(5100));
+    EXPECT_EQ(fired, (std::vector<int>{ 1, 2, 3 }));
+    EXPECT_EQ(w.size(), 0);
+    EXPECT_EQ(w.next_timeout(), -1);
+}
+
+TEST(TimerWheel, CancelRejectsStaleHandles) {
+    rite::timer_wheel w(milliseconds(10));
+    auto              start = rite::timer_wheel::clock::now();
+
+    bool fired = false;
+    auto id = w.schedule(start + milliseconds(30), [&fired]() { fired = true; });
+    EXPECT_TRUE(w.cancel(id));
+    EXPECT_FALSE(w.cancel(id));
+
+    // The slot is reused, the old handle must not cancel the new timer.
+    auto next = w.schedule(start + milliseconds(30), [&fired]() { fired = true; });
+    EXPECT_FALSE(w.cancel(id));
+    w.advance(start + milliseconds(100));
+    EXPECT_TRUE(fired);
+    EXPECT_FALSE(w.cancel(next));
+}
+
+TEST(TimerWheel, CallbacksMayReschedule) {
+    rite::timer_wheel w(milliseconds(10));
+    auto              start = rite::timer_wheel::clock::now();
+
+    int count = 0;
+    std::function<void()> tick = [&]() {
+        if (++count < 3)
+            w.schedule(start + milliseconds(100 * (count + 1)), std::function<void()>(tick));
+    };
+    w.schedule(start + milliseconds(100), std::function<void()>(tick));
+    for (int i = 1; i <= 5; ++i)
+        w.advance(start + milliseconds(110 * i));
+    EXPECT_EQ(count, 3);
+}
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+#include <sys/uio.h>
+#include <thread>
+#include <unistd.h>
+
+#include "tls_pair.hpp"
+
+namespace {
+std::span<const std::byte>
+bytes(const std::string &text) {
+    return std::span<const std::byte>(reinterpret_cast<const std::byte *>(text.data()), text.size());
+}
+
+// Spans, gather writes and files interleaved on one connection, with the
+// kernel encrypting records or without.
+void
+interleaved_writes(bool ktls) {
+    tls_pair pair(ktls);
+    ASSERT_TRUE(pair.handshaken());
+
+    std::string head = "head", middle(10000, 'm'), tail = "tail";
+    std::string file(100000, 'f');
+    for (size_t i = 0; i < file.size(); i += 997)
+        file[i] = static_cast<char>('a' + i % 26);
+    FILE *tmp = std::tmpfile();
+    ASSERT_EQ(::write(fileno(tmp), file.data(), file.size()), static_cast<ssize_t>(file.size()));
+
+    std::string small_gather = head + tail;
+    std::string large_gather = middle + middle + middle;
+    std::string expected = "hello" + small_gather + large_gather + file + "bye";
+
+    std::thread writer([&]() {
+        pair.server->write_all(bytes("hello"), 0);
+        struct iovec small[2] = {
+            { .iov_base = head.data(), .iov_len = head.size() },
+            { .iov_base = tail.data(), .iov_len = tail.size() },
+        };
+        pair.server->write_all(small, 0);
+        // Too large to be coalesced into one record
+        struct iovec large[3] = {
+            { .iov_base = middle.data(), .iov_len = middle.size() },
+            { .iov_base = middle.data(), .iov_len = middle.size() },
+            { .iov_base = middle.data(), .iov_len = middle.size() },
+        };
+        pair.server->write_all(large, 0);
+        pair.server->send_file_all(fileno(tmp), 0, file.size());
+        pair.server->write_all(bytes("bye"), 0);
+    });
+    std::string received = pair.receive(expected.size());
+    writer.join();
+    std::fclose(tmp);
+    EXPECT_EQ(received.size(), expected.size());
+    EXPECT_TRUE(received == expected);
+}
+};
+
+TEST(Tls, UserspaceEncryption) {
+    interleaved_writes(false);
+}
+
+TEST(Tls, KernelEncryption) {
+    // Hosts without the tls ULP silently keep encrypting in userspace,
+    // the writes have to come out right either way.
+    interleaved_writes(true);
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <memory>
+#include <netinet/in.h>
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <tls.hpp>
+
+// A server side connection<tls> and a blocking OpenSSL client talking to
+// it over TCP loopback (kTLS needs a TCP socket), handshake completed.
+struct tls_pair {
+    SSL_CTX                          *server_ctx = nullptr;
+    SSL_CTX                          *client_ctx = nullptr;
+    SSL                              *client = nullptr;
+    int                               client_fd = -1;
+    std::unique_ptr<connection<tls>> server;
+
+    explicit tls_pair(bool ktls, const char *alpn = nullptr) {
+        server_ctx = SSL_CTX_new(TLS_server_method());
+        client_ctx = SSL_CTX_new(TLS_client_method());
+        certify(server_ctx);
+        // As the server sets it up, writes are retried after EAGAIN
+        SSL_CTX_set_mode(server_ctx, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+#ifdef SSL_OP_ENABLE_KTLS
+        if (ktls)
+            SSL_CTX_set_options(server_ctx, SSL_OP_ENABLE_KTLS);
+#endif
+        if (alpn != nullptr) {
+            SSL_CTX_set_alpn_select_cb(server_ctx, [](SSL *, const unsigned char **out, unsigned char *outlen, const unsigned char *in, unsigned int, void *) {
+                *out = in + 1;
+                *outlen = in[0];
+                return SSL_TLSEXT_ERR_OK;
+            }, nullptr);
+        }
+
+        int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        ::bind(listener, reinterpret_cast<struct sockaddr *>(&address), sizeof(address));
+        ::listen(listener, 1);
+        ::getsockname(listener, reinterpret_cast<struct sockaddr *>(&address), &length);
+        client_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        ::connect(client_fd, reinterpret_cast<struct sockaddr *>(&address), sizeof(address));
+        int accepted = ::accept(listener, nullptr, nullptr);
+        ::close(listener);
+        fcntl(accepted, F_SETFL, fcntl(accepted, F_GETFL) | O_NONBLOCK);
+        fcntl(client_fd, F_SETFL, fcntl(client_fd, F_GETFL) | O_NONBLOCK);
+
+        server = std::make_unique<connection<tls>>(server_ctx, accepted, sockaddr_storage{}, 0);
+        client = SSL_new(client_ctx);
+        SSL_set_fd(client, client_fd);
+        if (alpn != nullptr) {
+            std::string protocols = std::string(1, static_cast<char>(std::char_traits<char>::length(alpn))) + alpn;
+            SSL_set_alpn_protos(client, reinterpret_cast<const unsigned char *>(protocols.data()), protocols.size());
+        }
+        SSL_set_connect_state(client);
+
+        // Both ends are non-blocking, take turns until both are done
+        bool client_done = false, server_done = false;
+        for (int i = 0; i < 10000 && !(client_done && server_done); ++i) {
+            if (!client_done)
+                client_done = SSL_do_handshake(client) == 1;
+            if (!server_done)
+                server_done = server->advance_handshake() == connection<void>::handshake::eDone;
+            if (!(client_done && server_done))
+                ::usleep(100);
+        }
+        // The client reads blocking from here on
+        fcntl(client_fd, F_SETFL, fcntl(client_fd, F_GETFL) & ~O_NONBLOCK);
+    }
+
+    ~tls_pair() {
+        server.reset();
+        SSL_free(client);
+        ::close(client_fd);
+        SSL_CTX_free(server_ctx);
+        SSL_CTX_free(client_ctx);
+    }
+
+    bool handshaken() const { return SSL_is_init_finished(client) && server->ssl() != nullptr && SSL_is_init_finished(server->ssl()); }
+
+    // Read exactly `length` bytes of plaintext on the client
+    std::string receive(size_t length) {
+        std::string received(length, '\0');
+        size_t      offset = 0;
+        while (offset < length) {
+            int bytes = SSL_read(client, received.data() + offset, length - offset);
+            if (bytes <= 0)
+                break;
+            offset += bytes;
+        }
+        received.resize(offset);
+        return received;
+    }
+
+    // Read plaintext on the client until the server shuts down
+    std::string receive_all() {
+        std::string received;
+        char        chunk[4096];
+        int         bytes;
+        while ((bytes = SSL_read(client, chunk, sizeof(chunk))) > 0)
+            received.append(chunk, bytes);
+        return received;
+    }
+
+    private:
+    // Self-signed certificate for a fresh P-256 key
+    static void certify(SSL_CTX *ctx) {
+        EVP_PKEY *key = EVP_EC_gen("P-256");
+        X509     *certificate = X509_new();
+        ASN1_INTEGER_set(X509_get_serialNumber(certificate), 1);
+        X509_gmtime_adj(X509_getm_notBefore(certificate), 0);
+        X509_gmtime_adj(X509_getm_notAfter(certificate), 3600);
+        X509_set_pubkey(certificate, key);
+        X509_NAME *name = X509_get_subject_name(certificate);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char *>("localhost"), -1, -1, 0);
+        X509_set_issuer_name(certificate, name);
+        X509_sign(certificate, key, EVP_sha256());
+        SSL_CTX_use_certificate(ctx, certificate);
+        SSL_CTX_use_PrivateKey(ctx, key);
+        X509_free(certificate);
+        EVP_PKEY_free(key);
+    }
+};
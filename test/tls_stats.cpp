@@ -0,0 +1,38 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+#include <tls_stats.hpp>
+
+using namespace std::chrono;
+
+TEST(TlsStats, EmptyHasNoPercentile) {
+    rite::tls_stats stats;
+    EXPECT_EQ(stats.handshakes(), 0);
+    EXPECT_EQ(stats.handshake_percentile(0.5), microseconds(0));
+}
+
+TEST(TlsStats, PercentilesAreBucketUpperBounds) {
+    rite::tls_stats stats;
+    // 90 fast (~1ms) and 10 slow (~40ms) handshakes
+    for (int i = 0; i < 90; ++i)
+        stats.handshake(microseconds(900));
+    for (int i = 0; i < 10; ++i)
+        stats.handshake(milliseconds(40));
+    stats.handshake_failed();
+
+    EXPECT_EQ(stats.handshakes(), 100);
+    EXPECT_EQ(stats.failed_handshakes(), 1);
+    EXPECT_EQ(stats.handshake_percentile(0.5), microseconds(1024));
+    EXPECT_EQ(stats.handshake_percentile(0.9), microseconds(1024));
+    EXPECT_EQ(stats.handshake_percentile(0.99), microseconds(65536));
+}
+
+TEST(TlsStats, ResumptionRate) {
+    rite::tls_stats stats;
+    EXPECT_EQ(stats.resumption_rate(), 0.0);
+    for (int i = 0; i < 4; ++i)
+        stats.handshake(microseconds(100), i == 0);
+    EXPECT_EQ(stats.resumed_handshakes(), 1);
+    EXPECT_EQ(stats.resumption_rate(), 0.25);
+}